@@ -47,15 +47,27 @@ Each ATM state encapsulates:
 This avoids complex conditional logic and makes the
 system easy to extend with new states or operations.
 
+StaticATM::Machine is the same state machine resolved at
+compile time (std::variant + overloads, no virtual calls).
+
 -----------------------------------------------------------
 KEY DESIGN DECISIONS:
-- ATMMachine owns all Account objects (simplified model)
-- ATMInventory is composed within ATMMachine
+- Accounts live in an AccountStore that many ATMMachines can
+  share; the store is sharded, each shard behind its own lock
+- Balances are integer minor units (paise) in an atomic;
+  withdraw is a CAS loop, so concurrent sessions on the same
+  account can never overdraw it
+- ATMInventory is composed within ATMMachine; it keeps notes in
+  a fixed array and finds an exact combination whenever one
+  exists (branch-and-bound, not greedy)
 - ATMState objects are shared and stateless
 - Account balance updates and cash dispensing are handled
   atomically with rollback on failure
 - User session data (card, account, operation) is cleared
   after each transaction
+- With a TransactionJournal attached, every withdrawal is an
+  appended binary record, durable (group commit) before the
+  cash comes out; restart = snapshot + replay of the tail
 
 -----------------------------------------------------------
 FAILURE SCENARIOS HANDLED:
@@ -73,12 +85,58 @@ DESIGN GOALS:
 - Readable, interview-ready low-level design
 - Easy extensibility for new operations or states
 
+-----------------------------------------------------------
+RUN:
+- ./atm          -> interactive test cases (asks for PINs/amounts)
+- ./atm --bench  -> account contention: CAS balances vs one global lock,
+                   cash dispensing: branch-and-bound vs greedy,
+                   multi-session engine: 1M scripted sessions, 1-8 workers,
+                   state dispatch: virtual ATMState vs StaticATM (variant),
+                   journal: group commit vs sync per withdrawal,
+                            restart from snapshot vs full replay
+- ./atm --load   -> JSON lines (throughput, p50/p99/p999) for
+                   N concurrent sessions: shared accounts,
+                   per-machine event cycles (flags: bench/LoadHarness.h)
+- session messages are plain cout, captured by AsyncLog so they
+  stay in order (prompts wait for it); only diagnostics use LOG_*
+  and go to stderr, so -DLOG_LEVEL=... never hides the session
+- the test cases end with a Metrics.h scrape (entries and
+  sampled dwell time per state); -DMETRICS_ENABLED=0 compiles the metrics out
+
 ===========================================================
 */
 
 #include<iostream>
 #include<unordered_map>
 #include<vector>
+#include<string>
+#include<atomic>
+#include<mutex>
+#include<shared_mutex>
+#include<thread>
+#include<chrono>
+#include<random>
+#include<functional>
+#include<algorithm>
+#include<deque>
+#include<memory>
+#include<variant>
+#include<sstream>
+#include<cstdint>
+#include<array>
+#include<condition_variable>
+#include<filesystem>
+#include<cstring>
+#include<cstddef>
+#include<cstdio>
+#include<fcntl.h>
+#include<unistd.h>
+#include<optional>
+
+#include "AsyncLog.h"
+#include "Metrics.h"
+#include "../bench/LoadHarness.h"
+#include "../common/WorkStealingPool.h"
 
 using namespace std;
 
@@ -101,32 +159,96 @@ class Card{
     }
 };
 
-class Account{
+// Money in minor units (1 rupee = 100 paise)
+typedef int64_t Money;
+const Money MINOR_PER_UNIT = 100;
+
+string formatMoney(Money amount){
+  string sign = amount < 0 ? "-" : "";
+  if(amount < 0) amount = -amount;
+  string minor = to_string(amount % MINOR_PER_UNIT);
+  return sign + to_string(amount / MINOR_PER_UNIT) + "." + (minor.size() < 2 ? "0" : "") + minor;
+}
+
+// Own cache line each, so hammering one account doesn't slow its neighbours
+class alignas(64) Account{
   private:
     string accountNumber;
-    double balance;
+    atomic<Money> balance;
   public:
-    Account(string accountNumber, double balance) : 
+    Account(string accountNumber, Money balance) : 
       accountNumber(accountNumber), balance(balance) {};
 
     string getAccountNumber(){
       return accountNumber;
     }
 
-    double getBalance(){
-      return balance;
+    Money getBalance(){
+      return balance.load(memory_order_acquire);
     }
 
-    bool withdraw(double amount){
-      if(amount <= balance){
-        balance -= amount;
-        return true;
+    // Lock-free: fails instead of going below zero, even when
+    // several sessions withdraw from the account at once
+    bool withdraw(Money amount){
+      if(amount <= 0)
+        return false;
+      Money current = balance.load(memory_order_relaxed);
+      while(current >= amount){
+        if(balance.compare_exchange_weak(current, current - amount,
+                                         memory_order_acq_rel, memory_order_relaxed))
+          return true;
       }
       return false;
     }
 
-    void deposit(double amount){
-      balance += amount;
+    void deposit(Money amount){
+      if(amount > 0)
+        balance.fetch_add(amount, memory_order_acq_rel);
+    }
+};
+
+/*
+Account lookup shared by every ATM. Lookups happen once per
+session and take a shared lock on one shard only; balance
+updates never touch the store.
+*/
+class AccountStore{
+  private:
+    static const int SHARD_COUNT = 64;
+
+    struct alignas(64) Shard{
+      shared_mutex lock;
+      unordered_map<string, Account*> accounts;
+    };
+
+    Shard shards[SHARD_COUNT];
+
+    Shard& shardFor(const string& accountNumber){
+      return shards[hash<string>()(accountNumber) % SHARD_COUNT];
+    }
+
+  public:
+    void addAccount(Account* account){
+      Shard& shard = shardFor(account->getAccountNumber());
+      unique_lock<shared_mutex> guard(shard.lock);
+      shard.accounts[account->getAccountNumber()] = account;
+    }
+
+    Account* findAccount(const string& accountNumber){
+      Shard& shard = shardFor(accountNumber);
+      shared_lock<shared_mutex> guard(shard.lock);
+      auto it = shard.accounts.find(accountNumber);
+      return it == shard.accounts.end() ? nullptr : it->second;
+    }
+
+    // fn(account) for every account, one shard locked at a time
+    template<typename Fn>
+    void forEachAccount(Fn fn){
+      for(Shard& shard : shards){
+        shared_lock<shared_mutex> guard(shard.lock);
+        for(auto& entry : shard.accounts)
+          fn(entry.second);
+      }
     }
 };
 
@@ -144,58 +266,747 @@ enum OperationType{
   BALANCE_INQUIRY
 };
 
+// Largest first; index into ATMInventory's arrays
+const CashType DENOMINATIONS[] = {
+  CashType::BILL_100,
+  CashType::BILL_50,
+  CashType::BILL_20,
+  CashType::BILL_10,
+  CashType::BILL_5,
+  CashType::BILL_1
+};
+const int DENOMINATION_COUNT = sizeof(DENOMINATIONS) / sizeof(DENOMINATIONS[0]);
+
+int denominationIndex(CashType type){
+  for(int i = 0; i < DENOMINATION_COUNT; i++)
+    if(DENOMINATIONS[i] == type)
+      return i;
+  return -1;
+}
+
+// Notes handed out for one withdrawal; empty() means it failed
+struct CashBundle{
+  int notes[DENOMINATION_COUNT] = {};
+  bool dispensed = false;
+
+  bool empty() const {
+    return !dispensed;
+  }
+
+  int count(CashType type) const {
+    int index = denominationIndex(type);
+    return index < 0 ? 0 : notes[index];
+  }
+};
+
+/*
+Notes are a fixed array indexed by denomination, with the
+total value kept up to date, so hasSufficientCash is O(1).
+
+dispenseCash runs a branch-and-bound search, largest notes
+first, so the first hit uses few notes (the greedy answer
+whenever greedy works):
+- bound: what is left must fit in the smaller notes
+- dead ends (denomination, amount left) are remembered, so
+  no state is explored twice; the search is a bounded DP in
+  the worst case and finds a combination whenever one exists
+Nothing is taken out of the inventory until a combination
+is found, so there is no rollback.
+*/
 class ATMInventory{
+  public:
+    static const int MAX_WITHDRAWAL = 10000;
+
   private:
-    unordered_map<CashType, int>cashInventory;
+    int notes[DENOMINATION_COUNT];
+    int totalCash;
+
+    // suffixValue[i] = value of all notes at index >= i
+    int suffixValue[DENOMINATION_COUNT + 1];
+
+    // (level, remaining) dead-end marks, reset by bumping the stamp
+    vector<uint32_t> deadEnds;
+    uint32_t searchStamp = 0;
+
+    void refreshSuffix(){
+      suffixValue[DENOMINATION_COUNT] = 0;
+      for(int i = DENOMINATION_COUNT - 1; i >= 0; i--)
+        suffixValue[i] = suffixValue[i + 1] + static_cast<int>(DENOMINATIONS[i]) * notes[i];
+    }
+
+    // Sized on refill, not on the withdrawal path (up to the usual
+    // withdrawal limit; a bigger amount grows it on demand)
+    void reserveSearch(int amount = MAX_WITHDRAWAL){
+      size_t states = (size_t)DENOMINATION_COUNT * (min(amount, totalCash) + 1);
+      if(deadEnds.size() < states)
+        deadEnds.resize(states, 0);
+    }
+
+    bool search(int level, int remaining, int amount, int picked[]){
+      if(remaining == 0)
+        return true;
+      if(level == DENOMINATION_COUNT || remaining > suffixValue[level])
+        return false;
+
+      uint32_t& mark = deadEnds[(size_t)level * (amount + 1) + remaining];
+      if(mark == searchStamp)
+        return false;
+
+      int value = static_cast<int>(DENOMINATIONS[level]);
+      int most = min(notes[level], remaining / value);
+      int shortfall = remaining - suffixValue[level + 1];
+      int least = shortfall > 0 ? (shortfall + value - 1) / value : 0;
+
+      for(int count = most; count >= least; count--){
+        picked[level] = count;
+        if(search(level + 1, remaining - count * value, amount, picked))
+          return true;
+      }
+      picked[level] = 0;
+      mark = searchStamp;
+      return false;
+    }
 
   public:
     ATMInventory(){
-      cashInventory[CashType::BILL_100] = 10;
-      cashInventory[CashType::BILL_50] = 10;
-      cashInventory[CashType::BILL_20] = 20;
-      cashInventory[CashType::BILL_10] = 30;
-      cashInventory[CashType::BILL_5] = 20;
-      cashInventory[CashType::BILL_1] = 50;
+      int initial[DENOMINATION_COUNT] = {10, 10, 20, 30, 20, 50};
+      totalCash = 0;
+      for(int i = 0; i < DENOMINATION_COUNT; i++){
+        notes[i] = initial[i];
+        totalCash += static_cast<int>(DENOMINATIONS[i]) * notes[i];
+      }
+      refreshSuffix();
+      reserveSearch();
     }
 
     bool hasSufficientCash(int amount){
-      int value = 0;
-      for(auto it : cashInventory)
-        value += static_cast<int>(it.first) * it.second;
-      return value >= amount;
+      return totalCash >= amount;
+    }
+
+    int getTotalCash(){
+      return totalCash;
     }
 
-    unordered_map<CashType, int> dispenseCash(int amount){
+    int getNoteCount(CashType type){
+      int index = denominationIndex(type);
+      return index < 0 ? 0 : notes[index];
+    }
+
+    // Refill or set the stock of one denomination
+    void setNoteCount(CashType type, int count){
+      int index = denominationIndex(type);
+      if(index < 0 || count < 0)
+        return;
+      totalCash += static_cast<int>(type) * (count - notes[index]);
+      notes[index] = count;
+      refreshSuffix();
+      reserveSearch();
+    }
 
-      unordered_map<CashType, int>dispensed;
+    CashBundle dispenseCash(int amount){
+      CashBundle bundle;
+      if(amount <= 0 || amount > totalCash)
+        return bundle;
+
+      reserveSearch(amount);
+      if(++searchStamp == 0){
+        fill(deadEnds.begin(), deadEnds.end(), 0);
+        searchStamp = 1;
+      }
+
+      if(!search(0, amount, amount, bundle.notes))
+        return bundle;
+
+      for(int i = 0; i < DENOMINATION_COUNT; i++)
+        notes[i] -= bundle.notes[i];
+      totalCash -= amount;
+      refreshSuffix();
+      bundle.dispensed = true;
+      return bundle;
+    }
+
+    // Reference: the old largest-first greedy, which gives up when
+    // limited notes need a non-greedy mix (kept for comparison)
+    CashBundle dispenseCashGreedy(int amount){
+      CashBundle bundle;
       int remaining = amount;
+      for(int i = 0; i < DENOMINATION_COUNT; i++){
+        int value = static_cast<int>(DENOMINATIONS[i]);
+        bundle.notes[i] = min(remaining / value, notes[i]);
+        remaining -= bundle.notes[i] * value;
+      }
+      if(amount <= 0 || remaining > 0)
+        return CashBundle();
+
+      for(int i = 0; i < DENOMINATION_COUNT; i++)
+        notes[i] -= bundle.notes[i];
+      totalCash -= amount;
+      refreshSuffix();
+      bundle.dispensed = true;
+      return bundle;
+    }
+};
+
+/*
+===========================================================
+ TRANSACTION JOURNAL (event sourcing)
+===========================================================
+Balances and note counts otherwise live only in memory. The
+journal makes them durable:
+- every change is a fixed-size binary record appended to
+  <dir>/<first sequence>.journal (account opened, withdrawal,
+  machine stocked); nothing is ever rewritten in place
+- appends only copy the record into a pending batch; a
+  flusher thread writes the whole batch with one write() and
+  one fdatasync() (group commit), so many sessions share the
+  cost of one sync
+- awaitDurable(sequence) blocks until that record is on disk;
+  a withdrawal waits for it before the cash comes out
+- the journal folds every record into a JournalState, so
+  snapshot() can write the full state (balances + notes) at a
+  sequence number and delete the segments it covers
+- startup = load the snapshot, seek past the records it
+  covers and replay the rest; the first torn or corrupt
+  record marks the end
+
+Record layout (64 bytes, one cache line):
+  [u64 sequence][u32 checksum][u8 type][u8 pad][u16 machine]
+  [char account[16]][i64 amount][i32 notes[6]]
+*/
+
+enum JournalRecordType : uint8_t{
+  JOURNAL_OPEN_ACCOUNT = 1,   // amount = opening balance
+  JOURNAL_WITHDRAWAL = 2,     // amount + notes left the machine
+  JOURNAL_STOCK = 3           // notes = machine's new note counts
+};
+
+const int JOURNAL_ACCOUNT_LENGTH = 16;
+
+struct JournalRecord{
+  uint64_t sequence;
+  uint32_t checksum;
+  uint8_t type;
+  uint8_t pad;
+  uint16_t machineId;
+  char accountNumber[JOURNAL_ACCOUNT_LENGTH];
+  Money amount;
+  int32_t notes[DENOMINATION_COUNT];
+
+  // FNV-1a of everything after the checksum
+  uint32_t computeChecksum() const {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(this);
+    uint32_t hash = 2166136261u;
+    for(size_t i = offsetof(JournalRecord, type); i < sizeof(JournalRecord); i++)
+      hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+  }
+
+  string getAccountNumber() const {
+    return string(accountNumber, strnlen(accountNumber, JOURNAL_ACCOUNT_LENGTH));
+  }
+};
+static_assert(sizeof(JournalRecord) == 64, "journal records are one cache line");
+
+typedef array<int, DENOMINATION_COUNT> NoteCounts;
+
+// What replaying the journal from the very first record gives
+struct JournalState{
+  uint64_t nextSequence = 0;
+  unordered_map<string, Money> balances;
+  unordered_map<uint16_t, NoteCounts> machines;
+
+  void apply(const JournalRecord& record){
+    switch(record.type){
+      case JOURNAL_OPEN_ACCOUNT:
+        balances[record.getAccountNumber()] = record.amount;
+        break;
+      case JOURNAL_WITHDRAWAL: {
+        balances[record.getAccountNumber()] -= record.amount;
+        NoteCounts& notes = machines[record.machineId];
+        for(int i = 0; i < DENOMINATION_COUNT; i++)
+          notes[i] -= record.notes[i];
+        break;
+      }
+      case JOURNAL_STOCK: {
+        NoteCounts& notes = machines[record.machineId];
+        for(int i = 0; i < DENOMINATION_COUNT; i++)
+          notes[i] = record.notes[i];
+        break;
+      }
+    }
+    nextSequence = record.sequence + 1;
+  }
+};
+
+class TransactionJournal{
+  public:
+    static const size_t SEGMENT_RECORDS = 1 << 20;   // 64 MB per file
 
-      CashType order[] = {
-        CashType::BILL_100,
-        CashType::BILL_50,
-        CashType::BILL_20,
-        CashType::BILL_10,
-        CashType::BILL_5,
-        CashType::BILL_1
-      };
-
-      for(CashType type : order){
-        int value = static_cast<int>(type);
-        int count = min(remaining/value, cashInventory[type]);
-
-        if(count > 0){
-          dispensed[type] = count;
-          remaining -= count * value;
-          cashInventory[type] -= count;
+  private:
+    // Snapshot file: header, then the balances, then the machines
+    struct SnapshotHeader{
+      uint64_t magic;
+      uint64_t nextSequence;
+      uint32_t accountCount;
+      uint32_t machineCount;
+      uint32_t checksum;        // FNV-1a of the body
+      uint32_t pad;
+    };
+    struct SnapshotAccount{
+      char accountNumber[JOURNAL_ACCOUNT_LENGTH];
+      Money balance;
+    };
+    struct SnapshotMachine{
+      uint16_t machineId;
+      uint16_t pad;
+      int32_t notes[DENOMINATION_COUNT];
+    };
+    static const uint64_t SNAPSHOT_MAGIC = 0x32504e5352544d41ull;   // "ATMRSNP2"
+
+    string dir;
+    chrono::microseconds flushInterval;
+
+    mutex appendMtx;
+    JournalState state;                 // folded over every appended record
+    vector<JournalRecord> pending;      // appended, not yet written
+
+    // Owned by the flusher after open()
+    int fd = -1;
+    size_t activeRecords = 0;           // records in the active segment
+    vector<JournalRecord> writing;
+
+    thread flusher;
+    mutex flushMtx;
+    condition_variable flushRequested;
+    condition_variable flushed;
+    bool running = true;
+    bool syncWanted = false;
+    atomic<uint64_t> durableSequence{0};   // every sequence below is on disk
+    atomic<uint64_t> syncCount{0};
+    uint64_t replayedRecords = 0;
+
+    // FNV-1a; pass the previous result as `hash` to continue it
+    static uint32_t checksum(const void* data, size_t size, uint32_t hash = 2166136261u){
+      const unsigned char* bytes = static_cast<const unsigned char*>(data);
+      for(size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+      return hash;
+    }
+
+    // Covers the header fields (sequence, counts) as well as the body
+    static uint32_t snapshotChecksum(const SnapshotHeader& header,
+                                     const vector<SnapshotAccount>& accounts,
+                                     const vector<SnapshotMachine>& machines){
+      uint32_t hash = checksum(&header.nextSequence, sizeof(header.nextSequence));
+      hash = checksum(&header.accountCount, sizeof(header.accountCount), hash);
+      hash = checksum(&header.machineCount, sizeof(header.machineCount), hash);
+      hash = checksum(accounts.data(), accounts.size() * sizeof(SnapshotAccount), hash);
+      return checksum(machines.data(), machines.size() * sizeof(SnapshotMachine), hash);
+    }
+
+    static string segmentName(uint64_t firstSequence){
+      string digits = to_string(firstSequence);
+      return string(20 - digits.size(), '0') + digits + ".journal";
+    }
+
+    string snapshotPath() const {
+      return dir + "/snapshot.bin";
+    }
+
+    // A new or renamed file is only durable once its directory is
+    void syncDirectory(){
+      int dirFd = ::open(dir.c_str(), O_RDONLY);
+      if(dirFd >= 0){
+        fsync(dirFd);
+        close(dirFd);
+      }
+    }
+
+    static void writeAll(int fd, const void* data, size_t size){
+      const char* bytes = static_cast<const char*>(data);
+      while(size > 0){
+        ssize_t written = ::write(fd, bytes, size);
+        if(written < 0){
+          cerr << "[FATAL] Journal write failed" << endl;
+          abort();
         }
+        bytes += written;
+        size -= written;
+      }
+    }
+
+    void openSegment(uint64_t firstSequence){
+      if(fd >= 0){
+        fdatasync(fd);
+        close(fd);
+      }
+      string path = dir + "/" + segmentName(firstSequence);
+      fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+      if(fd < 0){
+        cerr << "[FATAL] Cannot open journal segment " << path << endl;
+        abort();
+      }
+      activeRecords = 0;
+      syncDirectory();
+    }
+
+    bool loadSnapshot(){
+      FILE* file = fopen(snapshotPath().c_str(), "rb");
+      if(!file)
+        return false;
+
+      SnapshotHeader header;
+      vector<SnapshotAccount> accounts;
+      vector<SnapshotMachine> machines;
+      fseek(file, 0, SEEK_END);
+      long size = ftell(file);
+      rewind(file);
+      bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == SNAPSHOT_MAGIC &&
+                (uint64_t)size == sizeof(header) + (uint64_t)header.accountCount * sizeof(SnapshotAccount)
+                                  + (uint64_t)header.machineCount * sizeof(SnapshotMachine);
+      if(ok){
+        accounts.resize(header.accountCount);
+        machines.resize(header.machineCount);
+        ok = fread(accounts.data(), sizeof(SnapshotAccount), accounts.size(), file) == accounts.size() &&
+             fread(machines.data(), sizeof(SnapshotMachine), machines.size(), file) == machines.size();
+      }
+      fclose(file);
+
+      if(ok)
+        ok = snapshotChecksum(header, accounts, machines) == header.checksum;
+      if(!ok){
+        LOG_WARN("[WARN] Ignoring corrupt journal snapshot");
+        return false;
       }
 
-      if(remaining > 0){
-        for(auto type : dispensed)
-          cashInventory[type.first] += type.second;
-        return {};
+      for(auto& account : accounts)
+        state.balances[string(account.accountNumber, strnlen(account.accountNumber, JOURNAL_ACCOUNT_LENGTH))] = account.balance;
+      for(auto& machine : machines){
+        NoteCounts& notes = state.machines[machine.machineId];
+        for(int i = 0; i < DENOMINATION_COUNT; i++)
+          notes[i] = machine.notes[i];
       }
-      return dispensed;
+      state.nextSequence = header.nextSequence;
+      return true;
+    }
+
+    /*
+     Snapshot, then every valid record after it. Segments wholly
+     before the snapshot are skipped unread; a torn tail is cut
+     off so new records follow the last good one.
+    */
+    void open(){
+      filesystem::create_directories(dir);
+      bool fromSnapshot = loadSnapshot();
+
+      vector<uint64_t> bases;
+      for(auto& entry : filesystem::directory_iterator(dir))
+        if(entry.path().extension() == ".journal")
+          bases.push_back(stoull(entry.path().stem().string()));
+      sort(bases.begin(), bases.end());
+
+      if(!fromSnapshot && !bases.empty() && bases[0] != 0){
+        cerr << "[FATAL] Journal history is missing its snapshot" << endl;
+        abort();
+      }
+
+      vector<JournalRecord> chunk(4096);
+      bool torn = false;
+      bool haveActive = false;
+      uint64_t activeBase = 0;
+      size_t activeValid = 0;
+      for(size_t s = 0; s < bases.size(); s++){
+        string path = dir + "/" + segmentName(bases[s]);
+        if(torn){
+          filesystem::remove(path);      // after a gap: unreachable
+          continue;
+        }
+        if(s + 1 < bases.size() && bases[s + 1] <= state.nextSequence)
+          continue;                      // wholly inside the snapshot
+
+        // Fixed-size records: seek straight past the ones the snapshot has
+        int readFd = ::open(path.c_str(), O_RDONLY);
+        uint64_t expected = bases[s];
+        size_t valid = 0;
+        if(state.nextSequence > expected){
+          size_t covered = state.nextSequence - expected;
+          off_t size = lseek(readFd, 0, SEEK_END);
+          if(size >= (off_t)(covered * sizeof(JournalRecord))){
+            expected += covered;
+            valid = covered;
+            lseek(readFd, valid * sizeof(JournalRecord), SEEK_SET);
+          }
+          else{
+            torn = true;                 // shorter than the snapshot says
+          }
+        }
+        ssize_t got;
+        while(!torn && (got = ::read(readFd, chunk.data(), chunk.size() * sizeof(JournalRecord))) > 0){
+          size_t count = got / sizeof(JournalRecord);
+          for(size_t i = 0; i < count && !torn; i++){
+            const JournalRecord& record = chunk[i];
+            if(record.sequence != expected || record.checksum != record.computeChecksum()){
+              torn = true;
+              break;
+            }
+            state.apply(record);
+            replayedRecords++;
+            expected++;
+            valid++;
+          }
+          if((size_t)got % sizeof(JournalRecord) != 0)
+            torn = true;
+        }
+        close(readFd);
+
+        if(expected < state.nextSequence){
+          filesystem::remove(path);      // damaged before the snapshot point
+          torn = true;
+          continue;
+        }
+        if(truncate(path.c_str(), valid * sizeof(JournalRecord)) != 0){
+          cerr << "[FATAL] Cannot trim journal segment " << path << endl;
+          abort();
+        }
+        haveActive = true;
+        activeBase = bases[s];
+        activeValid = valid;
+      }
+
+      openSegment(haveActive ? activeBase : state.nextSequence);
+      activeRecords = haveActive ? activeValid : 0;
+      durableSequence.store(state.nextSequence);
+    }
+
+    void append(JournalRecord& record, uint64_t& sequence){
+      lock_guard<mutex> lock(appendMtx);
+      record.sequence = sequence = state.nextSequence;
+      record.checksum = record.computeChecksum();
+      state.apply(record);
+      pending.push_back(record);
+    }
+
+    // One write() per segment touched, one fdatasync() per batch
+    void flushNow(){
+      {
+        lock_guard<mutex> lock(appendMtx);
+        writing.swap(pending);
+      }
+      if(writing.empty())
+        return;
+
+      size_t done = 0;
+      while(done < writing.size()){
+        if(activeRecords == SEGMENT_RECORDS)
+          openSegment(writing[done].sequence);
+        size_t count = min(writing.size() - done, SEGMENT_RECORDS - activeRecords);
+        writeAll(fd, &writing[done], count * sizeof(JournalRecord));
+        activeRecords += count;
+        done += count;
+      }
+      fdatasync(fd);
+      syncCount.fetch_add(1, memory_order_relaxed);
+
+      uint64_t target = writing.back().sequence + 1;
+      writing.clear();
+
+      lock_guard<mutex> lock(flushMtx);
+      durableSequence.store(target);
+      flushed.notify_all();
+    }
+
+    void flushLoop(){
+      unique_lock<mutex> lock(flushMtx);
+      while(running){
+        flushRequested.wait_for(lock, flushInterval, [this](){ return !running || syncWanted; });
+        syncWanted = false;
+        lock.unlock();
+        flushNow();
+        lock.lock();
+      }
+      lock.unlock();
+      flushNow();
+    }
+
+    static JournalRecord blankRecord(JournalRecordType type, uint16_t machineId, const string& accountNumber){
+      JournalRecord record;
+      memset(&record, 0, sizeof(record));
+      record.type = type;
+      record.machineId = machineId;
+      memcpy(record.accountNumber, accountNumber.data(),
+             min(accountNumber.size(), (size_t)JOURNAL_ACCOUNT_LENGTH));
+      return record;
+    }
+
+  public:
+    TransactionJournal(const string& dir,
+                       chrono::microseconds flushInterval = chrono::milliseconds(2))
+      : dir(dir), flushInterval(flushInterval) {
+      open();
+      flusher = thread(&TransactionJournal::flushLoop, this);
+    }
+
+    ~TransactionJournal(){
+      {
+        lock_guard<mutex> lock(flushMtx);
+        running = false;
+        flushRequested.notify_one();
+      }
+      flusher.join();
+      close(fd);
+    }
+
+    TransactionJournal(const TransactionJournal&) = delete;
+    TransactionJournal& operator=(const TransactionJournal&) = delete;
+
+    // Each returns the record's sequence number; durable within ~flushInterval
+    uint64_t recordOpenAccount(const string& accountNumber, Money balance){
+      JournalRecord record = blankRecord(JOURNAL_OPEN_ACCOUNT, 0, accountNumber);
+      record.amount = balance;
+      uint64_t sequence;
+      append(record, sequence);
+      return sequence;
+    }
+
+    uint64_t recordWithdrawal(uint16_t machineId, const string& accountNumber,
+                              Money amount, const CashBundle& cash){
+      JournalRecord record = blankRecord(JOURNAL_WITHDRAWAL, machineId, accountNumber);
+      record.amount = amount;
+      for(int i = 0; i < DENOMINATION_COUNT; i++)
+        record.notes[i] = cash.notes[i];
+      uint64_t sequence;
+      append(record, sequence);
+      return sequence;
+    }
+
+    uint64_t recordStock(uint16_t machineId, const NoteCounts& notes){
+      JournalRecord record = blankRecord(JOURNAL_STOCK, machineId, "");
+      for(int i = 0; i < DENOMINATION_COUNT; i++)
+        record.notes[i] = notes[i];
+      uint64_t sequence;
+      append(record, sequence);
+      return sequence;
+    }
+
+    // Blocks until sequence is on disk; concurrent callers share one sync
+    void awaitDurable(uint64_t sequence){
+      unique_lock<mutex> lock(flushMtx);
+      while(durableSequence.load() <= sequence){
+        syncWanted = true;
+        flushRequested.notify_one();
+        flushed.wait(lock);
+      }
+    }
+
+    /*
+     Writes the folded state at the current sequence (temp file,
+     fsync, rename: a crash leaves the old or the new snapshot,
+     never half of one), then deletes segments it fully covers.
+     Appends continue meanwhile; they land after the snapshot.
+    */
+    void snapshot(){
+      JournalState copy;
+      {
+        lock_guard<mutex> lock(appendMtx);
+        copy = state;
+      }
+      if(copy.nextSequence > 0)
+        awaitDurable(copy.nextSequence - 1);   // never ahead of the log
+
+      vector<SnapshotAccount> accounts;
+      for(auto& balance : copy.balances){
+        SnapshotAccount account;
+        memset(&account, 0, sizeof(account));
+        memcpy(account.accountNumber, balance.first.data(),
+               min(balance.first.size(), (size_t)JOURNAL_ACCOUNT_LENGTH));
+        account.balance = balance.second;
+        accounts.push_back(account);
+      }
+      vector<SnapshotMachine> machines;
+      for(auto& machine : copy.machines){
+        SnapshotMachine entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.machineId = machine.first;
+        for(int i = 0; i < DENOMINATION_COUNT; i++)
+          entry.notes[i] = machine.second[i];
+        machines.push_back(entry);
+      }
+
+      SnapshotHeader header;
+      memset(&header, 0, sizeof(header));
+      header.magic = SNAPSHOT_MAGIC;
+      header.nextSequence = copy.nextSequence;
+      header.accountCount = (uint32_t)accounts.size();
+      header.machineCount = (uint32_t)machines.size();
+      header.checksum = snapshotChecksum(header, accounts, machines);
+
+      string temp = snapshotPath() + ".tmp";
+      int snapFd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if(snapFd < 0){
+        cerr << "[FATAL] Cannot write journal snapshot" << endl;
+        abort();
+      }
+      writeAll(snapFd, &header, sizeof(header));
+      writeAll(snapFd, accounts.data(), accounts.size() * sizeof(SnapshotAccount));
+      writeAll(snapFd, machines.data(), machines.size() * sizeof(SnapshotMachine));
+      fsync(snapFd);
+      close(snapFd);
+      rename(temp.c_str(), snapshotPath().c_str());
+      syncDirectory();
+
+      // Segment i covers [base i, base i+1): drop it once all of that is in the snapshot
+      vector<uint64_t> bases;
+      for(auto& entry : filesystem::directory_iterator(dir))
+        if(entry.path().extension() == ".journal")
+          bases.push_back(stoull(entry.path().stem().string()));
+      sort(bases.begin(), bases.end());
+      for(size_t i = 0; i + 1 < bases.size(); i++)
+        if(bases[i + 1] <= copy.nextSequence)
+          filesystem::remove(dir + "/" + segmentName(bases[i]));
+    }
+
+    JournalState getState(){
+      lock_guard<mutex> lock(appendMtx);
+      return state;
+    }
+
+    bool knowsAccount(const string& accountNumber){
+      lock_guard<mutex> lock(appendMtx);
+      return state.balances.count(accountNumber) > 0;
+    }
+
+    bool knowsMachine(uint16_t machineId){
+      lock_guard<mutex> lock(appendMtx);
+      return state.machines.count(machineId) > 0;
+    }
+
+    NoteCounts getMachineNotes(uint16_t machineId){
+      lock_guard<mutex> lock(appendMtx);
+      return state.machines[machineId];
+    }
+
+    // Recreates the recovered accounts in a store (caller owns them)
+    vector<Account*> restoreAccounts(AccountStore& store){
+      vector<Account*> restored;
+      lock_guard<mutex> lock(appendMtx);
+      for(auto& balance : state.balances){
+        restored.push_back(new Account(balance.first, balance.second));
+        store.addAccount(restored.back());
+      }
+      return restored;
+    }
+
+    uint64_t endSequence(){
+      lock_guard<mutex> lock(appendMtx);
+      return state.nextSequence;
+    }
+
+    uint64_t getReplayedRecords() const {
+      return replayedRecords;
+    }
+
+    uint64_t getSyncCount() const {
+      return syncCount.load();
     }
 };
 
@@ -203,7 +1014,8 @@ class ATMState;
 
 class ATMMachine{
   private:
-    unordered_map<string, Account*>accounts;
+    AccountStore ownAccounts;
+    AccountStore* accounts;
 
     ATMState* currentState;
 
@@ -218,9 +1030,37 @@ class ATMMachine{
     Account* currentAccount;
     OperationType currentOperation;
 
+    TransactionJournal* journal = nullptr;
+    uint16_t machineId = 0;
+
+    // Entries and dwell per state, in StaticATM's variant order:
+    // Idle, HasCard, PinValidation, SelectOperation, Transaction.
+    // A clock read costs more than a transition, so entries are
+    // exact but only every DWELL_SAMPLE_EVERY-th dwell in each state
+    // is timed. The count is per state: one shared counter would, for
+    // a session cycle whose length divides 16, time the same state
+    // every time and never the others.
+    static const int STATE_COUNT = 5;
+    static const uint32_t DWELL_SAMPLE_EVERY = 16;
+    int stateIndex = 0;
+    uint32_t sampled[STATE_COUNT] = {};
+    bool dwellTimed = true;
+    uint64_t enteredAtNs = 0;
+    Metrics::Counter* stateEntries[STATE_COUNT];
+    Metrics::Histogram* stateDwellNs[STATE_COUNT];
+
+    int indexOf(ATMState* state){
+      if(state == hasCardState) return 1;
+      if(state == pinValidationState) return 2;
+      if(state == selectOperationState) return 3;
+      if(state == transactionState) return 4;
+      return 0;
+    }
+
   public:
     //GETTERS
     ATMMachine();
+    ATMMachine(AccountStore* sharedAccounts);
 
     ATMState* getCurrentState(){
       return currentState;
@@ -268,20 +1108,37 @@ class ATMMachine{
     }
 
     bool loadAccountFromCard(){
-      string accNo = currentCard->getAccountNumber();
-      if(accounts.count(accNo)){
-        currentAccount = accounts[accNo];
+      Account* account = accounts->findAccount(currentCard->getAccountNumber());
+      if(account){
+        currentAccount = account;
         return true;
       }
       return false;
     }
 
     void addAccount(Account* account){
-      accounts[account->getAccountNumber()] = account;
+      accounts->addAccount(account);
     }
 
     void setCurrentState(ATMState* state){
       currentState = state;
+      enterState(indexOf(state));
+    }
+
+    // Counts the move and closes a timed dwell; self-loops are not a move
+    void enterState(int index){
+      if(!METRICS_ENABLED || index == stateIndex)
+        return;
+      stateEntries[index]->inc();
+      uint64_t now = 0;
+      if(dwellTimed){
+        now = Metrics::nowNs();
+        stateDwellNs[stateIndex]->record(now - enteredAtNs);
+      }
+      dwellTimed = ++sampled[index] % DWELL_SAMPLE_EVERY == 0;
+      if(dwellTimed)
+        enteredAtNs = now ? now : Metrics::nowNs();
+      stateIndex = index;
     }
 
     void setOperation(OperationType operation){
@@ -292,8 +1149,122 @@ class ATMMachine{
       currentCard = nullptr;
       currentAccount = nullptr;
     }
+
+    /*
+     From now on every withdrawal is journaled before the cash
+     comes out. Accounts added before the journal was attached
+     are recorded as opened (otherwise replay would apply their
+     withdrawals to a zero balance). A machine the journal
+     already knows gets its recovered note counts; a new one has
+     its stock recorded.
+    */
+    void attachJournal(TransactionJournal* sharedJournal, uint16_t id){
+      journal = sharedJournal;
+      machineId = id;
+      bool opened = false;
+      uint64_t lastOpen = 0;
+      accounts->forEachAccount([&](Account* account){
+        if(!journal->knowsAccount(account->getAccountNumber())){
+          lastOpen = journal->recordOpenAccount(account->getAccountNumber(), account->getBalance());
+          opened = true;
+        }
+      });
+      if(opened)
+        journal->awaitDurable(lastOpen);
+      if(journal->knowsMachine(id)){
+        NoteCounts notes = journal->getMachineNotes(id);
+        for(int i = 0; i < DENOMINATION_COUNT; i++)
+          inventory.setNoteCount(DENOMINATIONS[i], notes[i]);
+      }
+      else{
+        recordStock();
+      }
+    }
+
+    // Call after changing note counts through getInventory()
+    void recordStock(){
+      if(!journal)
+        return;
+      NoteCounts notes;
+      for(int i = 0; i < DENOMINATION_COUNT; i++)
+        notes[i] = inventory.getNoteCount(DENOMINATIONS[i]);
+      journal->awaitDurable(journal->recordStock(machineId, notes));
+    }
+
+    // Session steps shared by the ATMState classes and StaticATM
+    enum PinResult{ PIN_OK, PIN_WRONG, PIN_NO_ACCOUNT };
+    PinResult enterPin(OperationType operation);
+    bool executeTransaction();    // true = session done, back to idle
 };
 
+// Reads the PIN, loads the account and records the operation
+ATMMachine::PinResult ATMMachine::enterPin(OperationType operation){
+  int PIN;
+  cout<<"Enter PIN : ";
+  cin>>PIN;
+
+  if(!currentCard->validatePin(PIN))
+    return PIN_WRONG;
+  if(!loadAccountFromCard()){
+    cout<<"Account Not Found"<<endl;
+    return PIN_NO_ACCOUNT;
+  }
+  setOperation(operation);
+  return PIN_OK;
+}
+
+// Runs the selected operation; false = stays in the transaction
+bool ATMMachine::executeTransaction(){
+  OperationType type = currentOperation;
+
+  if (type == OperationType::WITHDRAW) {
+    int amount = 0;
+    cout << "Enter Amount To Withdraw : ";
+    cin >> amount;
+
+    Account* account = currentAccount;
+    Money amountMinor = (Money)amount * MINOR_PER_UNIT;
+
+    if (account->getBalance() < amountMinor) {
+        cout << "Insufficient Balance in Your Account" << endl;
+        return false;
+    }
+
+    if (!inventory.hasSufficientCash(amount)) {
+        cout << "Not Sufficient Cash in Inventory" << endl;
+        return false;
+    }
+
+    // Another session may have drained the account since the check
+    if (!account->withdraw(amountMinor)) {
+        cout << "Insufficient Balance in Your Account" << endl;
+        return false;
+    }
+
+    auto cash = inventory.dispenseCash(amount);
+    if (cash.empty()) {
+        cout << "Cannot Dispense Exact Amount" << endl;
+        account->deposit(amountMinor);   // rollback
+        return false;
+    }
+
+    // Durable before the notes leave the machine
+    if (journal)
+        journal->awaitDurable(journal->recordWithdrawal(machineId,
+            account->getAccountNumber(), amountMinor, cash));
+
+    cout << "Cash Dispensed Successfully" << endl;
+  }
+  else if (type == OperationType::BALANCE_INQUIRY) {
+      cout << "Current Balance : "
+          << formatMoney(currentAccount->getBalance())
+          << endl;
+  }
+
+  clearSession();
+  return true;
+}
+
 class ATMState{
   public:
     ~ATMState(){};
@@ -371,20 +1342,11 @@ class PinValidationState : public ATMState{
     }
 
     ATMState* selectOperation(ATMMachine* state, OperationType &operation) override {
-      int PIN;
-      cout<<"Enter PIN : ";
-      cin>>PIN;
-
-      if(state->getCurrentCard()->validatePin(PIN)){
-        if(!state->loadAccountFromCard()){
-          cout<<"Account Not Found"<<endl;
-          return state->getIdleState();
-        }
-        state->setOperation(operation);
-        return state->getSelectOperationState();
+      switch(state->enterPin(operation)){
+        case ATMMachine::PIN_OK: return state->getSelectOperationState();
+        case ATMMachine::PIN_NO_ACCOUNT: return state->getIdleState();
+        default: return this;
       }
-
-      return this;
     }
 
     ATMState* transactionState(ATMMachine* state) override {
@@ -443,44 +1405,7 @@ class TransactionState : public ATMState{
     }
 
     ATMState* transactionState(ATMMachine* state) override {
-      OperationType type = state->getCurrentOperation();
-
-      if (type == OperationType::WITHDRAW) {
-        int amount = 0;
-        cout << "Enter Amount To Withdraw : ";
-        cin >> amount;
-
-        Account* account = state->getCurrentAccount();
-
-        if (account->getBalance() < amount) {
-            cout << "Insufficient Balance in Your Account" << endl;
-            return this;
-        }
-
-        if (!state->getInventory().hasSufficientCash(amount)) {
-            cout << "Not Sufficient Cash in Inventory" << endl;
-            return this;
-        }
-
-        account->withdraw(amount);
-
-        auto cash = state->getInventory().dispenseCash(amount);
-        if (cash.empty()) {
-            cout << "Cannot Dispense Exact Amount" << endl;
-            account->deposit(amount);   // rollback
-            return this;
-        }
-
-        cout << "Cash Dispensed Successfully" << endl;
-      }
-      else if (type == OperationType::BALANCE_INQUIRY) {
-          cout << "Current Balance : "
-              << state->getCurrentAccount()->getBalance()
-              << endl;
-      }
-
-      state->clearSession();
-      return state->getIdleState();
+      return state->executeTransaction() ? state->getIdleState() : this;
     }
 
     string getStateName() override {
@@ -488,7 +1413,12 @@ class TransactionState : public ATMState{
     }
 };
 
-ATMMachine::ATMMachine(){
+ATMMachine::ATMMachine() : ATMMachine(nullptr) {}
+
+// nullptr = use this machine's own store
+ATMMachine::ATMMachine(AccountStore* sharedAccounts){
+  accounts = sharedAccounts ? sharedAccounts : &ownAccounts;
+
   idleState = new IdleState();
   hasCardState = new HasCardState();
   pinValidationState = new PinValidationState();
@@ -498,9 +1428,1034 @@ ATMMachine::ATMMachine(){
   currentState = idleState;
   currentCard = nullptr;
   currentAccount = nullptr;
+
+  static const char* STATE_LABELS[STATE_COUNT] = {
+    "state=\"idle\"", "state=\"has_card\"", "state=\"pin_validation\"",
+    "state=\"select_operation\"", "state=\"transaction\""};
+  for(int i = 0; i < STATE_COUNT; i++){
+    stateEntries[i] = &Metrics::counter("atm_state_entries_total", "Transitions into each state", STATE_LABELS[i]);
+    stateDwellNs[i] = &Metrics::histogram("atm_state_dwell_ns", "Time spent in a state before leaving it (sampled)", STATE_LABELS[i]);
+  }
+  enteredAtNs = Metrics::nowNs();
 };
 
-int main() {
+/*
+===========================================================
+ COMPILE-TIME STATE MACHINE
+===========================================================
+StaticATM::Machine is the same flow as the ATMState classes,
+with the transitions fixed at compile time:
+- states are empty tags in a std::variant (no heap objects)
+- each event is an overload set, one overload per state;
+  the generic template is the "stay put" default
+- std::visit picks the overload with a jump on the variant
+  index, no virtual call
+Session data, accounts and cash still live in the ATMMachine
+passed in, and the PIN / withdrawal steps are the same
+ATMMachine::enterPin / executeTransaction the classes use.
+*/
+namespace StaticATM{
+
+struct Idle{};
+struct HasCard{};
+struct PinValidation{};
+struct SelectOperation{};
+struct Transaction{};
+
+using State = variant<Idle, HasCard, PinValidation, SelectOperation, Transaction>;
+
+class Machine{
+  private:
+    ATMMachine& atm;
+    State state = Idle{};
+
+    // ---- insertCard ----
+    State onInsertCard(Idle){
+      cout<<"Card Inserted Successfully!!"<<endl;
+      return HasCard{};
+    }
+    State onInsertCard(HasCard s){ cout<<"Card Already Inserted!!"<<endl; return s; }
+    State onInsertCard(Transaction s){ cout<<"Card Already Inserted!!"<<endl; return s; }
+    template<class S> State onInsertCard(S s){ cout<<"Card Already Inserted"<<endl; return s; }
+
+    // ---- removeCard ----
+    State onRemoveCard(Idle s){ cout<<"Insert Card First"<<endl; return s; }
+    State onRemoveCard(SelectOperation){
+      cout<<"Transaction Cancelled"<<endl;
+      atm.clearSession();
+      return Idle{};
+    }
+    State onRemoveCard(Transaction s){ cout<<"Transaction Failed, Card Removed"<<endl; return s; }
+    template<class S> State onRemoveCard(S){ cout<<"Card Removed"<<endl; return Idle{}; }
+
+    // ---- selectOperation ----
+    State onSelectOperation(Idle s, OperationType){ cout<<"Insert Card First"<<endl; return s; }
+    State onSelectOperation(HasCard, OperationType){
+      cout<<"Proceeding to PIN Validation"<<endl;
+      return PinValidation{};
+    }
+    State onSelectOperation(PinValidation s, OperationType operation){
+      switch(atm.enterPin(operation)){
+        case ATMMachine::PIN_OK: return SelectOperation{};
+        case ATMMachine::PIN_NO_ACCOUNT: return Idle{};
+        default: return s;
+      }
+    }
+    State onSelectOperation(SelectOperation, OperationType operation){
+      atm.setOperation(operation);
+      return Transaction{};
+    }
+    State onSelectOperation(Transaction s, OperationType){
+      cout<<"Operation Already Selected, Processing Transaction"<<endl;
+      return s;
+    }
+
+    // ---- transaction ----
+    State onTransaction(HasCard){ cout<<"Select Operation First"<<endl; return Idle{}; }
+    State onTransaction(Transaction s){
+      if(atm.executeTransaction())
+        return Idle{};
+      return s;
+    }
+    template<class S> State onTransaction(S s){ cout<<"Select Operation First"<<endl; return s; }
+
+  public:
+    Machine(ATMMachine& atm) : atm(atm) {}
+
+    void insertCard(){
+      state = visit([this](auto s){ return onInsertCard(s); }, state);
+      atm.enterState((int)state.index());
+    }
+
+    void removeCard(){
+      state = visit([this](auto s){ return onRemoveCard(s); }, state);
+      atm.enterState((int)state.index());
+    }
+
+    void selectOperation(OperationType operation){
+      state = visit([this, operation](auto s){ return onSelectOperation(s, operation); }, state);
+      atm.enterState((int)state.index());
+    }
+
+    void transaction(){
+      state = visit([this](auto s){ return onTransaction(s); }, state);
+      atm.enterState((int)state.index());
+    }
+
+    void reset(){
+      state = Idle{};
+      atm.enterState(0);
+    }
+
+    string getStateName(){
+      static const char* names[] = {"Idle_State", "Has_Card_State", "PIN_Validation_State",
+                                    "Select_Operation_State", "Transaction_State"};
+      return names[state.index()];
+    }
+};
+
+} // namespace StaticATM
+
+/*
+===========================================================
+ MULTI-SESSION ENGINE
+===========================================================
+Drives many independent ATM sessions at once (simulator /
+test farm) instead of one ATMMachine per customer.
+
+- A session is an 8-byte SessionSlot: card index, state,
+  operation, script position. A million sessions is 8 MB.
+- States are a table of transitions, TRANSITIONS[state][event],
+  plain functions with no data of their own (the flyweight
+  version of the ATMState classes, same moves). Events carry
+  the PIN/amount the interactive version reads from cin.
+- Each session follows a script (withdraw, balance inquiry,
+  wrong PIN, cancel). Handling one event queues the session's
+  next one, so a session never has two events in flight and
+  needs no lock of its own.
+- Events run on the shared WorkStealingPool
+  (../common/WorkStealingPool.h): the next event goes to the
+  worker that ran this one and is popped newest-first, so a
+  session tends to finish on one core while it is in cache;
+  idle workers steal the oldest tasks. A task is just the
+  session id (the event is read off its script), small enough
+  that queueing it does not allocate.
+- Cash comes from a farm of machines (session % machines),
+  each an ATMInventory behind its own mutex; balances are the
+  lock-free Accounts from the shared AccountStore.
+- A declined transaction ends the session (card ejected),
+  where the interactive TransactionState waits for a retry.
+*/
+
+enum SessionState : uint8_t{
+  S_IDLE,
+  S_HAS_CARD,
+  S_PIN_VALIDATION,
+  S_SELECT_OPERATION,
+  S_TRANSACTION,
+  SESSION_STATE_COUNT
+};
+
+enum SessionEventType : uint8_t{
+  E_INSERT_CARD,
+  E_REMOVE_CARD,
+  E_SELECT_OPERATION,   // in S_PIN_VALIDATION, value = PIN typed
+  E_EXECUTE,            // value = amount for WITHDRAW
+  SESSION_EVENT_COUNT
+};
+
+enum SessionScript : uint8_t{
+  SCRIPT_WITHDRAW,
+  SCRIPT_BALANCE,
+  SCRIPT_WRONG_PIN,
+  SCRIPT_CANCEL,
+  SCRIPT_COUNT
+};
+
+struct SessionSlot{
+  uint32_t card;            // index into the engine's card table
+  uint8_t state;            // SessionState
+  uint8_t operation;        // OperationType
+  uint8_t script : 7;       // SessionScript
+  uint8_t pinRejected : 1;  // a wrong PIN was typed this session
+  uint8_t step;             // next script step
+};
+
+struct SessionEvent{
+  uint32_t session;
+  uint8_t type;         // SessionEventType
+  uint8_t operation;    // OperationType
+  int32_t value;
+};
+
+struct EngineStats{
+  long events = 0;
+  long sessionsDone = 0;
+  long withdrawals = 0;
+  long balanceInquiries = 0;
+  long wrongPins = 0;
+  long cancelled = 0;
+  long declinedBalance = 0;
+  long declinedCash = 0;
+  long notIdleAtEnd = 0;
+  Money dispensed = 0;
+
+  void merge(const EngineStats& other){
+    events += other.events;
+    sessionsDone += other.sessionsDone;
+    withdrawals += other.withdrawals;
+    balanceInquiries += other.balanceInquiries;
+    wrongPins += other.wrongPins;
+    cancelled += other.cancelled;
+    declinedBalance += other.declinedBalance;
+    declinedCash += other.declinedCash;
+    notIdleAtEnd += other.notIdleAtEnd;
+    dispensed += other.dispensed;
+  }
+};
+
+class AtmEngine{
+  private:
+    struct CardRecord{
+      Card* card;
+      Account* account;     // resolved once; nullptr = account not found
+      int customerPin;      // what the simulated customer types
+    };
+
+    struct alignas(64) Machine{
+      mutex lock;
+      ATMInventory inventory;
+    };
+
+    struct alignas(64) WorkerStats{
+      EngineStats stats;
+    };
+
+    typedef uint8_t (*Transition)(AtmEngine&, EngineStats&, SessionSlot&, const SessionEvent&);
+    static const Transition TRANSITIONS[SESSION_STATE_COUNT][SESSION_EVENT_COUNT];
+
+    struct ScriptStep{
+      uint8_t type;
+      bool wrongPin;
+    };
+    static const int MAX_SCRIPT_STEPS = 6;
+    static const ScriptStep SCRIPTS[SCRIPT_COUNT][MAX_SCRIPT_STEPS];
+
+    AccountStore& accounts;
+    vector<CardRecord> cards;
+    vector<SessionSlot> sessions;
+    vector<unique_ptr<Machine>> machines;
+    vector<WorkerStats> workerStats;    // one per pool worker, no sharing
+    WorkStealingPool* pool = nullptr;   // set for the duration of run()
+    TaskGroup* sessionsLeft = nullptr;
+
+    // ---- transitions (same moves as the ATMState classes) ----
+    static uint8_t stay(AtmEngine&, EngineStats&, SessionSlot& s, const SessionEvent&){
+      return s.state;
+    }
+
+    static uint8_t toHasCard(AtmEngine&, EngineStats&, SessionSlot&, const SessionEvent&){
+      return S_HAS_CARD;
+    }
+
+    static uint8_t toPinValidation(AtmEngine&, EngineStats&, SessionSlot&, const SessionEvent&){
+      return S_PIN_VALIDATION;
+    }
+
+    // A card pulled mid-session is a cancel, unless the PIN was just
+    // rejected (WRONG_PIN ends that way; it is counted as wrongPins)
+    static uint8_t toIdle(AtmEngine&, EngineStats& stats, SessionSlot& s, const SessionEvent& e){
+      if(e.type == E_REMOVE_CARD && s.state != S_HAS_CARD && !s.pinRejected)
+        stats.cancelled++;
+      return S_IDLE;
+    }
+
+    static uint8_t validatePin(AtmEngine& engine, EngineStats& stats, SessionSlot& s, const SessionEvent& e){
+      CardRecord& record = engine.cards[s.card];
+      if(!record.card->validatePin(e.value)){
+        stats.wrongPins++;
+        s.pinRejected = 1;
+        return S_PIN_VALIDATION;
+      }
+      if(!record.account)
+        return S_IDLE;
+      s.operation = e.operation;
+      return S_SELECT_OPERATION;
+    }
+
+    static uint8_t chooseOperation(AtmEngine&, EngineStats&, SessionSlot& s, const SessionEvent& e){
+      s.operation = e.operation;
+      return S_TRANSACTION;
+    }
+
+    static uint8_t execute(AtmEngine& engine, EngineStats& stats, SessionSlot& s, const SessionEvent& e){
+      Account* account = engine.cards[s.card].account;
+
+      if(s.operation == BALANCE_INQUIRY){
+        stats.balanceInquiries++;
+        return S_IDLE;
+      }
+
+      int amount = e.value;
+      Money amountMinor = (Money)amount * MINOR_PER_UNIT;
+      if(!account->withdraw(amountMinor)){
+        stats.declinedBalance++;
+        return S_IDLE;
+      }
+
+      Machine& machine = *engine.machines[e.session % engine.machines.size()];
+      bool paid;
+      {
+        lock_guard<mutex> guard(machine.lock);
+        paid = machine.inventory.hasSufficientCash(amount)
+               && !machine.inventory.dispenseCash(amount).empty();
+      }
+      if(!paid){
+        account->deposit(amountMinor);   // rollback
+        stats.declinedCash++;
+        return S_IDLE;
+      }
+
+      stats.withdrawals++;
+      stats.dispensed += amountMinor;
+      return S_IDLE;
+    }
+
+    // ---- scheduling ----
+    bool nextEvent(uint32_t id, SessionEvent& event){
+      SessionSlot& s = sessions[id];
+      const ScriptStep& step = SCRIPTS[s.script][s.step];
+      if(step.type == SESSION_EVENT_COUNT)
+        return false;
+      s.step++;
+
+      OperationType operation = (s.script == SCRIPT_BALANCE) ? BALANCE_INQUIRY : WITHDRAW;
+      int value = 0;
+      if(step.type == E_SELECT_OPERATION)
+        value = cards[s.card].customerPin + (step.wrongPin ? 1 : 0);
+      else if(step.type == E_EXECUTE)
+        value = 10 * (1 + (int)(id * 2654435761u % 50));   // 10..500
+
+      event = {id, step.type, (uint8_t)operation, value};
+      return true;
+    }
+
+    bool hasNextEvent(uint32_t id) const{
+      const SessionSlot& s = sessions[id];
+      return SCRIPTS[s.script][s.step].type != SESSION_EVENT_COUNT;
+    }
+
+    void schedule(uint32_t id){
+      pool->run(*sessionsLeft, [this, id]{ advance(id); });
+    }
+
+    // Runs the session's next event, then queues the one after it
+    void advance(uint32_t id){
+      EngineStats& stats = workerStats[pool->workerIndex()].stats;
+      SessionSlot& s = sessions[id];
+      SessionEvent event;
+      nextEvent(id, event);
+      s.state = TRANSITIONS[s.state][event.type](*this, stats, s, event);
+      stats.events++;
+
+      if(hasNextEvent(id)){
+        schedule(id);
+        return;
+      }
+      stats.sessionsDone++;
+      if(s.state != S_IDLE)
+        stats.notIdleAtEnd++;
+    }
+
+  public:
+    AtmEngine(AccountStore& accounts, int machineCount, int notesPerDenomination)
+      : accounts(accounts){
+      for(int m = 0; m < machineCount; m++){
+        machines.emplace_back(new Machine());
+        for(CashType type : DENOMINATIONS)
+          machines.back()->inventory.setNoteCount(type, notesPerDenomination);
+      }
+    }
+
+    uint32_t addCard(Card* card, int customerPin){
+      cards.push_back({card, accounts.findAccount(card->getAccountNumber()), customerPin});
+      return (uint32_t)(cards.size() - 1);
+    }
+
+    uint32_t addSession(uint32_t card, SessionScript script){
+      sessions.push_back({card, S_IDLE, WITHDRAW, (uint8_t)script, 0, 0});
+      return (uint32_t)(sessions.size() - 1);
+    }
+
+    size_t getSessionCount(){
+      return sessions.size();
+    }
+
+    // Runs every session's script to the end on workerCount threads
+    // (the calling thread is one of them)
+    EngineStats run(int workerCount){
+      const uint32_t SEED_CHUNK = 1024;   // sessions started by one task
+      WorkStealingPool workers(max(1, workerCount));
+      TaskGroup group;
+      workerStats.assign(workers.size(), WorkerStats());
+      pool = &workers;
+      sessionsLeft = &group;
+
+      // Seeding in chunks: a worker that picks one up queues those
+      // sessions on its own deque, instead of all of them piling up
+      // on the caller's
+      uint32_t count = (uint32_t)sessions.size();
+      for(uint32_t begin = 0; begin < count; begin += SEED_CHUNK){
+        workers.run(group, [this, begin, count]{
+          for(uint32_t id = begin; id < min(begin + SEED_CHUNK, count); id++)
+            if(hasNextEvent(id))
+              schedule(id);
+        });
+      }
+      workers.wait(group);
+      pool = nullptr;
+      sessionsLeft = nullptr;
+
+      EngineStats total;
+      for(auto& w : workerStats) total.merge(w.stats);
+      return total;
+    }
+};
+
+const AtmEngine::Transition AtmEngine::TRANSITIONS[SESSION_STATE_COUNT][SESSION_EVENT_COUNT] = {
+  //                   INSERT_CARD          REMOVE_CARD        SELECT_OPERATION            EXECUTE
+  /* IDLE         */ { AtmEngine::toHasCard, AtmEngine::stay,   AtmEngine::stay,            AtmEngine::stay },
+  /* HAS_CARD     */ { AtmEngine::stay,      AtmEngine::toIdle, AtmEngine::toPinValidation, AtmEngine::toIdle },
+  /* PIN          */ { AtmEngine::stay,      AtmEngine::toIdle, AtmEngine::validatePin,     AtmEngine::stay },
+  /* SELECT_OP    */ { AtmEngine::stay,      AtmEngine::toIdle, AtmEngine::chooseOperation, AtmEngine::stay },
+  /* TRANSACTION  */ { AtmEngine::stay,      AtmEngine::stay,   AtmEngine::stay,            AtmEngine::execute },
+};
+
+// SESSION_EVENT_COUNT ends a script
+const AtmEngine::ScriptStep AtmEngine::SCRIPTS[SCRIPT_COUNT][MAX_SCRIPT_STEPS] = {
+  /* WITHDRAW  */ {{E_INSERT_CARD, false}, {E_SELECT_OPERATION, false}, {E_SELECT_OPERATION, false},
+                   {E_SELECT_OPERATION, false}, {E_EXECUTE, false}, {SESSION_EVENT_COUNT, false}},
+  /* BALANCE   */ {{E_INSERT_CARD, false}, {E_SELECT_OPERATION, false}, {E_SELECT_OPERATION, false},
+                   {E_SELECT_OPERATION, false}, {E_EXECUTE, false}, {SESSION_EVENT_COUNT, false}},
+  /* WRONG_PIN */ {{E_INSERT_CARD, false}, {E_SELECT_OPERATION, false}, {E_SELECT_OPERATION, true},
+                   {E_REMOVE_CARD, false}, {SESSION_EVENT_COUNT, false}},
+  /* CANCEL    */ {{E_INSERT_CARD, false}, {E_SELECT_OPERATION, false}, {E_SELECT_OPERATION, false},
+                   {E_REMOVE_CARD, false}, {SESSION_EVENT_COUNT, false}},
+};
+
+/*
+===========================================================
+ BENCHMARK: account contention
+===========================================================
+THREADS sessions withdraw/deposit on accounts picked from a
+small hot set (worst case) or a large cold set. Lock-free
+Account vs the same traffic through a single global mutex.
+Money is conserved in both: the final total is checked.
+*/
+
+void runContentionBenchmark(){
+  const int OPS_PER_THREAD = 200000;
+  const int COLD_ACCOUNTS = 10000;
+  const int HOT_ACCOUNTS = 4;
+  const int THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32};
+  const Money START = 1000 * MINOR_PER_UNIT;
+
+  AccountStore store;
+  vector<Account*> accounts;
+  for(int i = 0; i < COLD_ACCOUNTS; i++){
+    accounts.push_back(new Account("ACC" + to_string(i), START));
+    store.addAccount(accounts.back());
+  }
+
+  // One session: look the account up, then withdraw or deposit
+  auto session = [&](int threadId, int accountRange, bool globalLock,
+                     mutex& global, atomic<Money>& delta){
+    mt19937 rng(threadId + 1);
+    Money local = 0;
+    for(int i = 0; i < OPS_PER_THREAD; i++){
+      Account* account = store.findAccount("ACC" + to_string(rng() % accountRange));
+      Money amount = (1 + rng() % 20) * MINOR_PER_UNIT;
+      bool isWithdraw = rng() % 2;
+      if(globalLock){
+        lock_guard<mutex> guard(global);
+        if(isWithdraw ? account->withdraw(amount) : (account->deposit(amount), true))
+          local += isWithdraw ? -amount : amount;
+      }
+      else if(isWithdraw ? account->withdraw(amount) : (account->deposit(amount), true)){
+        local += isWithdraw ? -amount : amount;
+      }
+    }
+    delta += local;
+  };
+
+  auto total = [&](){
+    Money sum = 0;
+    for(auto account : accounts) sum += account->getBalance();
+    return sum;
+  };
+
+  cout << "\n==== ACCOUNT CONTENTION (" << OPS_PER_THREAD << " ops per thread) ====\n"
+       << "threads\thot CAS\t\thot lock\tcold CAS\tcold lock\t(Mops/s)\n";
+
+  bool conserved = true;
+  for(int threads : THREAD_COUNTS){
+    cout << threads;
+    for(int range : {HOT_ACCOUNTS, COLD_ACCOUNTS}){
+      for(bool globalLock : {false, true}){
+        mutex global;
+        atomic<Money> delta{0};
+        Money before = total();
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> pool;
+        for(int t = 0; t < threads; t++)
+          pool.emplace_back(session, t, range, globalLock, ref(global), ref(delta));
+        for(auto& t : pool) t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        conserved = conserved && total() == before + delta;
+        cout << "\t" << (threads * (double)OPS_PER_THREAD / seconds / 1e6) << "\t";
+      }
+    }
+    cout << "\n";
+  }
+  cout << "money conserved: " << (conserved ? "yes" : "NO") << "\n";
+
+  for(auto account : accounts) delete account;
+}
+
+/*
+===========================================================
+ BENCHMARK: cash dispensing
+===========================================================
+Random stock (some denominations often missing) and random
+amounts. Each case is checked against a full bounded-DP
+reachability table: branch-and-bound must succeed exactly
+when a combination exists; greedy misses some of those.
+*/
+
+// Reference: can `amount` be paid from this stock at all?
+bool canPayExactly(const int stock[], int amount){
+  vector<char> reachable(amount + 1, 0);
+  reachable[0] = 1;
+  for(int i = 0; i < DENOMINATION_COUNT; i++){
+    int value = static_cast<int>(DENOMINATIONS[i]);
+    for(int n = 0; n < stock[i]; n++)
+      for(int a = amount; a >= value; a--)
+        if(reachable[a - value]) reachable[a] = 1;
+  }
+  return reachable[amount];
+}
+
+void runDispenseBenchmark(){
+  const int CASES = 20000;
+  mt19937 rng(42);
+
+  int feasible = 0, found = 0, wrong = 0, greedyMissed = 0;
+  double searchNs = 0;
+  vector<double> times;
+
+  // Reused like a real machine's, so search scratch stays allocated
+  ATMInventory inventory, greedy;
+
+  for(int c = 0; c < CASES; c++){
+    int stock[DENOMINATION_COUNT];
+    for(int i = 0; i < DENOMINATION_COUNT; i++){
+      stock[i] = (rng() % 3 == 0) ? 0 : rng() % 12;
+      inventory.setNoteCount(DENOMINATIONS[i], stock[i]);
+      greedy.setNoteCount(DENOMINATIONS[i], stock[i]);
+    }
+    if(inventory.getTotalCash() == 0)
+      continue;
+    int amount = 1 + rng() % inventory.getTotalCash();
+
+    bool possible = canPayExactly(stock, amount);
+
+    auto start = chrono::steady_clock::now();
+    CashBundle bundle = inventory.dispenseCash(amount);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    searchNs += ns;
+    times.push_back(ns);
+
+    int paid = 0;
+    for(int i = 0; i < DENOMINATION_COUNT; i++){
+      paid += bundle.notes[i] * static_cast<int>(DENOMINATIONS[i]);
+      if(bundle.notes[i] > stock[i]) wrong++;
+    }
+
+    feasible += possible;
+    found += !bundle.empty();
+    if(bundle.empty() == possible || (!bundle.empty() && paid != amount)) wrong++;
+    if(possible && greedy.dispenseCashGreedy(amount).empty()) greedyMissed++;
+  }
+
+  sort(times.begin(), times.end());
+  double p99 = times.empty() ? 0 : times[times.size() * 99 / 100];
+
+  cout << "\n==== CASH DISPENSING (" << CASES << " random stocks and amounts) ====\n"
+       << "payable amounts\t\t" << feasible << "\n"
+       << "branch-and-bound paid\t" << found << " (wrong: " << wrong << ")\n"
+       << "greedy missed\t\t" << greedyMissed << "\n"
+       << "avg search\t\t" << searchNs / times.size() / 1000 << " us\n"
+       << "p99 search\t\t" << p99 / 1000 << " us\n";
+}
+
+/*
+===========================================================
+ BENCHMARK: multi-session engine
+===========================================================
+SESSIONS scripted sessions (mixed withdraw / balance / wrong
+PIN / cancel) over CARDS shared accounts, 1..8 workers.
+Checks every session ends idle and no money is lost.
+*/
+
+void runEngineBenchmark(){
+  const int SESSIONS = 1000000;
+  const int CARDS = 10000;
+  const int MACHINES = 32;
+  const int WORKER_COUNTS[] = {1, 2, 4, 8};
+
+  cout << "\n==== MULTI-SESSION ENGINE (" << SESSIONS << " sessions, "
+       << sizeof(SessionSlot) << " bytes each) ====\n"
+       << "workers\tevents/s\tsessions/s\twithdrawals\tdeclined\tnot idle\tmoney ok\n";
+
+  for(int workerCount : WORKER_COUNTS){
+    AccountStore store;
+    vector<unique_ptr<Account>> accounts;
+    vector<unique_ptr<Card>> cards;
+    Money before = 0;
+    for(int i = 0; i < CARDS; i++){
+      string number = "ACC" + to_string(i);
+      Money balance = (Money)(i % 7) * 3000 * MINOR_PER_UNIT;   // some run dry
+      accounts.emplace_back(new Account(number, balance));
+      cards.emplace_back(new Card("CARD" + to_string(i), 1000 + i % 9000, number));
+      store.addAccount(accounts.back().get());
+      before += balance;
+    }
+
+    AtmEngine engine(store, MACHINES, 100000);
+    for(int i = 0; i < CARDS; i++)
+      engine.addCard(cards[i].get(), 1000 + i % 9000);
+
+    mt19937 rng(9);
+    for(int i = 0; i < SESSIONS; i++){
+      uint32_t roll = rng() % 10;
+      SessionScript script = roll < 6 ? SCRIPT_WITHDRAW : roll < 8 ? SCRIPT_BALANCE
+                             : roll < 9 ? SCRIPT_WRONG_PIN : SCRIPT_CANCEL;
+      engine.addSession(rng() % CARDS, script);
+    }
+
+    auto start = chrono::steady_clock::now();
+    EngineStats stats = engine.run(workerCount);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    Money after = 0;
+    for(auto& account : accounts) after += account->getBalance();
+    bool moneyOk = before - after == stats.dispensed && stats.sessionsDone == SESSIONS;
+
+    cout << workerCount << "\t" << (long)(stats.events / seconds)
+         << "\t" << (long)(stats.sessionsDone / seconds)
+         << "\t" << stats.withdrawals
+         << "\t\t" << stats.declinedBalance + stats.declinedCash
+         << "\t\t" << stats.notIdleAtEnd
+         << "\t\t" << (moneyOk ? "yes" : "NO") << "\n";
+  }
+}
+
+/*
+===========================================================
+ BENCHMARK: state dispatch
+===========================================================
+Same event stream through the virtual ATMState classes and
+through StaticATM::Machine:
+- behavior: a scripted run (PINs and amounts fed into cin)
+  must print exactly the same thing on both
+- latency: a cycle of events that never read cin, output
+  silenced, ns per event
+Events: I insertCard, R removeCard, S selectOperation, T transaction
+*/
+
+void driveVirtual(ATMMachine& atm, const string& events, OperationType operation){
+  for(char e : events){
+    ATMState* state = atm.getCurrentState();
+    if(e == 'I') atm.setCurrentState(state->insertCard(&atm));
+    else if(e == 'R') atm.setCurrentState(state->removeCard(&atm));
+    else if(e == 'S') atm.setCurrentState(state->selectOperation(&atm, operation));
+    else atm.setCurrentState(state->transactionState(&atm));
+  }
+}
+
+void driveStatic(StaticATM::Machine& machine, const string& events, OperationType operation){
+  for(char e : events){
+    if(e == 'I') machine.insertCard();
+    else if(e == 'R') machine.removeCard();
+    else if(e == 'S') machine.selectOperation(operation);
+    else machine.transaction();
+  }
+}
+
+void runDispatchBenchmark(){
+  const string SCRIPT = "RSTIISSTISTSRIRSSSTIRSSSSTRT";
+  const string INPUT = "1234 1111 500 1111 99999 1111 20";
+  const string CYCLE = "IISTRRTSIRTS";   // no step reads cin
+  const int CYCLES = 2000000;
+
+  Card card("CARD001", 1111, "ACC001");
+
+  // Captures what one engine prints for SCRIPT
+  auto scripted = [&](bool useStatic){
+    ATMMachine atm;
+    Account account("ACC001", 5000 * MINOR_PER_UNIT);
+    atm.addAccount(&account);
+    atm.setCard(&card);
+    StaticATM::Machine machine(atm);
+
+    istringstream in(INPUT);
+    ostringstream out;
+    streambuf* oldIn = cin.rdbuf(in.rdbuf());
+    {
+      AsyncLog::Redirect capture(out.rdbuf());
+      for(OperationType operation : {WITHDRAW, BALANCE_INQUIRY}){
+        if(useStatic) driveStatic(machine, SCRIPT, operation);
+        else driveVirtual(atm, SCRIPT, operation);
+        atm.setCard(&card);
+      }
+      cout << (useStatic ? machine.getStateName() : atm.getCurrentState()->getStateName());
+    }
+    cin.rdbuf(oldIn);
+    return out.str();
+  };
+  bool sameBehavior = scripted(false) == scripted(true);
+
+  ATMMachine atm;
+  atm.setCard(&card);
+  StaticATM::Machine machine(atm);
+
+  optional<AsyncLog::Redirect> quiet(in_place, nullptr);
+  auto start = chrono::steady_clock::now();
+  for(int i = 0; i < CYCLES; i++)
+    driveVirtual(atm, CYCLE, WITHDRAW);
+  double virtualNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+  start = chrono::steady_clock::now();
+  for(int i = 0; i < CYCLES; i++)
+    driveStatic(machine, CYCLE, WITHDRAW);
+  double staticNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+  quiet.reset();
+
+  double events = (double)CYCLES * CYCLE.size();
+  cout << "\n==== ATM STATE DISPATCH (" << CYCLE.size() << "-event cycle, "
+       << CYCLES << " cycles, output silenced) ====\n"
+       << "same behavior\t" << (sameBehavior ? "yes" : "NO") << "\n"
+       << "virtual\t\t" << virtualNs / events << " ns per event\n"
+       << "variant\t\t" << staticNs / events << " ns per event\n";
+}
+
+/*
+===========================================================
+ BENCHMARK: transaction journal
+===========================================================
+- durability: SESSIONS threads each withdraw and wait until
+  the withdrawal is durable. Group commit vs the naive way
+  (write + fdatasync per withdrawal, behind one lock)
+- recovery: a long history restarted by full replay vs from
+  a snapshot plus a short tail; both must rebuild the same
+  state, and a torn last record must be dropped cleanly
+- an ATMMachine session journaled, reopened and restored
+*/
+
+bool sameJournalState(const JournalState& a, const JournalState& b){
+  return a.nextSequence == b.nextSequence && a.balances == b.balances && a.machines == b.machines;
+}
+
+void runJournalBenchmark(){
+  const int OPS_PER_SESSION = 2000;
+  const int SESSION_COUNTS[] = {1, 8, 64};
+  const uint64_t HISTORY = 2000000;
+  const uint64_t TAIL = 1000;
+  const string dir = (filesystem::temp_directory_path() / "atm-journal-bench").string();
+  filesystem::remove_all(dir);
+
+  CashBundle cash;
+  cash.notes[0] = 1;
+  cash.dispensed = true;
+
+  cout << "\n==== TRANSACTION JOURNAL (" << OPS_PER_SESSION << " durable withdrawals per session) ====\n"
+       << "sessions\tgroup commit\t\t\tsync per withdrawal\n";
+
+  for(int sessions : SESSION_COUNTS){
+    filesystem::remove_all(dir);
+    double groupUs, naiveUs;
+    uint64_t syncs;
+    {
+      TransactionJournal journal(dir + "/group");
+      for(int s = 0; s < sessions; s++)
+        journal.recordOpenAccount("ACC" + to_string(s), 1000000 * MINOR_PER_UNIT);
+
+      auto start = chrono::steady_clock::now();
+      vector<thread> pool;
+      for(int s = 0; s < sessions; s++)
+        pool.emplace_back([&, s](){
+          string account = "ACC" + to_string(s);
+          for(int i = 0; i < OPS_PER_SESSION; i++)
+            journal.awaitDurable(journal.recordWithdrawal(s % 8, account, 100 * MINOR_PER_UNIT, cash));
+        });
+      for(auto& t : pool) t.join();
+      groupUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+      syncs = journal.getSyncCount();
+    }
+    {
+      filesystem::create_directories(dir + "/naive");
+      int fd = ::open((dir + "/naive/log").c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+      mutex lock;
+      JournalRecord record;
+      memset(&record, 0, sizeof(record));
+
+      auto start = chrono::steady_clock::now();
+      vector<thread> pool;
+      for(int s = 0; s < sessions; s++)
+        pool.emplace_back([&](){
+          for(int i = 0; i < OPS_PER_SESSION; i++){
+            lock_guard<mutex> guard(lock);
+            if(::write(fd, &record, sizeof(record)) != (ssize_t)sizeof(record)) abort();
+            fdatasync(fd);
+          }
+        });
+      for(auto& t : pool) t.join();
+      naiveUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+      close(fd);
+    }
+    double ops = (double)sessions * OPS_PER_SESSION;
+    cout << sessions << "\t\t" << groupUs / ops << " us/op ("
+         << ops / syncs << " per sync)\t" << naiveUs / ops << " us/op\n";
+  }
+
+  // ---- recovery ----
+  filesystem::remove_all(dir);
+  const int ACCOUNTS = 1000;
+  JournalState written;
+  {
+    TransactionJournal journal(dir);
+    for(int a = 0; a < ACCOUNTS; a++)
+      journal.recordOpenAccount("ACC" + to_string(a), 1000000 * MINOR_PER_UNIT);
+    for(uint16_t m = 0; m < 8; m++)
+      journal.recordStock(m, NoteCounts{{100000, 100000, 100000, 100000, 100000, 100000}});
+    for(uint64_t i = journal.endSequence(); i < HISTORY; i++)
+      journal.recordWithdrawal(i % 8, "ACC" + to_string(i % ACCOUNTS), (1 + i % 50) * MINOR_PER_UNIT, cash);
+    journal.awaitDurable(HISTORY - 1);
+    written = journal.getState();
+  }
+
+  auto timedOpen = [&](JournalState& state, uint64_t& replayed){
+    auto start = chrono::steady_clock::now();
+    TransactionJournal journal(dir);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    state = journal.getState();
+    replayed = journal.getReplayedRecords();
+    return ms;
+  };
+
+  JournalState fullState, snapState, tornState;
+  uint64_t fullReplayed, snapReplayed, tornReplayed;
+  double fullMs = timedOpen(fullState, fullReplayed);
+  bool fullOk = sameJournalState(fullState, written);
+
+  {
+    TransactionJournal journal(dir);
+    journal.snapshot();
+    for(uint64_t i = 0; i < TAIL; i++)
+      journal.recordWithdrawal(i % 8, "ACC" + to_string(i % ACCOUNTS), MINOR_PER_UNIT, cash);
+    journal.awaitDurable(journal.endSequence() - 1);
+    written = journal.getState();
+  }
+  double snapMs = timedOpen(snapState, snapReplayed);
+  bool snapOk = sameJournalState(snapState, written);
+
+  // Crash mid-write: half a record at the end of the active segment
+  {
+    vector<uint64_t> bases;
+    for(auto& entry : filesystem::directory_iterator(dir))
+      if(entry.path().extension() == ".journal")
+        bases.push_back(stoull(entry.path().stem().string()));
+    string digits = to_string(*max_element(bases.begin(), bases.end()));
+    string path = dir + "/" + string(20 - digits.size(), '0') + digits + ".journal";
+    int fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+    char garbage[sizeof(JournalRecord) / 2] = {1, 2, 3};
+    if(::write(fd, garbage, sizeof(garbage)) != (ssize_t)sizeof(garbage)) abort();
+    close(fd);
+  }
+  timedOpen(tornState, tornReplayed);
+  bool tornOk = sameJournalState(tornState, written);
+
+  cout << "recovery (" << HISTORY + TAIL << " records of history)\n"
+       << "full replay\t" << fullMs << " ms (" << fullReplayed << " records) "
+       << (fullOk ? "state ok" : "STATE WRONG") << "\n"
+       << "from snapshot\t" << snapMs << " ms (" << snapReplayed << " records) "
+       << (snapOk ? "state ok" : "STATE WRONG") << "\n"
+       << "torn tail\t" << (tornOk ? "dropped, state ok" : "STATE WRONG") << "\n";
+
+  // ---- a journaled ATM session survives a restart ----
+  filesystem::remove_all(dir);
+  Card card("CARD001", 1111, "ACC001");
+  Money balanceBefore;
+  int hundredsBefore;
+  {
+    TransactionJournal journal(dir);
+    ATMMachine atm;
+    Account account("ACC001", 5000 * MINOR_PER_UNIT);
+    atm.addAccount(&account);
+    atm.attachJournal(&journal, 1);     // journals ACC001 as opened
+
+    istringstream in("1111 370");
+    streambuf* oldIn = cin.rdbuf(in.rdbuf());
+    {
+      AsyncLog::Redirect quiet(nullptr);
+      atm.setCard(&card);
+      driveVirtual(atm, "ISSST", WITHDRAW);
+    }
+    cin.rdbuf(oldIn);
+    balanceBefore = account.getBalance();
+    hundredsBefore = atm.getInventory().getNoteCount(BILL_100);
+  }
+  bool restoredOk;
+  {
+    TransactionJournal journal(dir);
+    AccountStore store;
+    vector<Account*> restored = journal.restoreAccounts(store);
+    ATMMachine atm(&store);
+    atm.attachJournal(&journal, 1);
+    restoredOk = balanceBefore == 4630 * MINOR_PER_UNIT &&
+                 store.findAccount("ACC001")->getBalance() == balanceBefore &&
+                 atm.getInventory().getNoteCount(BILL_100) == hundredsBefore;
+    for(auto account : restored) delete account;
+  }
+  cout << "ATM restart\t" << (restoredOk ? "balance and notes restored" : "RESTORE WRONG") << "\n";
+
+  filesystem::remove_all(dir);
+}
+
+/*
+===========================================================
+ LOAD SUITE: --load
+===========================================================
+Machine-readable: one JSON line per case and session count
+(see bench/LoadHarness.h for flags and fields). Output of the
+machines is silenced.
+- account_session: each worker is one session against the
+  shared sharded store: look a random account up, then
+  withdraw or deposit on it (CAS balance)
+- machine_cycle: each worker owns an ATMMachine driven by
+  StaticATM through the CYCLE of the dispatch benchmark;
+  one op = one 12-event cycle
+*/
+
+void runLoadSuite(const LoadHarness::Options& options){
+  const int ACCOUNTS = 10000;
+  const Money START = 1000 * MINOR_PER_UNIT;
+  const string CYCLE = "IISTRRTSIRTS";
+
+  LoadHarness::Reporter report("atm", options);
+  AsyncLog::Redirect quiet(nullptr);
+
+  if(options.wants("account_session")){
+    AccountStore store;
+    vector<unique_ptr<Account>> accounts;
+    vector<string> numbers;
+    for(int i = 0; i < ACCOUNTS; i++){
+      numbers.push_back("ACC" + to_string(i));
+      accounts.emplace_back(new Account(numbers.back(), START));
+      store.addAccount(accounts.back().get());
+    }
+
+    for(int sessions : options.threads){
+      vector<mt19937> rngs;
+      for(int t = 0; t < sessions; t++) rngs.emplace_back(t + 1);
+
+      report.emit(LoadHarness::runLoad("account_session", sessions, options.seconds,
+        [&](int t, uint64_t){
+          mt19937& rng = rngs[t];
+          Account* account = store.findAccount(numbers[rng() % ACCOUNTS]);
+          Money amount = (1 + rng() % 20) * MINOR_PER_UNIT;
+          if(rng() % 2) account->withdraw(amount);
+          else account->deposit(amount);
+        }));
+    }
+  }
+
+  if(options.wants("machine_cycle")){
+    Card card("CARD001", 1111, "ACC001");
+    for(int sessions : options.threads){
+      vector<unique_ptr<ATMMachine>> atms;
+      vector<unique_ptr<StaticATM::Machine>> machines;
+      for(int t = 0; t < sessions; t++){
+        atms.emplace_back(new ATMMachine());
+        atms.back()->setCard(&card);
+        machines.emplace_back(new StaticATM::Machine(*atms.back()));
+      }
+
+      report.emit(LoadHarness::runLoad("machine_cycle", sessions, options.seconds,
+        [&](int t, uint64_t){
+          driveStatic(*machines[t], CYCLE, WITHDRAW);
+        }));
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+    AsyncLog::captureCout();
+
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runContentionBenchmark();
+        runDispenseBenchmark();
+        runEngineBenchmark();
+        runDispatchBenchmark();
+        runJournalBenchmark();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--load") {
+        runLoadSuite(LoadHarness::Options::parse(argc, argv));
+        return 0;
+    }
 
     cout << "\n========= ATM SYSTEM TEST CASES =========\n";
 
@@ -508,11 +2463,11 @@ int main() {
     ATMMachine atm;
 
     // Accounts
-    Account acc1("ACC001", 5000);   // normal
-    Account acc2("ACC002", 100);    // low balance
+    Account acc1("ACC001", 5000 * MINOR_PER_UNIT);   // normal
+    Account acc2("ACC002", 100 * MINOR_PER_UNIT);    // low balance
     Account acc3("ACC003", 0);      // zero balance
-    Account acc4("ACC004", 10000);  // high balance
-    Account acc5("ACC005", 50);     // edge case
+    Account acc4("ACC004", 10000 * MINOR_PER_UNIT);  // high balance
+    Account acc5("ACC005", 50 * MINOR_PER_UNIT);     // edge case
 
     atm.addAccount(&acc1);
     atm.addAccount(&acc2);
@@ -588,6 +2543,9 @@ int main() {
     atm.setCurrentState(atm.getCurrentState()->insertCard(&atm));
     atm.setCurrentState(atm.getCurrentState()->removeCard(&atm));
 
+    cout << "\n========= METRICS (Prometheus text) =========\n";
+    cout << Metrics::prometheusText();
+
     cout << "\n========= ALL TEST CASES COMPLETED =========\n";
 
     return 0;
@@ -0,0 +1,635 @@
+/*
+===========================================================
+ ASYNC LOG – shared by the real-world examples
+===========================================================
+
+WHY:
+`cout << ... << endl` formats on the calling thread and the
+endl forces a write() per line. Under load that flush is most
+of the cost of an operation.
+
+DESIGN:
+- every thread owns a single-producer ring buffer; logging is
+  a memcpy of the arguments into it (no lock, no syscall)
+- formatting is deferred: a record is
+    [header: size, stamp, call site][typed binary args]
+  and the call site (format string, level) is a static object,
+  so the text is only built by the background drain thread
+- the stamp is a per-thread clock read (TSC on x86), not a
+  shared counter, so producers never contend on a cache line
+- the drain thread merges all rings by stamp (the order in
+  which the calls were made), formats, and writes the text
+  to the sink in large chunks
+- diagnostics (WARN, ERROR) go to stderr, like cerr; pending
+  stdout text is written first so a terminal shows both in order
+- LOG_LEVEL picks the lowest level compiled in; calls below it
+  expand to nothing (arguments are not even evaluated):
+    g++ -DLOG_LEVEL=LOG_LEVEL_WARN file.cpp
+  so keep user-facing output on cout (captured below) and log
+  only diagnostics
+
+USAGE:
+    LOG_INFO("[NOTIFY] {} received: {}", name, payload);
+    AsyncLog::captureCout();      // plain cout text joins the same stream
+    AsyncLog::flush();            // block until everything is written
+    AsyncLog::Redirect quiet(nullptr);   // scoped: discard / capture output
+
+Arguments: integers, enums, bool (printed 1/0 like cout), char,
+floating point (printed like cout), C strings, string,
+string_view. Strings are copied, so temporaries are safe.
+===========================================================
+*/
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <type_traits>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF   4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+namespace AsyncLog {
+
+enum Level : uint8_t { DEBUG, INFO, WARN, ERROR };
+
+// One per call site, static: records only carry a pointer to it
+struct Site {
+    Level level;
+    const char* format;   // "{}" = next argument
+};
+
+enum ArgType : uint8_t { ARG_INT, ARG_UINT, ARG_DOUBLE, ARG_CHAR, ARG_STRING };
+
+struct RecordHeader {
+    uint32_t size;        // header + arguments, bytes
+    uint32_t argCount;
+    uint64_t stamp;       // merge key across threads
+    const Site* site;     // nullptr = raw text (captured cout)
+};
+
+// Invariant TSC is synchronized across cores; elsewhere a steady clock
+inline uint64_t stamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+const size_t RING_BYTES = 1 << 18;
+const size_t MAX_STRING = 4096;       // longer strings are cut
+
+/*
+Single producer (the owning thread), single consumer (the
+drain thread). head/tail count bytes forever; the position
+in data is the count modulo RING_BYTES.
+*/
+struct alignas(64) ThreadRing {
+    char data[RING_BYTES];
+    alignas(64) std::atomic<size_t> tail{0};   // written by the owner
+    alignas(64) std::atomic<size_t> head{0};   // written by the drain
+    std::atomic<bool> retired{false};          // owner thread has exited
+
+    std::string pendingText;                   // owner only: cout text not yet a record
+    uint64_t pendingStamp = 0;                 // when pendingText was started
+
+    void put(size_t at, const void* src, size_t n) {
+        size_t pos = at % RING_BYTES;
+        size_t first = std::min(n, RING_BYTES - pos);
+        memcpy(data + pos, src, first);
+        memcpy(data, static_cast<const char*>(src) + first, n - first);
+    }
+
+    void get(size_t at, void* dst, size_t n) const {
+        size_t pos = at % RING_BYTES;
+        size_t first = std::min(n, RING_BYTES - pos);
+        memcpy(dst, data + pos, first);
+        memcpy(static_cast<char*>(dst) + first, data, n - first);
+    }
+};
+
+class Logger {
+private:
+    std::mutex registryMtx;
+    std::vector<ThreadRing*> rings;
+
+    std::thread drainer;
+    std::mutex drainMtx;
+    std::condition_variable drainWanted;
+    std::condition_variable drained;
+    bool running = true;
+    uint64_t flushRequested = 0;
+    uint64_t flushCompleted = 0;
+    std::atomic<bool> ringFull{false};      // a producer is waiting for space
+
+    std::mutex sinkMtx;
+    std::streambuf* sink;
+    std::streambuf* errorSink;              // WARN and ERROR records
+    std::string out;
+
+    // One decoded argument appended as text
+    static size_t formatArg(const ThreadRing& ring, size_t at, std::string& text) {
+        uint8_t type;
+        ring.get(at, &type, 1);
+        at++;
+        char buffer[64];
+        switch (type) {
+            case ARG_INT: {
+                int64_t v; ring.get(at, &v, 8);
+                text.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), v).ptr - buffer);
+                return 9;
+            }
+            case ARG_UINT: {
+                uint64_t v; ring.get(at, &v, 8);
+                text.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), v).ptr - buffer);
+                return 9;
+            }
+            case ARG_DOUBLE: {
+                double v; ring.get(at, &v, 8);
+                text.append(buffer, snprintf(buffer, sizeof(buffer), "%g", v));
+                return 9;
+            }
+            case ARG_CHAR: {
+                char c; ring.get(at, &c, 1);
+                text.push_back(c);
+                return 2;
+            }
+            default: {
+                uint32_t length; ring.get(at, &length, 4);
+                size_t start = text.size();
+                text.resize(start + length);
+                ring.get(at + 4, &text[start], length);
+                return 5 + length;
+            }
+        }
+    }
+
+    void formatRecord(const ThreadRing& ring, size_t at, const RecordHeader& header) {
+        size_t argAt = at + sizeof(RecordHeader);
+        if (!header.site) {
+            size_t start = out.size();
+            out.resize(start + header.size - sizeof(RecordHeader));
+            ring.get(argAt, &out[start], header.size - sizeof(RecordHeader));
+            return;
+        }
+        const char* f = header.site->format;
+        uint32_t used = 0;
+        for (; *f; f++) {
+            if (f[0] == '{' && f[1] == '}' && used < header.argCount) {
+                argAt += formatArg(ring, argAt, out);
+                used++;
+                f++;
+            } else {
+                out.push_back(*f);
+            }
+        }
+        out.push_back('\n');
+    }
+
+    void writeOut(bool diagnostics = false) {
+        std::lock_guard<std::mutex> lock(sinkMtx);
+        std::streambuf* target = diagnostics ? errorSink : sink;
+        if (target && !out.empty()) {
+            target->sputn(out.data(), out.size());
+            target->pubsync();
+        }
+        out.clear();
+    }
+
+    // Everything visible now, oldest stamp first; true if anything was found
+    bool drainOnce() {
+        std::vector<ThreadRing*> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(registryMtx);
+            snapshot = rings;
+        }
+
+        bool any = false;
+        std::vector<size_t> ends(snapshot.size());
+        for (size_t i = 0; i < snapshot.size(); i++)
+            ends[i] = snapshot[i]->tail.load(std::memory_order_acquire);
+
+        while (true) {
+            ThreadRing* oldest = nullptr;
+            RecordHeader oldestHeader{};
+            for (size_t i = 0; i < snapshot.size(); i++) {
+                ThreadRing* ring = snapshot[i];
+                size_t head = ring->head.load(std::memory_order_relaxed);
+                if (head == ends[i])
+                    continue;
+                RecordHeader header;
+                ring->get(head, &header, sizeof(header));
+                if (!oldest || header.stamp < oldestHeader.stamp) {
+                    oldest = ring;
+                    oldestHeader = header;
+                }
+            }
+            if (!oldest)
+                break;
+            size_t head = oldest->head.load(std::memory_order_relaxed);
+            bool diagnostic = oldestHeader.site && oldestHeader.site->level >= WARN;
+            if (diagnostic)
+                writeOut();             // stdout text made before it goes first
+            formatRecord(*oldest, head, oldestHeader);
+            oldest->head.store(head + oldestHeader.size, std::memory_order_release);
+            any = true;
+            if (diagnostic || out.size() >= (1 << 16))
+                writeOut(diagnostic);
+        }
+        writeOut();
+
+        // Rings of finished threads go once they are empty
+        std::lock_guard<std::mutex> lock(registryMtx);
+        for (size_t i = 0; i < rings.size();) {
+            ThreadRing* ring = rings[i];
+            if (ring->retired.load(std::memory_order_acquire) &&
+                ring->head.load() == ring->tail.load()) {
+                delete ring;
+                rings[i] = rings.back();
+                rings.pop_back();
+            } else {
+                i++;
+            }
+        }
+        return any;
+    }
+
+    void drainLoop() {
+        std::unique_lock<std::mutex> lock(drainMtx);
+        while (true) {
+            uint64_t request = flushRequested;
+            bool stopping = !running;
+            ringFull.store(false);
+            lock.unlock();
+            while (drainOnce()) {}
+            lock.lock();
+            flushCompleted = request;
+            drained.notify_all();
+            if (stopping)
+                return;
+            drainWanted.wait_for(lock, std::chrono::milliseconds(1),
+                                 [this, request]() {
+                                     return !running || flushRequested != request || ringFull.load();
+                                 });
+        }
+    }
+
+public:
+    std::atomic<bool> discarding{false};
+
+    Logger() : sink(std::cout.rdbuf()), errorSink(std::cerr.rdbuf()) {
+        drainer = std::thread(&Logger::drainLoop, this);
+    }
+
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(drainMtx);
+            running = false;
+            drainWanted.notify_one();
+        }
+        drainer.join();
+    }
+
+    ThreadRing* registerRing() {
+        ThreadRing* ring = new ThreadRing;
+        std::lock_guard<std::mutex> lock(registryMtx);
+        rings.push_back(ring);
+        return ring;
+    }
+
+    void wakeForSpace() {
+        if (!ringFull.exchange(true)) {
+            std::lock_guard<std::mutex> lock(drainMtx);
+            drainWanted.notify_one();
+        }
+    }
+
+    // Returns once every record made before the call is written
+    void flush() {
+        std::unique_lock<std::mutex> lock(drainMtx);
+        uint64_t request = ++flushRequested;
+        drainWanted.notify_one();
+        drained.wait(lock, [this, request]() { return flushCompleted >= request; });
+    }
+
+    std::streambuf* setSink(std::streambuf* target) {
+        std::lock_guard<std::mutex> lock(sinkMtx);
+        std::streambuf* old = sink;
+        sink = target;
+        return old;
+    }
+
+    std::streambuf* getSink() {
+        std::lock_guard<std::mutex> lock(sinkMtx);
+        return sink;
+    }
+
+    std::streambuf* setErrorSink(std::streambuf* target) {
+        std::lock_guard<std::mutex> lock(sinkMtx);
+        std::streambuf* old = errorSink;
+        errorSink = target;
+        return old;
+    }
+};
+
+inline Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+// Owns this thread's ring; retires it when the thread exits
+struct RingHandle {
+    ThreadRing* ring = nullptr;
+    ~RingHandle();
+};
+
+inline ThreadRing& localRing() {
+    thread_local RingHandle handle;
+    if (!handle.ring)
+        handle.ring = logger().registerRing();
+    return *handle.ring;
+}
+
+/*
+Reserves `size` bytes in the calling thread's ring; if the
+drain is behind, waits for it (records are never dropped).
+Returns the byte position to write at.
+*/
+inline size_t reserve(ThreadRing& ring, size_t size) {
+    size_t tail = ring.tail.load(std::memory_order_relaxed);
+    while (tail + size - ring.head.load(std::memory_order_acquire) > RING_BYTES) {
+        logger().wakeForSpace();
+        std::this_thread::yield();
+    }
+    return tail;
+}
+
+inline void publishText(ThreadRing& ring, const char* text, size_t length, uint64_t when) {
+    while (length > 0) {
+        size_t chunk = std::min(length, MAX_STRING);
+        RecordHeader header{(uint32_t)(sizeof(RecordHeader) + chunk), 0, when, nullptr};
+        size_t at = reserve(ring, header.size);
+        ring.put(at, &header, sizeof(header));
+        ring.put(at + sizeof(header), text, chunk);
+        ring.tail.store(at + header.size, std::memory_order_release);
+        text += chunk;
+        length -= chunk;
+    }
+}
+
+// cout text of this thread goes first, so records stay in call order
+inline void publishPending(ThreadRing& ring) {
+    if (ring.pendingText.empty())
+        return;
+    publishText(ring, ring.pendingText.data(), ring.pendingText.size(), ring.pendingStamp);
+    ring.pendingText.clear();
+}
+
+inline RingHandle::~RingHandle() {
+    if (!ring)
+        return;
+    publishPending(*ring);
+    ring->retired.store(true, std::memory_order_release);
+}
+
+// ---- argument encoding ----
+
+template <class T>
+size_t encodedSize(const T& value) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, char>)
+        return 2;
+    else if constexpr (std::is_arithmetic_v<D> || std::is_enum_v<D>)
+        return 9;
+    else
+        return 5 + std::min(std::string_view(value).size(), MAX_STRING);
+}
+
+template <class T>
+size_t encode(ThreadRing& ring, size_t at, const T& value) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, char>) {
+        uint8_t type = ARG_CHAR;
+        ring.put(at, &type, 1);
+        ring.put(at + 1, &value, 1);
+        return 2;
+    } else if constexpr (std::is_floating_point_v<D>) {
+        uint8_t type = ARG_DOUBLE;
+        double v = value;
+        ring.put(at, &type, 1);
+        ring.put(at + 1, &v, 8);
+        return 9;
+    } else if constexpr (std::is_enum_v<D> || std::is_signed_v<D>) {
+        uint8_t type = ARG_INT;
+        int64_t v = (int64_t)value;
+        ring.put(at, &type, 1);
+        ring.put(at + 1, &v, 8);
+        return 9;
+    } else if constexpr (std::is_arithmetic_v<D>) {
+        uint8_t type = ARG_UINT;
+        uint64_t v = (uint64_t)value;
+        ring.put(at, &type, 1);
+        ring.put(at + 1, &v, 8);
+        return 9;
+    } else {
+        std::string_view text(value);
+        uint8_t type = ARG_STRING;
+        uint32_t length = (uint32_t)std::min(text.size(), MAX_STRING);
+        ring.put(at, &type, 1);
+        ring.put(at + 1, &length, 4);
+        ring.put(at + 5, text.data(), length);
+        return 5 + length;
+    }
+}
+
+// Only named inside sizeof by disabled log calls; never defined
+template <class... Args>
+int unevaluated(const char* format, const Args&... args);
+
+template <class... Args>
+void write(const Site& site, const Args&... args) {
+    Logger& log = logger();
+    if (log.discarding.load(std::memory_order_relaxed))
+        return;
+    ThreadRing& ring = localRing();
+    publishPending(ring);
+
+    size_t size = sizeof(RecordHeader) + (size_t(0) + ... + encodedSize(args));
+    RecordHeader header{(uint32_t)size, (uint32_t)sizeof...(Args), stamp(), &site};
+    size_t at = reserve(ring, size);
+    ring.put(at, &header, sizeof(header));
+    [[maybe_unused]] size_t argAt = at + sizeof(header);
+    ((argAt += encode(ring, argAt, args)), ...);
+    ring.tail.store(at + size, std::memory_order_release);
+}
+
+inline void flush() {
+    ThreadRing& ring = localRing();
+    publishPending(ring);
+    logger().flush();
+}
+
+/*
+cout's buffer while captureCout() is active: text collects per
+thread and becomes a raw record at each newline flush (endl,
+flush, cin prompt) or when it grows large. No syscall per line.
+*/
+class CoutBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        if (c == EOF)
+            return 0;
+        char ch = (char)c;
+        xsputn(&ch, 1);
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (logger().discarding.load(std::memory_order_relaxed))
+            return n;
+        ThreadRing& ring = localRing();
+        if (ring.pendingText.empty())
+            ring.pendingStamp = stamp();   // ordered by when the text was written
+        ring.pendingText.append(s, n);
+        if (ring.pendingText.size() >= MAX_STRING)
+            publishPending(ring);
+        return n;
+    }
+
+    int sync() override {
+        publishPending(localRing());
+        return 0;
+    }
+};
+
+// Flushing this stream waits for the drain (cin is tied to it)
+class PromptBuffer : public std::streambuf {
+protected:
+    int sync() override {
+        flush();
+        return 0;
+    }
+};
+
+/*
+Routes every later `cout <<` through the log, so plain output
+and LOG_* records come out in the order they were made. cin
+waits for the log before reading, so prompts show up first.
+*/
+inline void captureCout() {
+    static CoutBuffer coutBuffer;
+    static PromptBuffer promptBuffer;
+    static std::ostream prompt(&promptBuffer);
+    Logger& log = logger();
+    if (std::cout.rdbuf() == &coutBuffer)
+        return;
+    log.setSink(std::cout.rdbuf());
+    std::cout.rdbuf(&coutBuffer);
+    std::cin.tie(&prompt);
+
+    // Runs after main's thread_locals are gone (its ring is retired
+    // and published), before the logger itself is destroyed
+    std::atexit([]() {
+        logger().flush();
+        std::cout.rdbuf(logger().getSink());
+        std::cin.tie(&std::cout);
+    });
+}
+
+/*
+Scoped: everything logged meanwhile, diagnostics included, goes
+to `target` instead (nullptr = discard without formatting).
+Flushes on both ends.
+*/
+class Redirect {
+private:
+    std::streambuf* previous;
+    std::streambuf* previousErrors;
+    bool wasDiscarding;
+
+public:
+    explicit Redirect(std::streambuf* target) {
+        flush();
+        Logger& log = logger();
+        wasDiscarding = log.discarding.load();
+        previous = log.setSink(target);
+        previousErrors = log.setErrorSink(target);
+        log.discarding.store(target == nullptr);
+    }
+
+    ~Redirect() {
+        flush();
+        Logger& log = logger();
+        log.setSink(previous);
+        log.setErrorSink(previousErrors);
+        log.discarding.store(wasDiscarding);
+    }
+
+    Redirect(const Redirect&) = delete;
+    Redirect& operator=(const Redirect&) = delete;
+};
+
+} // namespace AsyncLog
+
+#define LOG_AT(LEVEL, FORMAT, ...)                                        \
+    do {                                                                  \
+        static const AsyncLog::Site logSite{LEVEL, FORMAT};               \
+        AsyncLog::write(logSite, ##__VA_ARGS__);                          \
+    } while (0)
+
+// Compiled out: sizeof never evaluates its operand, so no code and
+// no argument side effects, but variables used only here still count
+#define LOG_DISABLED(FORMAT, ...)                                         \
+    do {                                                                  \
+        (void)sizeof(AsyncLog::unevaluated(FORMAT, ##__VA_ARGS__));       \
+    } while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(FORMAT, ...) LOG_AT(AsyncLog::DEBUG, FORMAT, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(FORMAT, ...) LOG_DISABLED(FORMAT, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(FORMAT, ...) LOG_AT(AsyncLog::INFO, FORMAT, ##__VA_ARGS__)
+#else
+#define LOG_INFO(FORMAT, ...) LOG_DISABLED(FORMAT, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(FORMAT, ...) LOG_AT(AsyncLog::WARN, FORMAT, ##__VA_ARGS__)
+#else
+#define LOG_WARN(FORMAT, ...) LOG_DISABLED(FORMAT, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(FORMAT, ...) LOG_AT(AsyncLog::ERROR, FORMAT, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(FORMAT, ...) LOG_DISABLED(FORMAT, ##__VA_ARGS__)
+#endif
+
+#endif // ASYNC_LOG_H
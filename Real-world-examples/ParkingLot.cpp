@@ -42,7 +42,16 @@ KEY DESIGN IDEAS:
 - Vehicle is treated as an independent entity
 - Parking lot coordinates floors and spots
 - Fee and payment logic are kept separate
+- Every parked vehicle has a ticket (plate -> spot + entry time),
+  so exits are an O(1) plate lookup and fees use real stays
 - The system should handle parking failures gracefully
+- Spot allocation and release are O(1): every floor keeps a
+  free-spot bitmap per vehicle type, every lot keeps a bitmap
+  of floors that still have a free spot of that type
+- Each floor stores its spots as arrays (ids, types, free bits);
+  ParkingSpot objects are thin views over a row
+- Many entry gates can park at once without a global lock:
+  a spot is claimed by atomically clearing its free bit
 
 -----------------------------------------------------------
 FAILURE SCENARIOS HANDLED:
@@ -60,6 +69,25 @@ Build a modular and extensible parking system that:
 - Allows easy extension for new vehicle types
 - Supports different pricing and payment strategies
 
+-----------------------------------------------------------
+RUN:
+- ./parkinglot          -> demo
+- ./parkinglot --bench  -> allocation cost: bitmap index vs linear scan,
+                           dashboard scan: spot arrays vs spot views,
+                           ticket lookup: session table vs unordered_map,
+                           fees: per-call virtual vs batch calculateFees(),
+                           multi-gate stress + throughput (8-64 gates),
+                          logging: cout + endl vs AsyncLog per message,
+                          metrics: per-thread cells vs a shared atomic,
+                          exit payments: blocking pay vs async lanes
+- ./parkinglot --load   -> JSON lines (throughput, p50/p99/p999) for
+                           N gates: car visits, exit payments
+                           (flags: bench/LoadHarness.h)
+- g++ -DLOG_LEVEL=LOG_LEVEL_WARN ... -> INFO messages compiled out
+- the demo ends with a Metrics.h scrape (occupancy per type,
+  turned-away arrivals, stay lengths); -DMETRICS_ENABLED=0
+  compiles the metrics out
+
 ===========================================================
 */
 
@@ -68,6 +96,25 @@ Build a modular and extensible parking system that:
 #include <iostream>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+
+#include "AsyncLog.h"
+#include "Metrics.h"
+#include "../bench/LoadHarness.h"
+#include "../common/PaymentLane.h"
 
 using namespace std;
 
@@ -84,11 +131,215 @@ enum VehicleType {
     OTHERS
 };
 
+const int VEHICLE_TYPE_COUNT = OTHERS + 1;
+
 enum DurationType {
     HOUR,
     DAY
 };
 
+/*
+--------------------------------------------------
+FREE SPOT BITMAP
+--------------------------------------------------
+Hierarchical bitset, 64-way per level:
+- level 0 has one bit per slot (1 = free)
+- a bit in level k+1 is set when that word of level k is non-zero
+- first/next/previous free slot = a few find-first-set steps
+  (3 levels already cover 262,144 slots)
+
+Concurrency (resize() is setup-only, the rest is lock-free):
+- every word is atomic; set/clear are fetch_or/fetch_and
+- clear() returns true only for the caller that actually turned
+  the bit off, so it doubles as the CAS that claims a spot
+- a racing set/clear pair can leave a summary bit on over an
+  empty word; a search that lands on one repairs it and retries
+*/
+class FreeSpotBitmap {
+private:
+    // Copyable so vector::resize works during setup
+    struct Word {
+        atomic<uint64_t> bits{0};
+        Word() {}
+        Word(const Word& other) : bits(other.bits.load(memory_order_relaxed)) {}
+    };
+
+    // mutable: searches repair stale summary bits on the way
+    mutable vector<vector<Word>> levels;
+    size_t slotCount = 0;
+
+    static const long STALE = -2;
+
+    static uint64_t bitOf(size_t pos) { return 1ULL << (pos & 63); }
+    static int lowestBit(uint64_t word) { return __builtin_ctzll(word); }
+    static int highestBit(uint64_t word) { return 63 - __builtin_clzll(word); }
+
+    // Turn on bit `pos` of `level` and the summary bits above it;
+    // false if the bit was already on
+    bool setFrom(size_t level, size_t pos) const {
+        bool turnedOn = true;
+        for (size_t l = level; l < levels.size(); l++) {
+            uint64_t old = levels[l][pos >> 6].bits.fetch_or(bitOf(pos));
+            if (l == level)
+                turnedOn = !(old & bitOf(pos));
+            if (old != 0)
+                break;      // whoever made this word non-zero sets the summary
+            pos >>= 6;
+        }
+        return turnedOn;
+    }
+
+    // Word `word` of `level` went empty: clear its summary bit, then
+    // re-check in case a concurrent set() refilled it meanwhile
+    void emptied(size_t level, size_t word) const {
+        for (; level + 1 < levels.size(); level++) {
+            uint64_t old = levels[level + 1][word >> 6].bits.fetch_and(~bitOf(word));
+            if (levels[level][word].bits.load() != 0) {
+                setFrom(level + 1, word);
+                return;
+            }
+            if (!(old & bitOf(word)) || (old & ~bitOf(word)) != 0)
+                return;
+            word >>= 6;
+        }
+    }
+
+    // From set bit `pos` of `level`, walk down to a slot.
+    // STALE if a summary bit led to an empty word (repaired).
+    long descend(size_t pos, size_t level, bool lowest) const {
+        while (level > 0) {
+            level--;
+            uint64_t word = levels[level][pos].bits.load();
+            if (word == 0) {
+                emptied(level, pos);
+                return STALE;
+            }
+            pos = (pos << 6) | (lowest ? lowestBit(word) : highestBit(word));
+        }
+        return (long)pos;
+    }
+
+    long findNextOnce(size_t from) const {
+        size_t pos = from;
+        for (size_t level = 0; level < levels.size(); level++) {
+            size_t word = pos >> 6;
+            if (word >= levels[level].size())
+                return -1;
+            uint64_t bits = levels[level][word].bits.load() & (~0ULL << (pos & 63));
+            if (bits)
+                return descend((word << 6) | lowestBit(bits), level, true);
+            pos = word + 1;
+        }
+        return -1;
+    }
+
+    long findPrevOnce(size_t from) const {
+        size_t pos = min(from, slotCount - 1);
+        for (size_t level = 0; level < levels.size(); level++) {
+            size_t word = pos >> 6;
+            int bit = pos & 63;
+            uint64_t mask = (bit == 63) ? ~0ULL : ((1ULL << (bit + 1)) - 1);
+            uint64_t bits = levels[level][word].bits.load() & mask;
+            if (bits)
+                return descend((word << 6) | highestBit(bits), level, false);
+            if (word == 0)
+                return -1;
+            pos = word - 1;
+        }
+        return -1;
+    }
+
+public:
+    FreeSpotBitmap() : levels(1, vector<Word>(1)) {}
+
+    // Grows to n slots; new slots start occupied (bit clear).
+    // Not safe against concurrent use.
+    void resize(size_t n) {
+        slotCount = n;
+        size_t oldLevels = levels.size();
+        size_t words = (n + 63) / 64;
+        size_t level = 0;
+        while (true) {
+            if (levels.size() <= level)
+                levels.push_back({});
+            levels[level].resize(max<size_t>(words, 1));
+            if (words <= 1)
+                break;
+            words = (words + 63) / 64;
+            level++;
+        }
+        // A new top level starts empty: fill it from the level below
+        for (size_t l = oldLevels; l < levels.size(); l++)
+            for (size_t w = 0; w < levels[l - 1].size(); w++)
+                if (levels[l - 1][w].bits.load())
+                    levels[l][w >> 6].bits.fetch_or(bitOf(w));
+    }
+
+    size_t size() const {
+        return slotCount;
+    }
+
+    // True if this call turned the bit on
+    bool set(size_t slot) {
+        return setFrom(0, slot);
+    }
+
+    // True if this call turned the bit off (i.e. won the claim)
+    bool clear(size_t slot) {
+        uint64_t old = levels[0][slot >> 6].bits.fetch_and(~bitOf(slot));
+        if (!(old & bitOf(slot)))
+            return false;
+        if ((old & ~bitOf(slot)) == 0)
+            emptied(0, slot >> 6);
+        return true;
+    }
+
+    bool test(size_t slot) const {
+        return (levels[0][slot >> 6].bits.load() >> (slot & 63)) & 1;
+    }
+
+    // Free slots in [from, to): popcount over level 0, 64 slots per step
+    size_t countRange(size_t from, size_t to) const {
+        to = min(to, slotCount);
+        if (from >= to)
+            return 0;
+        size_t first = from >> 6, last = (to - 1) >> 6;
+        uint64_t headMask = ~0ULL << (from & 63);
+        uint64_t tailMask = (to & 63) ? (1ULL << (to & 63)) - 1 : ~0ULL;
+        if (first == last)
+            return __builtin_popcountll(levels[0][first].bits.load() & headMask & tailMask);
+
+        size_t total = __builtin_popcountll(levels[0][first].bits.load() & headMask);
+        for (size_t w = first + 1; w < last; w++)
+            total += __builtin_popcountll(levels[0][w].bits.load(memory_order_relaxed));
+        return total + __builtin_popcountll(levels[0][last].bits.load() & tailMask);
+    }
+
+    long findFirst() const {
+        return findNext(0);
+    }
+
+    // First free slot >= from
+    long findNext(size_t from) const {
+        long slot;
+        do {
+            slot = findNextOnce(from);
+        } while (slot == STALE);
+        return slot;
+    }
+
+    // Last free slot <= from
+    long findPrev(size_t from) const {
+        if (slotCount == 0)
+            return -1;
+        long slot;
+        do {
+            slot = findPrevOnce(from);
+        } while (slot == STALE);
+        return slot;
+    }
+};
+
 /*
 --------------------------------------------------
 VEHICLE
@@ -119,38 +370,44 @@ public:
 PARKING SPOT
 --------------------------------------------------
 Represents a physical parking space.
+Until it is added to a floor the spot holds its own id, type
+and occupancy. After addSpot() the floor's arrays own that
+data and the spot is a thin view over its row: park()/unpark()
+claim/release the row, getters read it. Both are safe to call
+from several gates at once: exactly one park() wins a free spot.
 */
 
+class ParkingFloor;
+
 class ParkingSpot {
 protected:
     int spotId;
-    bool isEmpty;
+    atomic<bool> isEmpty;
     VehicleType spotType;
 
+    ParkingFloor* floor = nullptr;  // set by ParkingFloor::addSpot
+    int slot = -1;                  // row in the floor's arrays
+
 public:
     ParkingSpot(int id, VehicleType type)
         : spotId(id), isEmpty(true), spotType(type) {}
 
     virtual bool canPark(VehicleType vehicleType) = 0;
 
-    bool park() {
-        if (isEmpty) {
-            isEmpty = false;
-            return true;
-        }
-        return false;
-    }
+    bool park();
+    void unpark();
 
-    void unpark() {
-        isEmpty = true;
-    }
+    bool isAvailable() const;
+    int getSpotId() const;
+    VehicleType getSpotType() const;
 
-    bool isAvailable() const {
-        return isEmpty;
+    void attachTo(ParkingFloor* owner, int index) {
+        floor = owner;
+        slot = index;
     }
 
-    int getSpotId() const {
-        return spotId;
+    int getSlot() const {
+        return slot;
     }
 
     virtual ~ParkingSpot() {}
@@ -194,28 +451,407 @@ public:
 PARKING FLOOR
 --------------------------------------------------
 A floor contains multiple parking spots.
+
+Spot storage is structure-of-arrays, one row per spot:
+- spotIds[row], spotTypes[row]  (contiguous, 5 bytes a spot)
+- freeSlots[type] bit `row` set while that row is a free spot
+  of that type (so one bitmap per type doubles as the
+  occupancy bits and the free-spot index)
+- spots[row] is the ParkingSpot view handed to callers
+Scans and dashboards only touch the arrays: a type count is a
+byte compare loop, a free count is a popcount per 64 spots.
+A spot is indexed under its own spotType, so canPark() must
+mean "vehicle type == spot type" (true for all spots here).
+
+Each floor is its own shard: gates only touch the bitmap and
+counters of the floor they are claiming on. Claiming a spot
+is clearing its bit, so no lock is needed:
+- claim:   clear bit (the CAS) -> count--
+- release: set bit (only one releaser turns it on) -> count++
+addSpot() is setup-only.
 */
 
+class ParkingLot;
+
+// Free/total spots of one type in one zone (a run of rows)
+struct ZoneOccupancy {
+    int floorNumber;
+    int zone;
+    int total;
+    int free;
+};
+
 class ParkingFloor {
 private:
     int floorNumber;
+
+    vector<int> spotIds;
+    vector<uint8_t> spotTypes;
     vector<ParkingSpot*> spots;
 
+    FreeSpotBitmap freeSlots[VEHICLE_TYPE_COUNT];
+    atomic<int> freeCount[VEHICLE_TYPE_COUNT] = {};
+
+    ParkingLot* lot = nullptr;      // set by ParkingLot::addFloor
+    int lotIndex = -1;
+
+    void setAvailable(VehicleType type, bool hasFree);
+
+    // Spreads gates over the bitmap so they don't all race for
+    // the lowest free bit (gate 0 keeps lowest-slot-first order)
+    static size_t gateOffset(unsigned gate, size_t slots) {
+        return (size_t)((gate * 2654435761ULL) % slots);
+    }
+
+    static bool validType(VehicleType type) {
+        return type >= 0 && type < VEHICLE_TYPE_COUNT;
+    }
+
 public:
     ParkingFloor(int floorNumber) : floorNumber(floorNumber) {}
 
     void addSpot(ParkingSpot* spot) {
+        int row = (int)spots.size();
+        bool wasFree = spot->isAvailable();
+
+        spotIds.push_back(spot->getSpotId());
+        spotTypes.push_back((uint8_t)spot->getSpotType());
         spots.push_back(spot);
+        for (auto& free : freeSlots)
+            free.resize(row + 1);
+
+        spot->attachTo(this, row);
+        if (wasFree)
+            releaseSlot(row);
     }
 
+    // O(1): first free spot of this type (peek only, another gate
+    // may take it first - use claimSpot() to actually get one)
     ParkingSpot* getAvailableSpot(VehicleType vehicleType) {
-        for (auto spot : spots) {
-            if (spot->isAvailable() && spot->canPark(vehicleType)) {
-                return spot;
+        if (!validType(vehicleType))
+            return nullptr;
+        long row = freeSlots[vehicleType].findFirst();
+        return row < 0 ? nullptr : spots[row];
+    }
+
+    // Lock-free: finds and claims a free spot of this type,
+    // nullptr once the floor has none left
+    ParkingSpot* claimSpot(VehicleType vehicleType, unsigned gate = 0) {
+        if (!validType(vehicleType) || spots.empty())
+            return nullptr;
+        FreeSpotBitmap& free = freeSlots[vehicleType];
+
+        size_t start = gateOffset(gate, spots.size());
+        while (true) {
+            long row = free.findNext(start);
+            if (row < 0)
+                row = free.findFirst();
+            if (row < 0)
+                return nullptr;
+            if (claimSlot(row))
+                return spots[row];
+            // another gate won this row: search again
+        }
+    }
+
+    // Reference O(spots) scan, kept for comparison
+    ParkingSpot* findAvailableSpotByScan(VehicleType vehicleType) {
+        if (!validType(vehicleType))
+            return nullptr;
+        for (size_t row = 0; row < spots.size(); row++) {
+            if (spotTypes[row] == vehicleType && freeSlots[vehicleType].test(row)) {
+                return spots[row];
             }
         }
         return nullptr;
     }
+
+    // False if the row was not free (another gate got it)
+    bool claimSlot(size_t row) {
+        VehicleType type = (VehicleType)spotTypes[row];
+        if (!freeSlots[type].clear(row))
+            return false;
+        if (freeCount[type].fetch_sub(1) == 1) {
+            setAvailable(type, false);
+            // a release may have raced the drop to zero
+            if (freeCount[type] > 0)
+                setAvailable(type, true);
+        }
+        return true;
+    }
+
+    // No-op if the row is already free
+    void releaseSlot(size_t row) {
+        VehicleType type = (VehicleType)spotTypes[row];
+        if (!freeSlots[type].set(row))
+            return;
+        if (freeCount[type].fetch_add(1) == 0)
+            setAvailable(type, true);
+    }
+
+    bool isFree(size_t row) const {
+        return freeSlots[spotTypes[row]].test(row);
+    }
+
+    int spotIdAt(size_t row) const {
+        return spotIds[row];
+    }
+
+    VehicleType spotTypeAt(size_t row) const {
+        return (VehicleType)spotTypes[row];
+    }
+
+    // Dashboard: free/total of `type` per zone of zoneSize rows
+    void appendOccupancy(VehicleType type, int zoneSize,
+                         vector<ZoneOccupancy>& out) const {
+        if (!validType(type) || zoneSize <= 0)
+            return;
+        for (size_t from = 0; from < spots.size(); from += zoneSize) {
+            size_t to = min(spots.size(), from + zoneSize);
+            int total = 0;
+            for (size_t row = from; row < to; row++)
+                total += (spotTypes[row] == type);
+            int free = (int)freeSlots[type].countRange(from, to);
+            out.push_back({floorNumber, (int)(from / zoneSize), total, free});
+        }
+    }
+
+    const vector<ParkingSpot*>& getSpots() const {
+        return spots;
+    }
+
+    int getFreeCount(VehicleType type) const {
+        return freeCount[type];
+    }
+
+    int getFloorNumber() const {
+        return floorNumber;
+    }
+
+    void attachTo(ParkingLot* owner, int index) {
+        lot = owner;
+        lotIndex = index;
+    }
+};
+
+bool ParkingSpot::park() {
+    if (floor)
+        return floor->claimSlot(slot);
+    bool expected = true;
+    return isEmpty.compare_exchange_strong(expected, false);
+}
+
+void ParkingSpot::unpark() {
+    if (floor)
+        floor->releaseSlot(slot);
+    else
+        isEmpty = true;
+}
+
+bool ParkingSpot::isAvailable() const {
+    return floor ? floor->isFree(slot) : isEmpty.load();
+}
+
+int ParkingSpot::getSpotId() const {
+    return floor ? floor->spotIdAt(slot) : spotId;
+}
+
+VehicleType ParkingSpot::getSpotType() const {
+    return floor ? floor->spotTypeAt(slot) : spotType;
+}
+
+/*
+--------------------------------------------------
+CLOCK
+--------------------------------------------------
+Entry/exit timestamps come from a Clock so fees are based
+on real stays; tests and the demo swap in a ManualClock.
+*/
+
+class Clock {
+public:
+    virtual int64_t nowSeconds() = 0;
+    virtual ~Clock() {}
+};
+
+class SystemClock : public Clock {
+public:
+    int64_t nowSeconds() override {
+        return chrono::duration_cast<chrono::seconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+    }
+};
+
+class ManualClock : public Clock {
+private:
+    atomic<int64_t> now;
+
+public:
+    ManualClock(int64_t start) : now(start) {}
+
+    int64_t nowSeconds() override {
+        return now;
+    }
+
+    void advance(int64_t seconds) {
+        now += seconds;
+    }
+};
+
+/*
+--------------------------------------------------
+PARKING TICKETS (SESSION TABLE)
+--------------------------------------------------
+One ticket per vehicle inside, keyed by plate number:
+- open addressing, linear probing, power-of-two capacity
+- the plate hash and entry time sit next to the spot pointer,
+  so a lookup usually touches one slot
+- deletion shifts the following run back (no tombstones)
+- SHARD_COUNT independent tables, each behind its own mutex,
+  picked by the top hash bits: gates on different shards
+  never wait on each other
+*/
+
+struct ParkingTicket {
+    string vehicleNumber;
+    VehicleType vehicleType;
+    ParkingSpot* spot;
+    int64_t entryTime;
+};
+
+class SessionTable {
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        ParkingSpot* spot = nullptr;    // nullptr = empty slot
+        int64_t entryTime = 0;
+        VehicleType vehicleType = OTHERS;
+        string vehicleNumber;
+    };
+
+    struct alignas(64) Shard {
+        mutex lock;
+        vector<Entry> entries = vector<Entry>(16);
+        size_t count = 0;
+    };
+
+    static const int SHARD_BITS = 4;
+    static const int SHARD_COUNT = 1 << SHARD_BITS;
+    Shard shards[SHARD_COUNT];
+
+    // FNV-1a
+    static uint64_t hashPlate(const string& plate) {
+        uint64_t hash = 1469598103934665603ULL;
+        for (unsigned char c : plate) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    Shard& shardFor(uint64_t hash) {
+        return shards[hash >> (64 - SHARD_BITS)];
+    }
+
+    // Slot holding the plate, or the empty slot ending its probe run
+    static size_t probe(const Shard& shard, uint64_t hash, const string& plate) {
+        size_t mask = shard.entries.size() - 1;
+        size_t i = hash & mask;
+        while (shard.entries[i].spot &&
+               !(shard.entries[i].hash == hash && shard.entries[i].vehicleNumber == plate))
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    static void grow(Shard& shard) {
+        vector<Entry> old(shard.entries.size() * 2);
+        old.swap(shard.entries);
+        size_t mask = shard.entries.size() - 1;
+        for (auto& entry : old) {
+            if (!entry.spot)
+                continue;
+            size_t i = entry.hash & mask;
+            while (shard.entries[i].spot)
+                i = (i + 1) & mask;
+            shard.entries[i] = move(entry);
+        }
+    }
+
+    static ParkingTicket toTicket(const Entry& entry) {
+        return {entry.vehicleNumber, entry.vehicleType, entry.spot, entry.entryTime};
+    }
+
+public:
+    // False if the plate already has a ticket
+    bool insert(const ParkingTicket& ticket) {
+        uint64_t hash = hashPlate(ticket.vehicleNumber);
+        Shard& shard = shardFor(hash);
+        lock_guard<mutex> guard(shard.lock);
+
+        if ((shard.count + 1) * 10 > shard.entries.size() * 7)
+            grow(shard);
+        size_t i = probe(shard, hash, ticket.vehicleNumber);
+        if (shard.entries[i].spot)
+            return false;
+
+        Entry& entry = shard.entries[i];
+        entry.hash = hash;
+        entry.spot = ticket.spot;
+        entry.entryTime = ticket.entryTime;
+        entry.vehicleType = ticket.vehicleType;
+        entry.vehicleNumber = ticket.vehicleNumber;
+        shard.count++;
+        return true;
+    }
+
+    bool find(const string& plate, ParkingTicket& out) {
+        uint64_t hash = hashPlate(plate);
+        Shard& shard = shardFor(hash);
+        lock_guard<mutex> guard(shard.lock);
+
+        size_t i = probe(shard, hash, plate);
+        if (!shard.entries[i].spot)
+            return false;
+        out = toTicket(shard.entries[i]);
+        return true;
+    }
+
+    bool erase(const string& plate, ParkingTicket& out) {
+        uint64_t hash = hashPlate(plate);
+        Shard& shard = shardFor(hash);
+        lock_guard<mutex> guard(shard.lock);
+
+        size_t i = probe(shard, hash, plate);
+        if (!shard.entries[i].spot)
+            return false;
+        out = toTicket(shard.entries[i]);
+
+        // Backward shift: pull later entries of the run into the hole
+        // unless their home slot lies cyclically in (hole, j]
+        size_t mask = shard.entries.size() - 1;
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask; shard.entries[j].spot; j = (j + 1) & mask) {
+            size_t home = shard.entries[j].hash & mask;
+            bool staysPut = (hole <= j) ? (hole < home && home <= j)
+                                        : (hole < home || home <= j);
+            if (staysPut)
+                continue;
+            shard.entries[hole] = move(shard.entries[j]);
+            hole = j;
+        }
+        shard.entries[hole] = Entry();
+        shard.count--;
+        return true;
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (auto& shard : shards) {
+            lock_guard<mutex> guard(shard.lock);
+            total += shard.count;
+        }
+        return total;
+    }
 };
 
 /*
@@ -223,69 +859,373 @@ public:
 PARKING LOT (SINGLETON)
 --------------------------------------------------
 Manages all floors.
+Floors are added bottom-up; floorsWithFree[type] marks the
+floors that still have a free spot of that type, so picking a
+floor never loops over full ones.
+
+Multi-gate: claimSpot() takes no lock. Gate g starts on floor
+g % floors, so gates fan out over floor shards and only meet
+once floors fill up. Floors must all be added before gates
+start (addFloor() is setup-only).
 */
 
 class ParkingLot {
 private:
     vector<ParkingFloor*> floors;
+    FreeSpotBitmap floorsWithFree[VEHICLE_TYPE_COUNT];
+    unordered_map<int, int> floorIndexByNumber;
+
+    SessionTable tickets;
+    SystemClock systemClock;
+    Clock* clock = &systemClock;
+
+    // Per vehicle type, resolved once; updated on every entry / exit
+    Metrics::Gauge* occupied[VEHICLE_TYPE_COUNT];
+    Metrics::Counter* turnedAway[VEHICLE_TYPE_COUNT];
+    Metrics::Histogram& staySeconds = Metrics::histogram(
+        "parking_stay_seconds", "Time from entry to exit");
+
+    ParkingLot() {
+        static const char* TYPE_LABELS[VEHICLE_TYPE_COUNT] = {
+            "type=\"bike\"", "type=\"car\"", "type=\"truck\"", "type=\"others\""};
+        for (int type = 0; type < VEHICLE_TYPE_COUNT; type++) {
+            occupied[type] = &Metrics::gauge("parking_occupied_spots",
+                "Vehicles currently parked", TYPE_LABELS[type]);
+            turnedAway[type] = &Metrics::counter("parking_turned_away_total",
+                "Arrivals that found no free spot", TYPE_LABELS[type]);
+        }
+    }
 
-    ParkingLot() {}
+    // Opens the vehicle's ticket on a claimed spot
+    ParkingSpot* checkIn(const Vehicle& vehicle, ParkingSpot* spot) {
+        if (!spot) {
+            if (validType(vehicle.getType()))
+                turnedAway[vehicle.getType()]->inc();
+            LOG_WARN("No available spot!");
+            return nullptr;
+        }
+        ParkingTicket ticket = {vehicle.getVehicleNumber(), vehicle.getType(),
+                                spot, clock->nowSeconds()};
+        if (!tickets.insert(ticket)) {
+            spot->unpark();
+            LOG_INFO("Vehicle {} is already parked!", vehicle.getVehicleNumber());
+            return nullptr;
+        }
+        if (validType(vehicle.getType()))
+            occupied[vehicle.getType()]->add(1);
+        LOG_INFO("Vehicle parked at spot: {}", spot->getSpotId());
+        return spot;
+    }
+
+    bool validType(VehicleType type) const {
+        return type >= 0 && type < VEHICLE_TYPE_COUNT;
+    }
+
+    // Floor index nearest to gateIndex with a free spot (ties go down)
+    long nearestFloorWithFree(VehicleType type, int gateIndex) const {
+        long up = floorsWithFree[type].findNext(gateIndex);
+        long down = floorsWithFree[type].findPrev(gateIndex);
+        if (down >= 0 && (up < 0 || gateIndex - down <= up - gateIndex))
+            return down;
+        return up;
+    }
 
 public:
+    /*
+     Function-local static: construction is thread-safe and lazy.
+     Every later call still checks the init guard (one acquire load
+     + branch, well under a nanosecond), so hot paths fetch the
+     reference once and pass it down instead of calling this per
+     operation (main and the benchmarks do; floors are handed a
+     pointer in addFloor).
+    */
     static ParkingLot& getInstance() {
         static ParkingLot instance;
         return instance;
     }
 
     void addFloor(ParkingFloor* floor) {
+        int index = (int)floors.size();
         floors.push_back(floor);
+        floorIndexByNumber[floor->getFloorNumber()] = index;
+        floor->attachTo(this, index);
+        for (int type = 0; type < VEHICLE_TYPE_COUNT; type++) {
+            floorsWithFree[type].resize(floors.size());
+            if (floor->getFreeCount((VehicleType)type) > 0)
+                floorsWithFree[type].set(index);
+        }
+    }
+
+    // Called by ParkingFloor when it runs out of / regains a type
+    void onFloorAvailability(int index, VehicleType type, bool hasFree) {
+        if (hasFree)
+            floorsWithFree[type].set(index);
+        else
+            floorsWithFree[type].clear(index);
+    }
+
+    // O(1): free spot on the lowest floor that has one (peek only)
+    ParkingSpot* findSpot(VehicleType type) const {
+        if (!validType(type))
+            return nullptr;
+        long index = floorsWithFree[type].findFirst();
+        return index < 0 ? nullptr : floors[index]->getAvailableSpot(type);
+    }
+
+    // O(1): free spot on the floor nearest to gateFloorNumber (peek only)
+    ParkingSpot* findSpotNear(VehicleType type, int gateFloorNumber) const {
+        auto gate = floorIndexByNumber.find(gateFloorNumber);
+        if (!validType(type) || gate == floorIndexByNumber.end())
+            return findSpot(type);
+
+        long best = nearestFloorWithFree(type, gate->second);
+        return best < 0 ? nullptr : floors[best]->getAvailableSpot(type);
+    }
+
+    /*
+     Lock-free claim for entry gate `gate`; nullptr when the lot is full.
+     Gate 0 keeps the lowest-floor, lowest-slot order.
+     Under churn a pass can miss (floors fill and free up behind it,
+     or a floor's bit lags its count): the free counts decide whether
+     to scan again, so nullptr only means every count read zero.
+    */
+    ParkingSpot* claimSpot(VehicleType type, unsigned gate = 0) {
+        if (!validType(type) || floors.empty())
+            return nullptr;
+
+        do {
+            size_t start = gate % floors.size();
+            for (size_t tried = 0; tried < floors.size(); tried++) {
+                long index = floorsWithFree[type].findNext(start);
+                if (index < 0)
+                    index = floorsWithFree[type].findFirst();
+                if (index < 0)
+                    break;
+                ParkingSpot* spot = floors[index]->claimSpot(type, gate);
+                if (spot)
+                    return spot;
+                // floor filled up after we looked: try the next one
+                start = (index + 1) % floors.size();
+            }
+        } while (getFreeCount(type) > 0);
+        return nullptr;
+    }
+
+    // Lock-free claim on the floor nearest to gateFloorNumber
+    ParkingSpot* claimSpotNear(VehicleType type, int gateFloorNumber) {
+        auto gate = floorIndexByNumber.find(gateFloorNumber);
+        if (!validType(type) || gate == floorIndexByNumber.end())
+            return claimSpot(type);
+
+        for (size_t tried = 0; tried < floors.size(); tried++) {
+            long best = nearestFloorWithFree(type, gate->second);
+            if (best < 0)
+                return nullptr;
+            ParkingSpot* spot = floors[best]->claimSpot(type);
+            if (spot)
+                return spot;
+        }
+        return claimSpot(type);
     }
 
+    // Same order as before: lowest floor first
     ParkingSpot* parkVehicle(const Vehicle& vehicle) {
+        return checkIn(vehicle, claimSpot(vehicle.getType()));
+    }
+
+    // Nearest-floor preference for an entry gate
+    ParkingSpot* parkVehicle(const Vehicle& vehicle, int gateFloorNumber) {
+        return checkIn(vehicle, claimSpotNear(vehicle.getType(), gateFloorNumber));
+    }
+
+    // O(1): the open ticket for a plate, false if it is not inside
+    bool getTicket(const string& vehicleNumber, ParkingTicket& ticket) {
+        return tickets.find(vehicleNumber, ticket);
+    }
+
+    // O(1): closes the ticket and frees its spot; false for an
+    // unknown plate (invalid exit request)
+    bool exitVehicle(const string& vehicleNumber) {
+        ParkingTicket ticket;
+        if (!tickets.erase(vehicleNumber, ticket))
+            return false;
+        ticket.spot->unpark();
+        if (validType(ticket.vehicleType))
+            occupied[ticket.vehicleType]->add(-1);
+        staySeconds.record((uint64_t)max<int64_t>(0, clock->nowSeconds() - ticket.entryTime));
+        return true;
+    }
+
+    size_t getActiveTickets() {
+        return tickets.size();
+    }
+
+    // Setup-only: swap the time source (e.g. a ManualClock)
+    void setClock(Clock* source) {
+        clock = source;
+    }
+
+    int64_t now() const {
+        return clock->nowSeconds();
+    }
+
+    // Reference O(floors x spots) search, kept for comparison
+    ParkingSpot* findSpotByScan(VehicleType type) const {
         for (auto floor : floors) {
-            ParkingSpot* spot = floor->getAvailableSpot(vehicle.getType());
-            if (spot && spot->park()) {
-                cout << "Vehicle parked at spot: "
-                     << spot->getSpotId() << endl;
+            ParkingSpot* spot = floor->findAvailableSpotByScan(type);
+            if (spot)
                 return spot;
-            }
         }
-        cout << "No available spot!" << endl;
         return nullptr;
     }
+
+    int getFreeCount(VehicleType type) const {
+        int total = 0;
+        for (auto floor : floors)
+            total += floor->getFreeCount(type);
+        return total;
+    }
+
+    // Dashboard over every floor, read straight from the spot arrays
+    vector<ZoneOccupancy> occupancyMap(VehicleType type, int zoneSize) const {
+        vector<ZoneOccupancy> zones;
+        for (auto floor : floors)
+            floor->appendOccupancy(type, zoneSize, zones);
+        return zones;
+    }
+
+    const vector<ParkingFloor*>& getFloors() const {
+        return floors;
+    }
 };
 
+void ParkingFloor::setAvailable(VehicleType type, bool hasFree) {
+    if (lot)
+        lot->onFloorAvailability(lotIndex, type, hasFree);
+}
+
 /*
 --------------------------------------------------
 PARKING FEE STRATEGY
 --------------------------------------------------
+Two ways to price:
+- calculateFee(...)                one stay, virtual call
+- calculateFees(sessions, n, out)  a whole batch (nightly
+  reconciliation), a loop over calculateSessionFee()
+Rates come from the FEE_RATES table. The batch has no table
+kernel of its own: a table loop did not vectorize (the
+FEE_RATES / tariff lookups are gathers) and measured slower
+than the per-call path, which is bound by streaming the
+sessions anyway. Going through calculateSessionFee() also
+keeps a subclass that only overrides calculateFee() correct
+in batches.
 */
 
+// Rs per unit: FEE_RATES[vehicleType][durationType]
+constexpr int FEE_RATES[VEHICLE_TYPE_COUNT][2] = {
+    {10, 10 * 24},      // BIKE
+    {15, 15 * 24},      // CAR
+    {20, 20 * 24},      // TRUCK
+    {18, 18 * 24},      // OTHERS
+};
+
+// One stay to bill; small and flat so batches stream well
+struct BillableSession {
+    uint8_t vehicleType;    // VehicleType
+    uint8_t durationType;   // DurationType
+    uint8_t entryHour;      // 0-23, UTC hour of entry
+    int32_t duration;
+};
+
+// Every started hour is billed; hour of day is taken in UTC
+BillableSession makeBillable(VehicleType type, int64_t entryTime, int64_t exitTime) {
+    int64_t seconds = max<int64_t>(exitTime - entryTime, 0);
+    int hours = (int)max<int64_t>((seconds + 3599) / 3600, 1);
+    if (type < 0 || type >= VEHICLE_TYPE_COUNT)
+        type = OTHERS;
+    int entryHour = (int)(((entryTime / 3600) % 24 + 24) % 24);
+    return {(uint8_t)type, (uint8_t)HOUR, (uint8_t)entryHour, hours};
+}
+
+// Percent applied by hour of entry; 100 everywhere = no surcharge
+struct Tariff {
+    int percentByHour[24];
+
+    static Tariff flat(int percent = 100) {
+        Tariff tariff;
+        for (int& p : tariff.percentByHour)
+            p = percent;
+        return tariff;
+    }
+
+    // Hours [fromHour, toHour), wrapping past midnight
+    Tariff& peak(int fromHour, int toHour, int percent) {
+        for (int h = fromHour; h != toHour; h = (h + 1) % 24)
+            percentByHour[h] = percent;
+        return *this;
+    }
+};
+
 class ParkingFeeStrategy {
 public:
     virtual int calculateFee(int duration,
                              DurationType durationType,
                              VehicleType vehicleType) = 0;
+
+    // Time-aware pricing hook; flat strategies ignore entryHour
+    virtual int calculateSessionFee(const BillableSession& session) {
+        return calculateFee(session.duration, (DurationType)session.durationType,
+                            (VehicleType)session.vehicleType);
+    }
+
+    virtual void calculateFees(const BillableSession* sessions, size_t count, int* out) {
+        for (size_t i = 0; i < count; i++)
+            out[i] = calculateSessionFee(sessions[i]);
+    }
+
+    void calculateFees(const vector<BillableSession>& sessions, vector<int>& out) {
+        out.resize(sessions.size());
+        calculateFees(sessions.data(), sessions.size(), out.data());
+    }
+
+    // From ticket timestamps: every started hour is billed
+    int calculateFee(int64_t entryTime, int64_t exitTime,
+                     VehicleType vehicleType) {
+        return calculateSessionFee(makeBillable(vehicleType, entryTime, exitTime));
+    }
+
     virtual ~ParkingFeeStrategy() {}
 };
 
 class BasicFeeStrategy : public ParkingFeeStrategy {
 public:
+    using ParkingFeeStrategy::calculateFee;
+
     int calculateFee(int duration,
                      DurationType durationType,
                      VehicleType vehicleType) override {
+        if (vehicleType < 0 || vehicleType >= VEHICLE_TYPE_COUNT)
+            vehicleType = OTHERS;
+        return FEE_RATES[vehicleType][durationType == DAY] * duration;
+    }
+};
 
-        int rate;
+/*
+Surge / time-of-day pricing: base rates scaled by the tariff
+percentage for the hour the vehicle entered.
+*/
+class TariffFeeStrategy : public BasicFeeStrategy {
+private:
+    Tariff tariff;
 
-        if (vehicleType == BIKE) rate = 10;
-        else if (vehicleType == CAR) rate = 15;
-        else if (vehicleType == TRUCK) rate = 20;
-        else rate = 18;
+public:
+    using BasicFeeStrategy::calculateFee;
 
-        if (durationType == DAY)
-            return rate * duration * 24;
+    TariffFeeStrategy(const Tariff& tariff) : tariff(tariff) {}
 
-        return rate * duration;
+    int calculateSessionFee(const BillableSession& session) override {
+        return BasicFeeStrategy::calculateSessionFee(session)
+               * tariff.percentByHour[session.entryHour < 24 ? session.entryHour : 0] / 100;
     }
 };
 
@@ -295,39 +1235,689 @@ PAYMENT STRATEGY
 --------------------------------------------------
 */
 
-class PaymentStrategy {
-public:
-    virtual void pay(int amount) = 0;
-    virtual ~PaymentStrategy() {}
-};
+// PaymentStrategy and PaymentStatus: ../common/PaymentLane.h
 
 class CardPayment : public PaymentStrategy {
 public:
-    void pay(int amount) override {
-        cout << "Paid Rs " << amount << " using Card" << endl;
+    PaymentStatus pay(int amount) override {
+        LOG_INFO("Paid Rs {} using Card", amount);
+        return APPROVED;
     }
 };
 
 class UpiPayment : public PaymentStrategy {
 public:
-    void pay(int amount) override {
-        cout << "Paid Rs " << amount << " using UPI" << endl;
+    PaymentStatus pay(int amount) override {
+        LOG_INFO("Paid Rs {} using UPI", amount);
+        return APPROVED;
     }
 };
 
+/*
+--------------------------------------------------
+ASYNC PAYMENTS
+--------------------------------------------------
+Each payment is a network round-trip; an exit gate that calls
+pay() waits for it with the barrier closed. Instead the gate
+submits to the provider's lane (PaymentPipeline, declared in
+../common/PaymentLane.h) and gets a future back:
+- one lane per provider: own queue, own workers, so a slow
+  provider only backs up its own payments
+- a worker sends up to maxBatch queued payments per payBatch()
+  (lingering briefly for the batch to fill)
+- maxInFlight workers = concurrent round-trips to the provider
+- every attempt gets `timeout`; FAILED / TIMED_OUT payments are
+  retried maxRetries times with exponential backoff, and never
+  past `deadline` (whole payment, queueing included)
+*/
+
+/*
+--------------------------------------------------
+BENCHMARK: spot allocation at high occupancy
+--------------------------------------------------
+- FLOORS x SPOTS_PER_FLOOR spots, car spots all taken
+- Each op releases a random car and parks a new one
+- Index path vs the old linear scan over every spot
+*/
+
+const int BENCH_FLOORS = 10;
+const int BENCH_SPOTS_PER_FLOOR = 10000;
+
+// 20% bike, 70% car, 10% truck on every floor; returns car spot count
+int buildBenchLot(ParkingLot& lot) {
+    int nextId = 1;
+    int carSpots = 0;
+    for (int f = 1; f <= BENCH_FLOORS; f++) {
+        ParkingFloor* floor = new ParkingFloor(f);
+        for (int s = 0; s < BENCH_SPOTS_PER_FLOOR; s++) {
+            int kind = s % 10;
+            if (kind < 2) floor->addSpot(new BikeParkingSpot(nextId++));
+            else if (kind < 9) { floor->addSpot(new CarParkingSpot(nextId++)); carSpots++; }
+            else floor->addSpot(new TruckParkingSpot(nextId++));
+        }
+        lot.addFloor(floor);
+    }
+    return carSpots;
+}
+
+void runAllocationBenchmark(ParkingLot& lot) {
+    const int INDEX_OPS = 1000000;
+    const int SCAN_OPS = 2000;
+
+    vector<ParkingSpot*> parked;
+    while (ParkingSpot* spot = lot.findSpot(CAR)) {
+        spot->park();
+        parked.push_back(spot);
+    }
+
+    mt19937 rng(7);
+    auto churn = [&](int ops, bool useIndex) {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < ops; i++) {
+            size_t victim = rng() % parked.size();
+            parked[victim]->unpark();
+            ParkingSpot* spot = useIndex ? lot.findSpot(CAR) : lot.findSpotByScan(CAR);
+            spot->park();
+            parked[victim] = spot;
+        }
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+    };
+
+    double indexNs = churn(INDEX_OPS, true);
+    double scanNs = churn(SCAN_OPS, false);
+
+    cout << "\n==== SPOT ALLOCATION (" << BENCH_FLOORS * BENCH_SPOTS_PER_FLOOR << " spots, "
+         << parked.size() << " cars parked) ====\n"
+         << "bitmap index\t" << indexNs << " ns per release+park\n"
+         << "linear scan\t" << scanNs << " ns per release+park\n"
+         << "speedup\t\t" << scanNs / indexNs << "x\n";
+
+    for (auto spot : parked)
+        spot->unpark();
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: occupancy dashboard
+--------------------------------------------------
+Per-zone free/total car spots over the whole lot, built from
+the floor arrays vs walking every ParkingSpot view.
+*/
+
+void runDashboardBenchmark(ParkingLot& lot) {
+    const int ZONE_SIZE = 256;
+    const int RUNS = 200;
+
+    // Some occupancy to count
+    mt19937 rng(11);
+    vector<ParkingSpot*> parked;
+    for (auto floor : lot.getFloors())
+        for (auto spot : floor->getSpots())
+            if (rng() % 3 == 0 && spot->park())
+                parked.push_back(spot);
+
+    long checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; run++)
+        for (auto& zone : lot.occupancyMap(CAR, ZONE_SIZE))
+            checksum += zone.free + zone.total;
+    double arraysNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / RUNS;
+
+    long viewChecksum = 0;
+    start = chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; run++) {
+        for (auto floor : lot.getFloors()) {
+            const vector<ParkingSpot*>& spots = floor->getSpots();
+            for (size_t from = 0; from < spots.size(); from += ZONE_SIZE) {
+                int total = 0, free = 0;
+                for (size_t row = from; row < min(spots.size(), from + ZONE_SIZE); row++) {
+                    if (spots[row]->getSpotType() == CAR) {
+                        total++;
+                        free += spots[row]->isAvailable();
+                    }
+                }
+                viewChecksum += free + total;
+            }
+        }
+    }
+    double viewsNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / RUNS;
+
+    size_t spotCount = 0;
+    for (auto floor : lot.getFloors())
+        spotCount += floor->getSpots().size();
+
+    cout << "\n==== OCCUPANCY DASHBOARD (" << spotCount << " spots, zones of "
+         << ZONE_SIZE << ", " << parked.size() << " parked) ====\n"
+         << "spot arrays\t" << arraysNs / spotCount << " ns per spot\n"
+         << "spot views\t" << viewsNs / spotCount << " ns per spot\n"
+         << "speedup\t\t" << viewsNs / arraysNs << "x"
+         << (checksum == viewChecksum ? "" : "  (MISMATCH)") << "\n";
+
+    for (auto spot : parked)
+        spot->unpark();
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: ticket lookups
+--------------------------------------------------
+ACTIVE tickets open; each op closes a random one and opens a
+new plate. SessionTable vs unordered_map<string, ParkingTicket>.
+*/
+
+void runSessionBenchmark() {
+    const int ACTIVE = 200000;
+    const int OPS = 1000000;
+
+    vector<string> plates;
+    for (int i = 0; i < ACTIVE + OPS; i++)
+        plates.push_back("PB" + to_string(10 + i % 90) + "XY" + to_string(100000 + i));
+
+    mt19937 rng(5);
+    vector<int> victims(OPS);
+    for (auto& v : victims)
+        v = rng() % ACTIVE;
+
+    CarParkingSpot spot(1);
+
+    auto timeTable = [&]() {
+        SessionTable table;
+        vector<int> open(ACTIVE);
+        for (int i = 0; i < ACTIVE; i++) {
+            table.insert({plates[i], CAR, &spot, 0});
+            open[i] = i;
+        }
+        ParkingTicket ticket;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < OPS; i++) {
+            int& slot = open[victims[i]];
+            table.find(plates[slot], ticket);
+            table.erase(plates[slot], ticket);
+            slot = ACTIVE + i;
+            table.insert({plates[slot], CAR, &spot, i});
+        }
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / OPS;
+    };
+
+    auto timeMap = [&]() {
+        unordered_map<string, ParkingTicket> table;
+        vector<int> open(ACTIVE);
+        for (int i = 0; i < ACTIVE; i++) {
+            table.emplace(plates[i], ParkingTicket{plates[i], CAR, &spot, 0});
+            open[i] = i;
+        }
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < OPS; i++) {
+            int& slot = open[victims[i]];
+            auto it = table.find(plates[slot]);
+            table.erase(it);
+            slot = ACTIVE + i;
+            table.emplace(plates[slot], ParkingTicket{plates[slot], CAR, &spot, i});
+        }
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / OPS;
+    };
+
+    double tableNs = timeTable();
+    double mapNs = timeMap();
+
+    cout << "\n==== TICKET LOOKUP (" << ACTIVE << " open tickets, lookup+exit+entry) ====\n"
+         << "session table\t" << tableNs << " ns per op\n"
+         << "unordered_map\t" << mapNs << " ns per op\n";
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: fee reconciliation
+--------------------------------------------------
+SESSIONS random stays priced one virtual call at a time vs
+one calculateFees() batch, flat and with a peak tariff. The
+batch dispatches per session too (calculateSessionFee), so the
+two stay within noise of each other; the match check is what
+keeps batch and per-call pricing identical.
+*/
+
+void runFeeBenchmark() {
+    const int SESSIONS = 4000000;
+    const int RUNS = 5;
+
+    mt19937 rng(3);
+    vector<BillableSession> sessions(SESSIONS);
+    for (auto& s : sessions) {
+        bool daily = rng() % 10 == 0;
+        s.vehicleType = (uint8_t)(rng() % VEHICLE_TYPE_COUNT);
+        s.durationType = (uint8_t)(daily ? DAY : HOUR);
+        s.entryHour = (uint8_t)(rng() % 24);
+        s.duration = daily ? 1 + rng() % 7 : 1 + rng() % 48;
+    }
+
+    BasicFeeStrategy basic;
+    TariffFeeStrategy peak(Tariff::flat().peak(8, 11, 150).peak(17, 20, 150));
+    // Opaque pointers so the per-call loops really dispatch
+    ParkingFeeStrategy* volatile basicPtr = &basic;
+    ParkingFeeStrategy* volatile peakPtr = &peak;
+
+    vector<int> perCall(SESSIONS), batch(SESSIONS);
+
+    auto time = [&](auto&& body) {
+        auto start = chrono::steady_clock::now();
+        for (int run = 0; run < RUNS; run++)
+            body();
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()
+               / ((double)RUNS * SESSIONS);
+    };
+
+    double flatCallNs = time([&] {
+        ParkingFeeStrategy* strategy = basicPtr;
+        for (int i = 0; i < SESSIONS; i++) {
+            const BillableSession& s = sessions[i];
+            perCall[i] = strategy->calculateFee(s.duration, (DurationType)s.durationType,
+                                                (VehicleType)s.vehicleType);
+        }
+    });
+    double flatBatchNs = time([&] { basicPtr->calculateFees(sessions, batch); });
+    bool flatMatch = perCall == batch;
+
+    double peakCallNs = time([&] {
+        ParkingFeeStrategy* strategy = peakPtr;
+        for (int i = 0; i < SESSIONS; i++)
+            perCall[i] = strategy->calculateSessionFee(sessions[i]);
+    });
+    double peakBatchNs = time([&] { peakPtr->calculateFees(sessions, batch); });
+    bool peakMatch = perCall == batch;
+
+    cout << "\n==== FEE RECONCILIATION (" << SESSIONS << " sessions) ====\n"
+         << "flat per call\t" << flatCallNs << " ns per session\n"
+         << "flat batch\t" << flatBatchNs << " ns per session"
+         << (flatMatch ? "" : "  (MISMATCH)") << "\n"
+         << "peak per call\t" << peakCallNs << " ns per session\n"
+         << "peak batch\t" << peakBatchNs << " ns per session"
+         << (peakMatch ? "" : "  (MISMATCH)") << "\n";
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: concurrent entry gates
+--------------------------------------------------
+STRESS: every gate claims cars until the lot is full, then
+releases what it got. Each round must hand out every car
+spot exactly once (holders[] counts owners per spot id).
+
+THROUGHPUT: each gate keeps its share of a 90% full lot and
+churns (release oldest, claim new) for a fixed time.
+*/
+
+void runGateBenchmark(ParkingLot& lot, int carSpots) {
+    const int GATE_COUNTS[] = {8, 16, 32, 64};
+    const int STRESS_ROUNDS = 3;
+    const auto CHURN_TIME = chrono::milliseconds(300);
+
+    int maxId = BENCH_FLOORS * BENCH_SPOTS_PER_FLOOR;
+    unique_ptr<atomic<int>[]> holders(new atomic<int>[maxId + 1]());
+
+    cout << "\n==== GATE STRESS (" << carSpots << " car spots, "
+         << STRESS_ROUNDS << " rounds per gate count) ====\n"
+         << "gates\thanded out\tdouble claims\tfree after\tresult\n";
+
+    for (int gates : GATE_COUNTS) {
+        long handedOut = 0;
+        bool ok = true;
+        atomic<long> doubleClaims{0};
+
+        for (int round = 0; round < STRESS_ROUNDS; round++) {
+            vector<vector<ParkingSpot*>> held(gates);
+            vector<thread> threads;
+
+            for (int g = 0; g < gates; g++) {
+                threads.emplace_back([&, g] {
+                    while (ParkingSpot* spot = lot.claimSpot(CAR, g)) {
+                        if (holders[spot->getSpotId()].fetch_add(1) != 0)
+                            doubleClaims++;
+                        held[g].push_back(spot);
+                    }
+                });
+            }
+            for (auto& t : threads) t.join();
+            threads.clear();
+
+            long got = 0;
+            for (auto& mine : held) got += mine.size();
+            handedOut += got;
+            ok = ok && got == carSpots && lot.findSpot(CAR) == nullptr;
+
+            for (int g = 0; g < gates; g++) {
+                threads.emplace_back([&, g] {
+                    for (auto spot : held[g]) {
+                        holders[spot->getSpotId()].fetch_sub(1);
+                        spot->unpark();
+                    }
+                });
+            }
+            for (auto& t : threads) t.join();
+            ok = ok && lot.getFreeCount(CAR) == carSpots;
+        }
+
+        ok = ok && doubleClaims == 0;
+        cout << gates << "\t" << handedOut / STRESS_ROUNDS << "/" << carSpots
+             << "\t" << doubleClaims << "\t\t" << lot.getFreeCount(CAR)
+             << "\t\t" << (ok ? "OK" : "FAILED") << "\n";
+    }
+
+    cout << "\n==== GATE THROUGHPUT (90% occupancy, "
+         << CHURN_TIME.count() << " ms per run) ====\n"
+         << "gates\tclaims+releases/s\n";
+
+    for (int gates : GATE_COUNTS) {
+        atomic<bool> stop{false};
+        atomic<long> totalOps{0};
+        size_t share = (size_t)carSpots * 9 / 10 / gates;
+        vector<thread> threads;
+
+        for (int g = 0; g < gates; g++) {
+            threads.emplace_back([&, g] {
+                vector<ParkingSpot*> mine(share);
+                size_t head = 0, count = 0;
+                long ops = 0;
+                while (!stop.load(memory_order_relaxed)) {
+                    if (count == share) {
+                        mine[head]->unpark();
+                        head = (head + 1) % share;
+                        count--;
+                        ops++;
+                    }
+                    ParkingSpot* spot = lot.claimSpot(CAR, g);
+                    if (spot) {
+                        mine[(head + count) % share] = spot;
+                        count++;
+                    }
+                    ops++;
+                }
+                for (; count > 0; count--, head = (head + 1) % share)
+                    mine[head]->unpark();
+                totalOps += ops;
+            });
+        }
+
+        auto start = chrono::steady_clock::now();
+        this_thread::sleep_for(CHURN_TIME);
+        stop = true;
+        for (auto& t : threads) t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << gates << "\t" << (long)(totalOps / seconds) << "\n";
+    }
+}
+
+/*
+=================================================================
+=                 BENCHMARK: LOGGING                            =
+=================================================================
+The "Vehicle parked at spot" line, MESSAGES times, into a file:
+- cout-style: format on the caller, endl = one write() per line
+- AsyncLog: the caller only copies the arguments into its ring;
+  the drain thread formats and writes in large chunks
+Caller-side cost is what an operation on the hot path pays;
+"until written" includes waiting for the drain to finish.
+*/
+void runLoggingBenchmark() {
+    const int MESSAGES = 200000;
+    string path = (filesystem::temp_directory_path() / "parkinglot-log-bench.txt").string();
+
+    auto elapsedNs = [](chrono::steady_clock::time_point start) {
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    };
+
+    double streamNs;
+    {
+        ofstream file(path);
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < MESSAGES; i++)
+            file << "Vehicle parked at spot: " << i << endl;
+        streamNs = elapsedNs(start) / MESSAGES;
+    }
+
+    double asyncNs, writtenNs;
+    {
+        ofstream file(path);
+        AsyncLog::Redirect toFile(file.rdbuf());
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < MESSAGES; i++)
+            LOG_INFO("Vehicle parked at spot: {}", i);
+        asyncNs = elapsedNs(start) / MESSAGES;
+        AsyncLog::flush();
+        writtenNs = elapsedNs(start) / MESSAGES;
+    }
+    filesystem::remove(path);
+
+    cout << "\n==== LOGGING (" << MESSAGES << " messages to a file) ====\n"
+         << "cout + endl\t\t" << streamNs << " ns per message\n"
+         << "AsyncLog, caller\t" << asyncNs << " ns per message\n"
+         << "AsyncLog, until written\t" << writtenNs << " ns per message\n";
+}
+
+/*
+=================================================================
+=                 BENCHMARK: METRICS OVERHEAD                   =
+=================================================================
+EVENTS updates per thread on one shared metric, 1 and 4
+threads, vs a single shared atomic counter (what a naive
+global statistic would be):
+- the Metrics.h cells are per thread, so the cost per event
+  should stay flat as threads are added
+- the shared atomic pays a locked add and, with more than one
+  thread, a cache-line transfer per event
+Build with -DMETRICS_ENABLED=0 to see the compiled-out cost.
+*/
+void runMetricsBenchmark() {
+    const int EVENTS = 5000000;
+
+    Metrics::Counter& counter = Metrics::counter("bench_metric_events_total", "Benchmark only");
+    Metrics::Gauge& gauge = Metrics::gauge("bench_metric_gauge", "Benchmark only");
+    Metrics::Histogram& histogram = Metrics::histogram("bench_metric_values", "Benchmark only");
+    atomic<uint64_t> shared{0};
+
+    auto nsPerEvent = [&](int threads, auto update) {
+        auto start = chrono::steady_clock::now();
+        vector<thread> pool;
+        for (int t = 0; t < threads; t++)
+            pool.emplace_back([&]() {
+                for (int i = 0; i < EVENTS; i++)
+                    update(i);
+            });
+        for (auto& t : pool)
+            t.join();
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / EVENTS;
+    };
+
+    cout << "\n==== METRICS OVERHEAD (" << EVENTS << " events per thread"
+         << (METRICS_ENABLED ? "" : ", compiled out") << ") ====\n"
+         << "threads\tcounter\tgauge\thistogram\tshared atomic\t(ns per event)\n";
+    for (int threads : {1, 4}) {
+        cout << threads
+             << "\t" << nsPerEvent(threads, [&](int) { counter.inc(); })
+             << "\t" << nsPerEvent(threads, [&](int i) { gauge.add(i & 1 ? 1 : -1); })
+             << "\t" << nsPerEvent(threads, [&](int i) { histogram.record((uint64_t)i & 4095); })
+             << "\t\t" << nsPerEvent(threads, [&](int) { shared.fetch_add(1, memory_order_relaxed); })
+             << "\n";
+    }
+    cout << "counted " << counter.value() << " events, shared atomic " << shared.load() << "\n";
+}
+
+/*
+=================================================================
+=                 BENCHMARK: PAYMENTS AT THE EXIT                =
+=================================================================
+Every exit pays Rs 100 through a gateway with a 2 ms round-trip:
+- blocking: the gate calls payBatch() for its one payment and
+  waits, so each gate clears at most one car per round-trip
+- pipeline: the gate submits and moves on to the next car; the
+  provider's lane sends up to 32 payments per round-trip, four
+  round-trips in flight, and the gate collects the futures later
+*/
+
+class SimulatedUpiGateway : public UpiPayment {
+public:
+    void payBatch(const int*, PaymentStatus* results, size_t count,
+                  chrono::steady_clock::time_point deadline) override {
+        auto answered = chrono::steady_clock::now() + chrono::milliseconds(2);
+        this_thread::sleep_until(min(answered, deadline));
+        for (size_t i = 0; i < count; i++)
+            results[i] = answered <= deadline ? APPROVED : TIMED_OUT;
+    }
+};
+
+void runPaymentBenchmark() {
+    const int GATE_COUNTS[] = {8, 16, 32};
+    const int EXITS_PER_GATE = 100;
+    SimulatedUpiGateway gateway;
+
+    cout << "\n==== EXIT PAYMENTS (2 ms gateway round-trip, "
+         << EXITS_PER_GATE << " exits per gate) ====\n"
+         << "gates\tblocking exits/s\tpipeline exits/s\tapproved\n";
+
+    for (int gates : GATE_COUNTS) {
+        double blockingSeconds, pipelineSeconds;
+        atomic<int> approved{0};
+        {
+            vector<thread> threads;
+            auto start = chrono::steady_clock::now();
+            for (int g = 0; g < gates; g++) {
+                threads.emplace_back([&] {
+                    for (int i = 0; i < EXITS_PER_GATE; i++) {
+                        int fee = 100;
+                        PaymentStatus status = TIMED_OUT;
+                        gateway.payBatch(&fee, &status, 1, chrono::steady_clock::now() + chrono::milliseconds(50));
+                    }
+                });
+            }
+            for (auto& t : threads) t.join();
+            blockingSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        {
+            PaymentPipeline payments;
+            vector<thread> threads;
+            auto start = chrono::steady_clock::now();
+            for (int g = 0; g < gates; g++) {
+                threads.emplace_back([&] {
+                    vector<future<PaymentResult>> paid;
+                    for (int i = 0; i < EXITS_PER_GATE; i++)
+                        paid.push_back(payments.submit(&gateway, 100));
+                    for (auto& result : paid)
+                        approved += result.get().status == APPROVED;
+                });
+            }
+            for (auto& t : threads) t.join();
+            pipelineSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        long exits = (long)gates * EXITS_PER_GATE;
+        cout << gates << "\t" << (long)(exits / blockingSeconds) << "\t\t\t"
+             << (long)(exits / pipelineSeconds) << "\t\t\t" << approved << "/" << exits << "\n";
+    }
+}
+
+/*
+=================================================================
+=                 LOAD SUITE: --load                             =
+=================================================================
+Machine-readable: one JSON line per case and gate count (see
+bench/LoadHarness.h for flags and fields). Logging is silenced.
+- gate_visit: each worker is a gate holding its share of a 90%
+  full bench lot; one op = its oldest car leaves (ticket lookup,
+  fee, exit) and comes straight back in through the same gate
+- exit_payment: one op = a gate pays a fee through the async
+  payment lanes (2 ms gateway) and waits for the approval
+*/
+
+void runLoadSuite(const LoadHarness::Options& options) {
+    LoadHarness::Reporter report("parkinglot", options);
+    AsyncLog::Redirect quiet(nullptr);
+
+    ParkingLot& lot = ParkingLot::getInstance();
+    int carSpots = buildBenchLot(lot);
+    BasicFeeStrategy fees;
+
+    if (options.wants("gate_visit")) {
+        for (int gates : options.threads) {
+            struct Gate {
+                vector<Vehicle> cars;
+                size_t oldest = 0;
+            };
+            size_t share = (size_t)carSpots * 9 / 10 / gates;
+            vector<Gate> gateState(gates);
+            for (int g = 0; g < gates; g++) {
+                for (size_t i = 0; i < share; i++) {
+                    gateState[g].cars.emplace_back(CAR, "G" + to_string(g) + "-" + to_string(i));
+                    lot.parkVehicle(gateState[g].cars.back(), g % BENCH_FLOORS + 1);
+                }
+            }
+
+            report.emit(LoadHarness::runLoad("gate_visit", gates, options.seconds,
+                [&](int g, uint64_t) {
+                    Gate& gate = gateState[g];
+                    const Vehicle& car = gate.cars[gate.oldest];
+                    gate.oldest = (gate.oldest + 1) % gate.cars.size();
+
+                    ParkingTicket ticket;
+                    if (lot.getTicket(car.getVehicleNumber(), ticket)) {
+                        int fee = fees.calculateFee(ticket.entryTime, lot.now(), ticket.vehicleType);
+                        lot.exitVehicle(car.getVehicleNumber());
+                        if (fee < 0)
+                            LOG_ERROR("negative fee {}", fee);
+                    }
+                    lot.parkVehicle(car, g % BENCH_FLOORS + 1);
+                }));
+
+            for (Gate& gate : gateState)
+                for (const Vehicle& car : gate.cars)
+                    lot.exitVehicle(car.getVehicleNumber());
+        }
+    }
+
+    if (options.wants("exit_payment")) {
+        SimulatedUpiGateway gateway;
+        for (int gates : options.threads) {
+            PaymentPipeline payments;
+            report.emit(LoadHarness::runLoad("exit_payment", gates, options.seconds,
+                [&](int, uint64_t i) {
+                    if (payments.submit(&gateway, 100 + (int)(i % 50)).get().status != APPROVED)
+                        LOG_ERROR("payment not approved");
+                }));
+        }
+    }
+}
+
 /*
 --------------------------------------------------
 MAIN FUNCTION
 --------------------------------------------------
 Flow:
 1. Create parking lot
-2. Park vehicle
-3. Calculate fee
-4. Pay
-5. Unpark
+2. Park vehicle (opens a ticket)
+3. Look the ticket up by plate, calculate fee
+4. Pay (async, the barrier opens once the payment is approved)
+5. Exit (closes the ticket, frees the spot)
 */
 
-int main() {
+int main(int argc, char* argv[]) {
+    AsyncLog::captureCout();
+
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        ParkingLot& lot = ParkingLot::getInstance();
+        int carSpots = buildBenchLot(lot);
+        runAllocationBenchmark(lot);
+        runDashboardBenchmark(lot);
+        runSessionBenchmark();
+        runFeeBenchmark();
+        runGateBenchmark(lot, carSpots);
+        runLoggingBenchmark();
+        runMetricsBenchmark();
+        runPaymentBenchmark();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--load") {
+        runLoadSuite(LoadHarness::Options::parse(argc, argv));
+        return 0;
+    }
+
     ParkingLot& parkingLot = ParkingLot::getInstance();
 
     cout << "\n================ PARKING LOT SYSTEM ================\n";
@@ -349,6 +1939,10 @@ int main() {
     parkingLot.addFloor(floor1);
     parkingLot.addFloor(floor2);
 
+    // Manual time so the stays below are exact
+    ManualClock clock(0);
+    parkingLot.setClock(&clock);
+
     cout << "[SETUP COMPLETE] Parking lot is ready\n";
 
     /* -------------------------------
@@ -367,22 +1961,22 @@ int main() {
     cout << "\n[ACTION] Bike entering parking lot\n";
     ParkingSpot* bikeSpot = parkingLot.parkVehicle(bike);
     if (!bikeSpot)
-        cout << "[FAILED] No suitable spot for BIKE\n";
+        LOG_WARN("[FAILED] No suitable spot for BIKE");
 
     cout << "\n[ACTION] Car entering parking lot\n";
     ParkingSpot* carSpot = parkingLot.parkVehicle(car);
     if (!carSpot)
-        cout << "[FAILED] No suitable spot for CAR\n";
+        LOG_WARN("[FAILED] No suitable spot for CAR");
 
     cout << "\n[ACTION] Truck entering parking lot\n";
     ParkingSpot* truckSpot = parkingLot.parkVehicle(truck);
     if (!truckSpot)
-        cout << "[FAILED] No suitable spot for TRUCK\n";
+        LOG_WARN("[FAILED] No suitable spot for TRUCK");
 
     cout << "\n[ACTION] OTHER vehicle entering parking lot\n";
     ParkingSpot* otherSpot = parkingLot.parkVehicle(other);
     if (!otherSpot)
-        cout << "[FAILED] No suitable spot for OTHER vehicle type\n";
+        LOG_WARN("[FAILED] No suitable spot for OTHER vehicle type");
 
     /* -------------------------------
        Fee & Payment Strategy
@@ -391,38 +1985,89 @@ int main() {
     PaymentStrategy* upiPayment  = new UpiPayment();
     PaymentStrategy* cardPayment = new CardPayment();
 
+    // The gate hands the payment to the provider's lane and only
+    // opens the barrier once the future says it went through
+    PaymentPipeline payments;
+    auto paidAtGate = [&](PaymentStrategy* method, int fee) {
+        future<PaymentResult> paid = payments.submit(method, fee);
+        if (paid.get().status == APPROVED)
+            return true;
+        LOG_WARN("[FAILED] Payment of Rs {} not approved, barrier stays closed", fee);
+        return false;
+    };
+
     /* -------------------------------
        Exit Vehicles
     -------------------------------- */
     cout << "\n================ VEHICLE EXIT FLOW ================\n";
 
-    if (bikeSpot) {
+    // Everyone entered at t = 0; exits look the ticket up by plate
+    ParkingTicket ticket;
+    const int64_t HOUR_SECONDS = 3600;
+
+    clock.advance(1 * HOUR_SECONDS);
+    if (parkingLot.getTicket(bike.getVehicleNumber(), ticket)) {
         cout << "\n[EXIT] Bike exiting after 1 hour\n";
-        int fee = feeStrategy->calculateFee(1, HOUR, bike.getType());
+        int fee = feeStrategy->calculateFee(ticket.entryTime, parkingLot.now(), ticket.vehicleType);
         cout << "[FEE] Calculated parking fee: Rs " << fee << endl;
-        upiPayment->pay(fee);
-        bikeSpot->unpark();
-        cout << "[SUCCESS] Bike exited, spot released\n";
+        if (paidAtGate(upiPayment, fee)) {
+            parkingLot.exitVehicle(bike.getVehicleNumber());
+            cout << "[SUCCESS] Bike exited, spot released\n";
+        }
     }
 
-    if (carSpot) {
+    clock.advance(2 * HOUR_SECONDS);
+    if (parkingLot.getTicket(car.getVehicleNumber(), ticket)) {
         cout << "\n[EXIT] Car exiting after 3 hours\n";
-        int fee = feeStrategy->calculateFee(3, HOUR, car.getType());
+        int fee = feeStrategy->calculateFee(ticket.entryTime, parkingLot.now(), ticket.vehicleType);
         cout << "[FEE] Calculated parking fee: Rs " << fee << endl;
-        cardPayment->pay(fee);
-        carSpot->unpark();
-        cout << "[SUCCESS] Car exited, spot released\n";
+        if (paidAtGate(cardPayment, fee)) {
+            parkingLot.exitVehicle(car.getVehicleNumber());
+            cout << "[SUCCESS] Car exited, spot released\n";
+        }
     }
 
-    if (truckSpot) {
+    clock.advance(21 * HOUR_SECONDS);
+    if (parkingLot.getTicket(truck.getVehicleNumber(), ticket)) {
         cout << "\n[EXIT] Truck exiting after 1 day\n";
-        int fee = feeStrategy->calculateFee(1, DAY, truck.getType());
+        int fee = feeStrategy->calculateFee(ticket.entryTime, parkingLot.now(), ticket.vehicleType);
         cout << "[FEE] Calculated parking fee: Rs " << fee << endl;
-        upiPayment->pay(fee);
-        truckSpot->unpark();
-        cout << "[SUCCESS] Truck exited, spot released\n";
+        if (paidAtGate(upiPayment, fee)) {
+            parkingLot.exitVehicle(truck.getVehicleNumber());
+            cout << "[SUCCESS] Truck exited, spot released\n";
+        }
     }
 
+    cout << "\n[EXIT] OTHER vehicle at the exit gate\n";
+    if (!parkingLot.exitVehicle(other.getVehicleNumber()))
+        LOG_WARN("[FAILED] No active ticket for {}", other.getVehicleNumber());
+
+    /* -------------------------------
+       Nearest-floor preference
+    -------------------------------- */
+    cout << "\n================ GATE ON FLOOR 2 ================\n";
+
+    Vehicle visitor(CAR, "PB10CR5555");
+    cout << "\n[ACTION] Car entering from the floor 2 gate\n";
+    ParkingSpot* visitorSpot = parkingLot.parkVehicle(visitor, 2);
+    if (!visitorSpot)
+        LOG_WARN("[FAILED] No suitable spot for CAR");
+
+    /* -------------------------------
+       Occupancy dashboard
+    -------------------------------- */
+    cout << "\n================ OCCUPANCY DASHBOARD ================\n";
+
+    for (VehicleType type : {CAR, TRUCK}) {
+        cout << (type == CAR ? "\nCAR" : "\nTRUCK") << " spots\n";
+        for (auto& zone : parkingLot.occupancyMap(type, 10))
+            cout << "Floor " << zone.floorNumber << ": "
+                 << zone.free << "/" << zone.total << " free\n";
+    }
+
+    cout << "\n================ METRICS (Prometheus text) ================\n";
+    cout << Metrics::prometheusText();
+
     cout << "\n================ SYSTEM FLOW COMPLETE ================\n";
 
     return 0;
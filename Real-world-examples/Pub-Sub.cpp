@@ -19,11 +19,57 @@ WHY:
 - Loose coupling between publisher and subscribers
 - Easy to add new subscribers
 
+CONCURRENCY (many publisher threads):
+- Broker shards topics by name; each shard is a copy-on-write map
+- Topic keeps its subscribers in an immutable snapshot
+- subscribe/unsubscribe build a new snapshot and swap it in
+- Publishers read snapshots inside an EpochGuard (RCU-style):
+  no locks on the publish path, and in-flight fan-out keeps
+  using the snapshot it started with
+- Old snapshots are freed once no reader can still see them
+
+ASYNC DELIVERY (slow subscribers):
+- DeliveryPool wraps a subscriber in a bounded ring buffer
+- Publishers only enqueue; pool workers call the subscriber
+- Full queue -> BLOCK / DROP_OLDEST / DROP_NEWEST per subscriber
+- Publish-to-deliver latency is kept in a histogram
+
+HOT PATH (high message rates):
+- Message = immutable, refcounted buffer shared by all subscribers
+- Publisher::resolve() turns a name into a TopicHandle once
+- publish()/publishBatch() by handle: no hashing, no allocation;
+  a batch takes one epoch guard and one async wake-up
+
+WILDCARDS (MQTT/AMQP style, "." separated levels):
+- Broker::subscribePattern("sports.*.cricket" / "news.#")
+- Patterns live in a trie: matching costs O(topic depth),
+  not O(pattern subscriptions)
+- Each topic caches its matched subscribers; any pattern
+  change bumps a version and topics re-match lazily
+
+DURABILITY (optional, per topic):
+- Topic::enableLog(dir) -> segmented append-only log on mmap
+- Group commit: a flusher syncs everything appended since the
+  last sync; awaitDurable(offset) waits for that offset only
+- Topic::resume(subscriber, offset) replays from disk, then
+  switches the subscriber to live delivery (at-least-once)
+
+SUBSCRIBER LIFETIMES (pooled subscribers):
+- SubscriberPool<T>::create() -> generational SubscriberHandle
+- Topic::subscribe(handle) -> Subscription token (RAII unsubscribe)
+- Deleting a pooled subscriber bumps its slot generation: fan-out
+  skips it with one integer compare and prunes the entry, with no
+  refcount traffic per notify (unlike weak_ptr::lock())
+
 TRADE-OFFS:
 + Simple, flexible, decoupled
-- In-memory only
-- No persistence or delivery guarantee
-- Not thread-safe
++ Lock-free publish path, scales with publisher threads
++ Async mode isolates publishers from slow subscribers
+- Subscribe/unsubscribe copy the subscriber list (O(n) per change)
+- Async mode trades ordering across subscribers and
+  (with DROP_* policies) completeness for throughput
+- Without enableLog(): in-memory only, no delivery guarantee
+- With a log: single node, appends to one topic serialize
 
 USE WHEN:
 - Event/notification systems
@@ -35,118 +81,2492 @@ AVOID WHEN:
 - Need message durability
 - Distributed systems (Kafka/RabbitMQ)
 - High scale or reliability needed
+
+RUN:
+- ./pubsub          -> demo
+- ./pubsub --bench  -> publish throughput vs publisher threads,
+                       batched publish, wildcard matching,
+                       durable log, async delivery latency,
+                       handle vs weak_ptr liveness checks
+- ./pubsub --load   -> JSON lines (throughput, p50/p99/p999) for
+                       N publishers: by name, by handle, async
+                       (flags: bench/LoadHarness.h)
+- [NOTIFY]/[PUBLISH]/... messages go through AsyncLog;
+  g++ -DLOG_LEVEL=LOG_LEVEL_WARN ... compiles them out
+- the demo ends with a Metrics.h scrape (messages per topic,
+  subscribers reached per publish); -DMETRICS_ENABLED=0
+  compiles the metrics out
+*/
+
+
+
+#include<iostream>
+#include<unordered_map>
+#include<vector>
+#include<string>
+#include<atomic>
+#include<mutex>
+#include<shared_mutex>
+#include<condition_variable>
+#include<thread>
+#include<memory>
+#include<chrono>
+#include<algorithm>
+#include<random>
+#include<string_view>
+#include<cstdint>
+#include<cstdlib>
+#include<cstring>
+#include<new>
+#include<filesystem>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<unistd.h>
+#include<optional>
+
+#include "AsyncLog.h"
+#include "Metrics.h"
+#include "../common/LogHistogram.h"
+#include "../common/SubscriberPool.h"
+#include "../bench/LoadHarness.h"
+using namespace std;
+
+class Subscriber;
+class Topic;
+
+/*
+--------------------------------------------------
+EPOCH-BASED RECLAMATION (RCU-style)
+--------------------------------------------------
+- Every reader thread owns one slot
+- While reading, the slot holds the global epoch it entered at
+- A writer swaps in a new snapshot, bumps the epoch and retires
+  the old snapshot tagged with the epoch it was replaced in
+- A retired snapshot is freed once every active reader entered
+  at a later epoch (nobody can still be looking at it)
+*/
+struct alignas(64) ReaderSlot {
+    atomic<uint64_t> epoch{0};          // 0 = not inside a read section
+    atomic<bool> inUse{false};
+};
+
+class Epoch {
+public:
+    static const int MAX_READERS = 256;
+
+private:
+    struct ThreadSlot {
+        ReaderSlot* slot = nullptr;
+        int depth = 0;                  // nested guards on the same thread
+
+        bool tryClaim() {
+            for (int i = 0; i < MAX_READERS; i++) {
+                bool expected = false;
+                if (slots[i].inUse.compare_exchange_strong(expected, true)) {
+                    slot = &slots[i];
+                    int seen = highWater.load();
+                    while (seen < i + 1 && !highWater.compare_exchange_weak(seen, i + 1)) {}
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // More than MAX_READERS live threads: wait for one to exit
+        ThreadSlot() {
+            while (!tryClaim())
+                this_thread::yield();
+        }
+
+        ~ThreadSlot() {
+            slot->epoch.store(0);
+            slot->inUse.store(false, memory_order_release);
+        }
+    };
+
+    inline static ReaderSlot slots[MAX_READERS];
+    inline static atomic<int> highWater{0};
+    inline static atomic<uint64_t> globalEpoch{1};
+
+    friend class EpochGuard;
+
+public:
+    static ThreadSlot& self() {
+        thread_local ThreadSlot threadSlot;
+        return threadSlot;
+    }
+
+    // Called by writers after swapping a pointer; returns the retire tag
+    static uint64_t advance() {
+        return globalEpoch.fetch_add(1);
+    }
+
+    /*
+     Wait until every reader that could have seen the old state
+     has left its read section. Never call it under an EpochGuard
+     (the caller would wait on itself).
+    */
+    static void synchronize() {
+        uint64_t tag = advance();
+        while (oldestActiveReader() <= tag)
+            this_thread::yield();
+    }
+
+    // Smallest epoch any reader is currently inside (UINT64_MAX if none)
+    static uint64_t oldestActiveReader() {
+        uint64_t oldest = UINT64_MAX;
+        int count = highWater.load();
+        for (int i = 0; i < count; i++) {
+            uint64_t e = slots[i].epoch.load();
+            if (e != 0 && e < oldest)
+                oldest = e;
+        }
+        return oldest;
+    }
+};
+
+/*
+ RAII read-side critical section.
+ Pointers read from an RcuPtr stay valid until the guard dies.
+*/
+class EpochGuard {
+    Epoch::ThreadSlot& threadSlot;
+
+public:
+    EpochGuard() : threadSlot(Epoch::self()) {
+        if (threadSlot.depth++ == 0)
+            threadSlot.slot->epoch.store(Epoch::globalEpoch.load());
+    }
+
+    ~EpochGuard() {
+        if (--threadSlot.depth == 0)
+            threadSlot.slot->epoch.store(0, memory_order_release);
+    }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+/*
+ Copy-on-write cell.
+ - read(): lock-free, call it under an EpochGuard
+ - update(): copies, mutates, swaps (writers serialize on a mutex)
+*/
+template<typename T>
+class RcuPtr {
+private:
+    atomic<T*> current;
+    mutex writeMtx;
+    vector<pair<uint64_t, T*>> retired;
+
+    void reclaim() {
+        uint64_t oldest = Epoch::oldestActiveReader();
+        auto alive = remove_if(retired.begin(), retired.end(),
+            [oldest](const pair<uint64_t, T*>& r) {
+                if (r.first < oldest) {
+                    delete r.second;
+                    return true;
+                }
+                return false;
+            });
+        retired.erase(alive, retired.end());
+    }
+
+public:
+    RcuPtr() : current(new T()) {}
+
+    ~RcuPtr() {
+        delete current.load();
+        for (auto& r : retired)
+            delete r.second;
+    }
+
+    RcuPtr(const RcuPtr&) = delete;
+    RcuPtr& operator=(const RcuPtr&) = delete;
+
+    const T* read() const {
+        return current.load();
+    }
+
+    // mutate(copy) returns false when nothing changed (copy is dropped)
+    template<typename Mutator>
+    bool update(Mutator mutate) {
+        lock_guard<mutex> lock(writeMtx);
+        T* next = new T(*current.load());
+        if (!mutate(*next)) {
+            delete next;
+            return false;
+        }
+        T* old = current.exchange(next);
+        retired.push_back({Epoch::advance(), old});
+        reclaim();
+        return true;
+    }
+};
+
+/*
+--------------------------------------------------
+MESSAGE (zero-copy payload)
+--------------------------------------------------
+- Immutable bytes + reference count in ONE allocation
+- Built once per publish, shared by every subscriber
+  and every async queue
+- Copying a Message bumps the count; it never copies text
+*/
+class Message {
+private:
+    struct Buffer {
+        atomic<int> refs;
+        size_t size;
+        char data[1];       // payload continues past the struct
+    };
+
+    Buffer* buffer = nullptr;
+
+    void retain() {
+        if (buffer)
+            buffer->refs.fetch_add(1, memory_order_relaxed);
+    }
+
+    void release() {
+        if (buffer && buffer->refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+            buffer->refs.~atomic<int>();
+            free(buffer);
+        }
+        buffer = nullptr;
+    }
+
+public:
+    Message() {}
+
+    Message(string_view text) {
+        buffer = static_cast<Buffer*>(malloc(sizeof(Buffer) + text.size()));
+        new (&buffer->refs) atomic<int>(1);
+        buffer->size = text.size();
+        memcpy(buffer->data, text.data(), text.size());
+    }
+
+    Message(const string& text) : Message(string_view(text)) {}
+    Message(const char* text) : Message(string_view(text)) {}
+
+    Message(const Message& other) : buffer(other.buffer) {
+        retain();
+    }
+
+    Message(Message&& other) noexcept : buffer(other.buffer) {
+        other.buffer = nullptr;
+    }
+
+    Message& operator=(const Message& other) {
+        if (buffer != other.buffer) {
+            release();
+            buffer = other.buffer;
+            retain();
+        }
+        return *this;
+    }
+
+    Message& operator=(Message&& other) noexcept {
+        if (this != &other) {
+            release();
+            buffer = other.buffer;
+            other.buffer = nullptr;
+        }
+        return *this;
+    }
+
+    ~Message() {
+        release();
+    }
+
+    string_view view() const {
+        return buffer ? string_view(buffer->data, buffer->size) : string_view();
+    }
+
+    size_t size() const {
+        return buffer ? buffer->size : 0;
+    }
+
+    int useCount() const {
+        return buffer ? buffer->refs.load() : 0;
+    }
+};
+
+class Subscriber {
+    string subscriberName;
+
+public:
+    Subscriber(string name) : subscriberName(name) {}
+
+    virtual void notify(const string& topicName, const Message& msg) {
+        LOG_INFO("[NOTIFY] {} received on [{}]: {}", subscriberName, topicName, msg.view());
+    }
+
+    // Override to take a whole batch at once (e.g. one queue wake-up)
+    virtual void notifyBatch(const string& topicName, const Message* batch, size_t count) {
+        for (size_t i = 0; i < count; i++)
+            notify(topicName, batch[i]);
+    }
+
+    string getName() const {
+        return subscriberName;
+    }
+
+    virtual ~Subscriber() {}
+};
+
+/*
+--------------------------------------------------
+GENERATIONAL SUBSCRIBER HANDLES
+--------------------------------------------------
+A raw Subscriber* in a topic snapshot dangles the moment the
+subscriber is deleted. shared_ptr/weak_ptr fixes that with an
+atomic increment + decrement per notification, on a refcount
+cache line every publisher thread writes.
+
+Instead (common/SubscriberPool.h):
+- SubscriberPool<T, Epoch> owns the subscriber objects in chunked slots
+  that are never returned to the heap while the pool lives
+- A slot carries a generation; destroying the subscriber bumps it
+- A handle = (slot, generation it was issued at, target)
+- Liveness check = one 32-bit compare against the slot. Readers
+  only load it, so the slot line stays shared across publishers
+- destroy() waits for an epoch grace period before running the
+  destructor, so a publisher that passed the check just before
+  the bump still finishes its notify on a live object, so never
+  call it under an EpochGuard
+- Subscription = RAII token: unsubscribes when it goes out of
+  scope, and is safe to outlive the subscriber it points at
+*/
+typedef GenerationHandle<Subscriber> SubscriberHandle;
+
+/*
+--------------------------------------------------
+WILDCARD SUBSCRIPTIONS (topic trie)
+--------------------------------------------------
+Topic names are dot-separated levels: "sports.india.cricket"
+- "*" matches exactly one level     -> "sports.*.cricket"
+- "#" matches zero or more levels   -> "news.#"
+
+Patterns are stored in a trie keyed by level, so matching one
+topic walks the topic's levels (plus wildcard branches) no
+matter how many patterns are registered.
+
+Every change bumps version(); topics cache their matched
+subscribers and re-match only when the version moved.
+*/
+class TopicPatternIndex {
+private:
+    struct Node {
+        unordered_map<string, Node*> children;  // includes "*" and "#"
+        vector<Subscriber*> subscribers;         // patterns ending here
+
+        ~Node() {
+            for (auto& child : children)
+                delete child.second;
+        }
+    };
+
+    Node root;
+    mutable shared_mutex mtx;
+    atomic<uint64_t> currentVersion{1};
+
+    static vector<string> split(const string& name) {
+        vector<string> levels;
+        size_t start = 0;
+        while (true) {
+            size_t dot = name.find('.', start);
+            levels.push_back(name.substr(start, dot - start));
+            if (dot == string::npos)
+                break;
+            start = dot + 1;
+        }
+        return levels;
+    }
+
+    static void collect(const Node* node, const vector<string>& levels,
+                        size_t i, vector<Subscriber*>& out) {
+        auto hash = node->children.find("#");
+        if (hash != node->children.end())
+            for (size_t j = i; j <= levels.size(); j++)
+                collect(hash->second, levels, j, out);
+
+        if (i == levels.size()) {
+            out.insert(out.end(), node->subscribers.begin(), node->subscribers.end());
+            return;
+        }
+
+        auto exact = node->children.find(levels[i]);
+        if (exact != node->children.end())
+            collect(exact->second, levels, i + 1, out);
+
+        auto star = node->children.find("*");
+        if (star != node->children.end() && levels[i] != "*")
+            collect(star->second, levels, i + 1, out);
+    }
+
+    // Drops nodes left with no subscribers and no children
+    static bool prune(Node* node, const vector<string>& levels, size_t i) {
+        if (i < levels.size()) {
+            auto it = node->children.find(levels[i]);
+            if (it != node->children.end() && prune(it->second, levels, i + 1)) {
+                delete it->second;
+                node->children.erase(it);
+            }
+        }
+        return node->children.empty() && node->subscribers.empty();
+    }
+
+public:
+    bool add(const string& pattern, Subscriber* subscriber) {
+        unique_lock<shared_mutex> lock(mtx);
+        Node* node = &root;
+        for (const string& level : split(pattern)) {
+            Node*& child = node->children[level];
+            if (!child)
+                child = new Node();
+            node = child;
+        }
+        auto& list = node->subscribers;
+        if (find(list.begin(), list.end(), subscriber) != list.end())
+            return false;
+        list.push_back(subscriber);
+        currentVersion.fetch_add(1, memory_order_release);
+        return true;
+    }
+
+    bool remove(const string& pattern, Subscriber* subscriber) {
+        unique_lock<shared_mutex> lock(mtx);
+        vector<string> levels = split(pattern);
+        Node* node = &root;
+        for (const string& level : levels) {
+            auto it = node->children.find(level);
+            if (it == node->children.end())
+                return false;
+            node = it->second;
+        }
+        auto& list = node->subscribers;
+        auto it = find(list.begin(), list.end(), subscriber);
+        if (it == list.end())
+            return false;
+        list.erase(it);
+        prune(&root, levels, 0);
+        currentVersion.fetch_add(1, memory_order_release);
+        return true;
+    }
+
+    // Every subscriber whose pattern matches the topic, once each
+    vector<Subscriber*> match(const string& topicName) const {
+        shared_lock<shared_mutex> lock(mtx);
+        vector<Subscriber*> matched;
+        collect(&root, split(topicName), 0, matched);
+        sort(matched.begin(), matched.end());
+        matched.erase(unique(matched.begin(), matched.end()), matched.end());
+        return matched;
+    }
+
+    uint64_t version() const {
+        return currentVersion.load(memory_order_acquire);
+    }
+};
+
+/*
+--------------------------------------------------
+DURABLE TOPIC LOG (optional, per topic)
+--------------------------------------------------
+- Append-only, split into fixed-size segment files named by
+  their first offset: <dir>/00000000000000000000.log
+- Segments are mmap'ed; appending is a memcpy into the mapping
+- A flusher thread msync()s the dirty tail (group commit):
+  one sync covers every message appended since the last one
+- awaitDurable(offset) blocks until that offset is on disk
+- On restart, segments are scanned and the first torn or
+  corrupt record marks the end of the log; everything past it
+  (stale tail, segments after a gap) is zeroed or removed
+- Oversized messages and I/O errors reject the append
+  (NO_OFFSET), the topic then drops the publish
+- replay() reads records sequentially from any offset
+
+Record layout (8-byte aligned):
+  [u32 length][u32 checksum][u64 offset][payload...]
+  the checksum covers length, offset and payload and is never 0;
+  checksum == 0 means "end of written data" (files are
+  zero-filled), so empty payloads (length 0) are valid records
+*/
+struct LogRecordHeader {
+    uint32_t length;
+    uint32_t checksum;
+    uint64_t offset;
+};
+
+class LogSegment {
+private:
+    int fd = -1;
+    char* data = nullptr;
+    size_t capacity = 0;
+
+public:
+    const uint64_t baseOffset;
+    size_t writePos = 0;                 // guarded by TopicLog::appendMtx
+    atomic<size_t> committedPos{0};      // readers may read up to here
+    size_t flushedPos = 0;               // owned by the flusher
+
+    static uint32_t fnv(uint32_t hash, const void* bytes, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(bytes);
+        for (size_t i = 0; i < size; i++)
+            hash = (hash ^ p[i]) * 16777619u;
+        return hash;
+    }
+
+    // FNV-1a over length, offset and payload; 0 is kept for "unwritten"
+    static uint32_t checksum(uint32_t length, uint64_t offset, const char* payload) {
+        uint32_t hash = fnv(2166136261u, &length, sizeof(length));
+        hash = fnv(hash, &offset, sizeof(offset));
+        hash = fnv(hash, payload, length);
+        return hash ? hash : 1;
+    }
+
+    static size_t recordSize(size_t payload) {
+        return (sizeof(LogRecordHeader) + payload + 7) & ~size_t(7);
+    }
+
+    static string fileName(uint64_t baseOffset) {
+        string digits = to_string(baseOffset);
+        return string(20 - digits.size(), '0') + digits + ".log";
+    }
+
+    // fresh = start an empty file (drops whatever a crashed run left)
+    LogSegment(const string& dir, uint64_t baseOffset, size_t capacity, bool fresh)
+        : capacity(capacity), baseOffset(baseOffset) {
+        string path = dir + "/" + fileName(baseOffset);
+        fd = open(path.c_str(), O_RDWR | O_CREAT | (fresh ? O_TRUNC : 0), 0644);
+        if (fd < 0 || ftruncate(fd, capacity) != 0) {
+            LOG_ERROR("[ERROR] Cannot open log segment {}", path);
+            return;
+        }
+        void* mapped = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            LOG_ERROR("[ERROR] Cannot map log segment {}", path);
+            return;
+        }
+        data = static_cast<char*>(mapped);
+    }
+
+    ~LogSegment() {
+        if (data)
+            munmap(data, capacity);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    bool isOpen() const {
+        return data != nullptr;
+    }
+
+    bool fits(size_t payload) const {
+        return writePos + recordSize(payload) + sizeof(LogRecordHeader) <= capacity;
+    }
+
+    void append(uint64_t offset, string_view payload) {
+        uint32_t length = (uint32_t)payload.size();
+        LogRecordHeader header{length, checksum(length, offset, payload.data()), offset};
+        char* at = data + writePos;
+        memcpy(at + sizeof(header), payload.data(), payload.size());
+        memcpy(at, &header, sizeof(header));
+        writePos += recordSize(payload.size());
+    }
+
+    void commit() {
+        committedPos.store(writePos, memory_order_release);
+    }
+
+    // Drops uncommitted records back to pos (a failed batch)
+    void rollback(size_t pos) {
+        memset(data + pos, 0, writePos - pos);
+        writePos = pos;
+    }
+
+    // Recovery: walk valid records; returns the next offset
+    uint64_t recover() {
+        uint64_t expected = baseOffset;
+        size_t pos = 0;
+        while (pos + sizeof(LogRecordHeader) <= capacity) {
+            LogRecordHeader header;
+            memcpy(&header, data + pos, sizeof(header));
+            if (header.checksum == 0 || header.offset != expected ||
+                pos + recordSize(header.length) > capacity ||
+                header.checksum != checksum(header.length, header.offset, data + pos + sizeof(header)))
+                break;
+            pos += recordSize(header.length);
+            expected++;
+        }
+        // Zero the torn/stale tail so no old record can chain on later
+        // (shrink + regrow lets the kernel do it without dirtying pages)
+        if (ftruncate(fd, pos) != 0 || ftruncate(fd, capacity) != 0)
+            memset(data + pos, 0, capacity - pos);
+        fsync(fd);
+        writePos = flushedPos = pos;
+        committedPos.store(pos);
+        return expected;
+    }
+
+    // Sequential scan from the start; fn(offset, payload) for offset >= from
+    template<typename Fn>
+    uint64_t read(uint64_t from, Fn fn) const {
+        size_t end = committedPos.load(memory_order_acquire);
+        size_t pos = 0;
+        uint64_t next = baseOffset;
+        while (pos < end) {
+            LogRecordHeader header;
+            memcpy(&header, data + pos, sizeof(header));
+            if (header.offset >= from)
+                fn(header.offset, string_view(data + pos + sizeof(header), header.length));
+            next = header.offset + 1;
+            pos += recordSize(header.length);
+        }
+        return next;
+    }
+
+    // Group commit: sync [flushedPos, upTo) to disk
+    void flush(size_t upTo) {
+        if (upTo <= flushedPos)
+            return;
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t start = flushedPos & ~(page - 1);
+        msync(data + start, upTo - start, MS_SYNC);
+        flushedPos = upTo;
+    }
+};
+
+class TopicLog {
+private:
+    string dir;
+    size_t segmentSize;
+    chrono::microseconds flushInterval;
+
+    mutex appendMtx;
+    vector<LogSegment*> segments;
+    uint64_t nextOffset = 0;
+    size_t firstDirty = 0;               // oldest segment that may need a sync
+    bool broken = false;                 // an existing segment failed to open
+
+    thread flusher;
+    mutex flushMtx;
+    condition_variable flushRequested;
+    condition_variable flushed;
+    bool running = true;
+    bool syncWanted = false;
+    atomic<uint64_t> durableOffset{0};   // every offset below is on disk
+    atomic<uint64_t> syncCount{0};
+
+    // Makes file creations/removals in dir survive a crash
+    void syncDir() {
+        int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+    }
+
+    // Caller holds appendMtx (or is the constructor); nullptr on I/O error
+    LogSegment* addSegment(uint64_t base, bool fresh) {
+        LogSegment* segment = new LogSegment(dir, base, segmentSize, fresh);
+        if (!segment->isOpen()) {
+            delete segment;
+            return nullptr;
+        }
+        segments.push_back(segment);
+        if (fresh)
+            syncDir();
+        return segment;
+    }
+
+    void open() {
+        filesystem::create_directories(dir);
+        vector<uint64_t> bases;
+        for (auto& entry : filesystem::directory_iterator(dir))
+            if (entry.path().extension() == ".log")
+                bases.push_back(stoull(entry.path().stem().string()));
+        sort(bases.begin(), bases.end());
+
+        size_t used = 0;
+        for (; used < bases.size(); used++) {
+            if (used > 0 && bases[used] != nextOffset)
+                break;                   // gap after a torn segment
+            if (!addSegment(bases[used], false)) {
+                broken = true;           // keep the files, refuse appends
+                break;
+            }
+            nextOffset = segments.back()->recover();
+        }
+        if (!broken) {
+            // Segments past the gap are unreachable: drop them before
+            // a new segment with the same base name could reuse one
+            bool removed = false;
+            for (size_t i = used; i < bases.size(); i++) {
+                error_code ignored;
+                removed |= filesystem::remove(dir + "/" + LogSegment::fileName(bases[i]), ignored);
+            }
+            if (removed)
+                syncDir();
+            if (segments.empty())
+                addSegment(nextOffset, true);
+        }
+        firstDirty = segments.empty() ? 0 : segments.size() - 1;
+        durableOffset.store(nextOffset);
+    }
+
+    // Caller holds appendMtx; nullptr rejects the append
+    LogSegment* segmentFor(size_t payload) {
+        if (broken)
+            return nullptr;
+        if (LogSegment::recordSize(payload) + sizeof(LogRecordHeader) > segmentSize) {
+            LOG_ERROR("[ERROR] Message of {} bytes is larger than a log segment", payload);
+            return nullptr;
+        }
+        if (!segments.empty() && segments.back()->fits(payload))
+            return segments.back();
+        return addSegment(nextOffset, true);
+    }
+
+    // Caller holds appendMtx: undoes a batch nothing has committed yet
+    void rollbackBatch(uint64_t first, size_t segmentCount, size_t startPos) {
+        bool removed = false;
+        while (segments.size() > segmentCount) {
+            uint64_t base = segments.back()->baseOffset;
+            delete segments.back();
+            segments.pop_back();
+            error_code ignored;
+            removed |= filesystem::remove(dir + "/" + LogSegment::fileName(base), ignored);
+        }
+        if (removed)
+            syncDir();
+        if (!segments.empty())
+            segments.back()->rollback(startPos);
+        firstDirty = min(firstDirty, segments.empty() ? 0 : segments.size() - 1);
+        nextOffset = first;
+    }
+
+    template<typename Fn>
+    static uint64_t replaySegments(const vector<LogSegment*>& list, uint64_t from, Fn fn) {
+        // Sorted by base offset: skip whole files before `from`
+        size_t first = 0;
+        while (first + 1 < list.size() && list[first + 1]->baseOffset <= from)
+            first++;
+
+        uint64_t next = from;
+        for (size_t i = first; i < list.size(); i++)
+            next = max(next, list[i]->read(from, fn));
+        return next;
+    }
+
+    void flushNow() {
+        vector<pair<LogSegment*, size_t>> dirty;
+        uint64_t target;
+        {
+            lock_guard<mutex> lock(appendMtx);
+            target = nextOffset;
+            for (size_t i = firstDirty; i < segments.size(); i++)
+                dirty.push_back({segments[i], segments[i]->writePos});
+            if (!segments.empty())
+                firstDirty = segments.size() - 1;
+        }
+        if (target == durableOffset.load())
+            return;
+        for (auto& d : dirty)
+            d.first->flush(d.second);
+        syncCount.fetch_add(1, memory_order_relaxed);
+
+        lock_guard<mutex> lock(flushMtx);
+        durableOffset.store(target);
+        flushed.notify_all();
+    }
+
+    void flushLoop() {
+        unique_lock<mutex> lock(flushMtx);
+        while (running) {
+            flushRequested.wait_for(lock, flushInterval, [this]() { return !running || syncWanted; });
+            syncWanted = false;
+            lock.unlock();
+            flushNow();
+            lock.lock();
+        }
+        lock.unlock();
+        flushNow();
+    }
+
+public:
+    TopicLog(const string& dir,
+             size_t segmentSize = 16 << 20,
+             chrono::microseconds flushInterval = chrono::milliseconds(2))
+        : dir(dir), segmentSize(segmentSize), flushInterval(flushInterval) {
+        open();
+        flusher = thread(&TopicLog::flushLoop, this);
+    }
+
+    ~TopicLog() {
+        {
+            lock_guard<mutex> lock(flushMtx);
+            running = false;
+            flushRequested.notify_one();
+        }
+        flusher.join();
+        for (LogSegment* segment : segments)
+            delete segment;
+    }
+
+    TopicLog(const TopicLog&) = delete;
+    TopicLog& operator=(const TopicLog&) = delete;
+
+    static constexpr uint64_t NO_OFFSET = UINT64_MAX;
+
+    // Returns the message's offset (NO_OFFSET if rejected); durable within ~flushInterval
+    uint64_t append(const Message& msg) {
+        lock_guard<mutex> lock(appendMtx);
+        LogSegment* segment = segmentFor(msg.size());
+        if (!segment)
+            return NO_OFFSET;
+        uint64_t offset = nextOffset++;
+        segment->append(offset, msg.view());
+        segment->commit();
+        return offset;
+    }
+
+    /*
+     Returns the first offset of the batch.
+     NO_OFFSET if rejected: an oversized message or an I/O error
+     rejects the whole batch, nothing of it stays in the log.
+    */
+    uint64_t appendBatch(const Message* batch, size_t count) {
+        lock_guard<mutex> lock(appendMtx);
+        for (size_t i = 0; i < count; i++)
+            if (LogSegment::recordSize(batch[i].size()) + sizeof(LogRecordHeader) > segmentSize) {
+                LOG_ERROR("[ERROR] Message of {} bytes is larger than a log segment", batch[i].size());
+                return NO_OFFSET;
+            }
+        uint64_t first = nextOffset;
+        size_t firstSegment = segments.empty() ? 0 : segments.size() - 1;
+        size_t segmentCount = segments.size();
+        size_t startPos = segments.empty() ? 0 : segments.back()->writePos;
+        for (size_t i = 0; i < count; i++) {
+            LogSegment* segment = segmentFor(batch[i].size());
+            if (!segment) {
+                rollbackBatch(first, segmentCount, startPos);
+                return NO_OFFSET;
+            }
+            segment->append(nextOffset++, batch[i].view());
+        }
+        // Readers see the batch only once all of it is written
+        for (size_t i = firstSegment; i < segments.size(); i++)
+            segments[i]->commit();
+        return first;
+    }
+
+    /*
+     Blocks until offset is on disk; concurrent callers share one sync.
+     Returns false at once for an offset that was never appended.
+    */
+    bool awaitDurable(uint64_t offset) {
+        if (offset >= endOffset())
+            return false;
+        unique_lock<mutex> lock(flushMtx);
+        while (durableOffset.load() <= offset) {
+            syncWanted = true;
+            flushRequested.notify_one();
+            flushed.wait(lock);
+        }
+        return true;
+    }
+
+    // fn(offset, payload) for every record in [from, end); returns end
+    template<typename Fn>
+    uint64_t replay(uint64_t from, Fn fn) {
+        vector<LogSegment*> snapshot;
+        {
+            lock_guard<mutex> lock(appendMtx);
+            snapshot = segments;
+        }
+        return replaySegments(snapshot, from, fn);
+    }
+
+    /*
+     Replays the (short) tail [from, end) with appends paused, then
+     runs goLive() before appenders resume: nothing falls in a gap.
+    */
+    template<typename Fn, typename GoLive>
+    uint64_t finishReplay(uint64_t from, Fn fn, GoLive goLive) {
+        lock_guard<mutex> lock(appendMtx);
+        uint64_t next = replaySegments(segments, from, fn);
+        goLive();
+        return next;
+    }
+
+    uint64_t endOffset() {
+        lock_guard<mutex> lock(appendMtx);
+        return nextOffset;
+    }
+
+    uint64_t getSyncCount() const {
+        return syncCount.load();
+    }
+};
+
+/*
+ RAII subscription from Topic::subscribe(handle).
+ Move-only; unsubscribes on destruction or reset(). Topics live
+ as long as the broker, so a token must not outlive its broker.
+*/
+class Subscription {
+    Topic* topic = nullptr;
+    SubscriberHandle handle;
+
+public:
+    Subscription() = default;
+    Subscription(Topic* topic, const SubscriberHandle& handle)
+        : topic(topic), handle(handle) {}
+
+    Subscription(Subscription&& other) noexcept
+        : topic(other.topic), handle(other.handle) {
+        other.topic = nullptr;
+    }
+
+    Subscription& operator=(Subscription&& other) noexcept {
+        if (this != &other) {
+            reset();
+            topic = other.topic;
+            handle = other.handle;
+            other.topic = nullptr;
+        }
+        return *this;
+    }
+
+    Subscription(const Subscription&) = delete;
+    Subscription& operator=(const Subscription&) = delete;
+
+    ~Subscription() {
+        reset();
+    }
+
+    void reset();
+
+    bool active() const {
+        return topic != nullptr;
+    }
+};
+
+class Topic {
+private:
+    // Cached pattern matches, tagged with the index version they came from
+    struct PatternMatches {
+        uint64_t version = 0;
+        vector<Subscriber*> subscribers;
+    };
+
+    string topicName;
+    RcuPtr<vector<SubscriberHandle>> subscribers;
+    const TopicPatternIndex* patterns;
+    RcuPtr<PatternMatches> patternMatches;
+    atomic<TopicLog*> log{nullptr};
+
+    // Messages published here; fan-out is shared by every topic
+    Metrics::Counter& published;
+    Metrics::Histogram& fanout;
+
+    // Call under an EpochGuard. Steady state = one version compare.
+    const vector<Subscriber*>& matchedPatterns() {
+        static const vector<Subscriber*> none;
+        if (!patterns)
+            return none;
+
+        const PatternMatches* cached = patternMatches.read();
+        uint64_t version = patterns->version();
+        if (cached->version == version)
+            return cached->subscribers;
+
+        // Invalidated by a pattern (un)subscribe: re-match once
+        vector<Subscriber*> matched = patterns->match(topicName);
+        patternMatches.update([&](PatternMatches& next) {
+            if (next.version >= version)
+                return false;               // a newer refresh won
+            next.version = version;
+            next.subscribers = move(matched);
+            return true;
+        });
+        return patternMatches.read()->subscribers;
+    }
+
+public:
+    Topic(const string& name, const TopicPatternIndex* patterns = nullptr)
+        : topicName(name), patterns(patterns),
+          published(Metrics::counter("pubsub_published_messages_total",
+                                     "Messages published per topic", "topic=\"" + name + "\"")),
+          fanout(Metrics::histogram("pubsub_fanout_subscribers",
+                                    "Subscribers reached by one deliver / deliverBatch call")) {}
+
+    ~Topic() {
+        delete log.load();
+    }
+
+    // Optional durability: every publish is appended before fan-out
+    void enableLog(const string& dir) {
+        TopicLog* created = new TopicLog(dir);
+        TopicLog* expected = nullptr;
+        if (!log.compare_exchange_strong(expected, created))
+            delete created;
+        else
+            LOG_INFO("[LOG] {} persisted in {} (next offset {})", topicName, dir, created->endOffset());
+    }
+
+    TopicLog* getLog() {
+        return log.load(memory_order_acquire);
+    }
+
+    /*
+     Reconnect a subscriber at an offset:
+     1. Replay history with sequential reads (publishers keep going)
+     2. Pause appends, replay the short remaining tail, go live
+     At-least-once: a message appended but not yet fanned out at
+     the moment the subscriber goes live can arrive twice.
+    */
+    uint64_t resume(Subscriber* subscriber, uint64_t fromOffset) {
+        TopicLog* durable = getLog();
+        if (!durable) {
+            LOG_ERROR("[ERROR] No log to replay for topic: {}", topicName);
+            return 0;
+        }
+
+        uint64_t replayed = 0;
+        auto replayTo = [&](uint64_t, string_view payload) {
+            subscriber->notify(topicName, Message(payload));
+            replayed++;
+        };
+        uint64_t next = durable->replay(fromOffset, replayTo);
+        next = durable->finishReplay(next, replayTo, [&]() { subscribe(subscriber); });
+
+        LOG_INFO("[REPLAY] {} caught up on {} messages, live from offset {}", subscriber->getName(), replayed, next);
+        return next;
+    }
+
+private:
+    bool attach(const SubscriberHandle& handle) {
+        return subscribers.update([&handle](vector<SubscriberHandle>& list) {
+            if (find(list.begin(), list.end(), handle) != list.end())
+                return false;
+            list.push_back(handle);
+            return true;
+        });
+    }
+
+    bool detach(const SubscriberHandle& handle) {
+        return subscribers.update([&handle](vector<SubscriberHandle>& list) {
+            auto it = find(list.begin(), list.end(), handle);
+            if (it == list.end())
+                return false;
+            list.erase(it);
+            return true;
+        });
+    }
+
+    // A destroyed subscriber left entries behind: drop them once
+    void pruneExpired() {
+        subscribers.update([](vector<SubscriberHandle>& list) {
+            auto expired = remove_if(list.begin(), list.end(),
+                [](const SubscriberHandle& handle) { return !handle.alive(); });
+            if (expired == list.end())
+                return false;
+            list.erase(expired, list.end());
+            return true;
+        });
+    }
+
+public:
+    // Any subscriber that could be destroyed while subscribed
+    // should come from a SubscriberPool and use the token overload
+    void subscribe(Subscriber* subscriber) {
+        bool added = attach(SubscriberHandle::unmanaged(subscriber));
+
+        if (!added)
+            LOG_INFO("[INFO] {} already subscribed to {}", subscriber->getName(), topicName);
+        else
+            LOG_INFO("[SUBSCRIBE] {} subscribed to {}", subscriber->getName(), topicName);
+    }
+
+    void unSubscribe(Subscriber* subscriber) {
+        bool removed = detach(SubscriberHandle::unmanaged(subscriber));
+
+        if (!removed)
+            LOG_INFO("[INFO] {} is not subscribed to {}", subscriber->getName(), topicName);
+        else
+            LOG_INFO("[UNSUBSCRIBE] {} unsubscribed from {}", subscriber->getName(), topicName);
+    }
+
+    /*
+     Pooled subscriber: the returned token unsubscribes when it
+     dies. If the subscriber is destroyed first, fan-out skips
+     its entry (one generation compare) and prunes it.
+    */
+    Subscription subscribe(const SubscriberHandle& handle) {
+        EpochGuard guard;               // keeps the target alive for getName()
+        if (!handle.alive()) {
+            LOG_WARN("[FAILED] Expired subscriber handle for {}", topicName);
+            return Subscription();
+        }
+        if (!attach(handle)) {
+            LOG_INFO("[INFO] {} already subscribed to {}", handle.target->getName(), topicName);
+            return Subscription();
+        }
+        LOG_INFO("[SUBSCRIBE] {} subscribed to {}", handle.target->getName(), topicName);
+        return Subscription(this, handle);
+    }
+
+    void unSubscribe(const SubscriberHandle& handle) {
+        EpochGuard guard;
+        bool removed = detach(handle);
+        if (!removed)
+            return;
+        if (handle.alive())
+            LOG_INFO("[UNSUBSCRIBE] {} unsubscribed from {}", handle.target->getName(), topicName);
+        else
+            LOG_INFO("[UNSUBSCRIBE] Expired subscriber removed from {}", topicName);
+    }
+
+    size_t subscriberCount() {
+        EpochGuard guard;
+        return subscribers.read()->size();
+    }
+
+    // Lock-free fan-out over the current snapshot; false if the log rejected it
+    bool deliver(const Message& msg) {
+        if (TopicLog* durable = log.load(memory_order_acquire))
+            if (durable->append(msg) == TopicLog::NO_OFFSET) {
+                LOG_ERROR("[ERROR] Log rejected a message, not delivered on {}", topicName);
+                return false;
+            }
+        EpochGuard guard;
+        bool expired = false;
+        size_t reached = 0;
+        for (const SubscriberHandle& handle : *subscribers.read()) {
+            if (handle.alive()) {
+                handle.target->notify(topicName, msg);
+                reached++;
+            } else {
+                expired = true;
+            }
+        }
+        const vector<Subscriber*>& matched = matchedPatterns();
+        for (Subscriber* subscriber : matched)
+            subscriber->notify(topicName, msg);
+        published.inc();
+        fanout.record(reached + matched.size());
+        if (expired)
+            pruneExpired();
+        return true;
+    }
+
+    // One guard and one snapshot read for the whole batch
+    bool deliverBatch(const Message* batch, size_t count) {
+        if (TopicLog* durable = log.load(memory_order_acquire))
+            if (durable->appendBatch(batch, count) == TopicLog::NO_OFFSET) {
+                LOG_ERROR("[ERROR] Log rejected a batch, not delivered on {}", topicName);
+                return false;
+            }
+        EpochGuard guard;
+        bool expired = false;
+        size_t reached = 0;
+        for (const SubscriberHandle& handle : *subscribers.read()) {
+            if (handle.alive()) {
+                handle.target->notifyBatch(topicName, batch, count);
+                reached++;
+            } else {
+                expired = true;
+            }
+        }
+        const vector<Subscriber*>& matched = matchedPatterns();
+        for (Subscriber* subscriber : matched)
+            subscriber->notifyBatch(topicName, batch, count);
+        published.inc(count);
+        fanout.record(reached + matched.size());
+        if (expired)
+            pruneExpired();
+        return true;
+    }
+
+    void notify(const Message& msg) {
+        LOG_INFO("\n[PUBLISH] Message on topic: {}", topicName);
+        deliver(msg);
+    }
+
+    const string& getName() const {
+        return topicName;
+    }
+};
+
+void Subscription::reset() {
+    if (topic)
+        topic->unSubscribe(handle);
+    topic = nullptr;
+}
+
+class Broker {
+private:
+    using TopicMap = unordered_map<string, Topic*>;
+
+    static const int SHARD_COUNT = 16;
+
+    // One copy-on-write map per shard: creating a topic copies
+    // only its shard, and creators of different shards never contend
+    struct alignas(64) Shard {
+        RcuPtr<TopicMap> topics;
+    };
+
+    Shard shards[SHARD_COUNT];
+    TopicPatternIndex patterns;
+
+    Shard& shardFor(const string& topicName) {
+        return shards[hash<string>{}(topicName) % SHARD_COUNT];
+    }
+
+public:
+    Topic* createTopic(const string& topicName) {
+        Topic* topic = nullptr;
+        bool created = shardFor(topicName).topics.update([&](TopicMap& topics) {
+            auto it = topics.find(topicName);
+            if (it != topics.end()) {
+                topic = it->second;
+                return false;
+            }
+            topic = new Topic(topicName, &patterns);
+            topics.emplace(topicName, topic);
+            return true;
+        });
+
+        if (!created)
+            LOG_INFO("[INFO] Topic already exists: {}", topicName);
+        else
+            LOG_INFO("[BROKER] Created topic: {}", topicName);
+        return topic;
+    }
+
+    // Lock-free lookup; topics live as long as the broker
+    Topic* getTopic(const string& name) {
+        EpochGuard guard;
+        const TopicMap* topics = shardFor(name).topics.read();
+        auto it = topics->find(name);
+        if (it == topics->end()) {
+            LOG_ERROR("[ERROR] No topic named: {}", name);
+            return nullptr;
+        }
+        return it->second;
+    }
+
+    /*
+     Pattern subscriptions apply to every topic, existing or
+     created later. "*" = one level, "#" = zero or more levels.
+    */
+    void subscribePattern(const string& pattern, Subscriber* subscriber) {
+        if (!patterns.add(pattern, subscriber))
+            LOG_INFO("[INFO] {} already subscribed to pattern {}", subscriber->getName(), pattern);
+        else
+            LOG_INFO("[SUBSCRIBE] {} subscribed to pattern {}", subscriber->getName(), pattern);
+    }
+
+    void unSubscribePattern(const string& pattern, Subscriber* subscriber) {
+        if (!patterns.remove(pattern, subscriber))
+            LOG_INFO("[INFO] {} is not subscribed to pattern {}", subscriber->getName(), pattern);
+        else
+            LOG_INFO("[UNSUBSCRIBE] {} unsubscribed from pattern {}", subscriber->getName(), pattern);
+    }
+
+    ~Broker() {
+        for (Shard& shard : shards)
+            for (auto& entry : *shard.topics.read())
+                delete entry.second;
+    }
+};
+
+/*
+ A resolved topic. Topics live as long as the broker, so a
+ handle stays valid and skips the name lookup on every publish.
 */
+using TopicHandle = Topic*;
+
+class Publisher {
+    Broker* broker;
+    string publisherName;
+
+public:
+    Publisher(string name, Broker* broker)
+        : broker(broker), publisherName(name) {}
+
+    void publishMessage(const string& topic, const string& msg) {
+        LOG_INFO("\n[PUBLISHER] {} publishing to {}", publisherName, topic);
+
+        Topic* topicObj = broker->getTopic(topic);
+        if (!topicObj)
+            LOG_WARN("[FAILED] Topic does not exist: {}", topic);
+        else
+            topicObj->notify(Message(msg));
+    }
+
+    /*
+     HOT PATH: resolve once, then publish by handle.
+     No hashing, no allocation, no logging per message.
+    */
+    TopicHandle resolve(const string& topic) {
+        return broker->getTopic(topic);
+    }
+
+    // false = the topic's log rejected the message (nothing delivered)
+    bool publish(TopicHandle topic, const Message& msg) {
+        return topic->deliver(msg);
+    }
+
+    bool publishBatch(TopicHandle topic, const Message* batch, size_t count) {
+        return topic->deliverBatch(batch, count);
+    }
+
+    bool publishBatch(TopicHandle topic, const vector<Message>& batch) {
+        return topic->deliverBatch(batch.data(), batch.size());
+    }
+};
+
+/*
+--------------------------------------------------
+ASYNC DELIVERY
+--------------------------------------------------
+- DeliveryPool::async(subscriber, policy) wraps a subscriber
+  in an AsyncSubscriber (Decorator over Subscriber)
+- Topic fan-out only enqueues into the wrapper's bounded ring
+- A pool worker drains the ring and calls the real subscriber
+- A slow subscriber now fills its own queue instead of
+  stalling every publisher; the policy decides what happens
+  when that queue is full
+*/
+enum BackpressurePolicy {
+    BLOCK,          // publisher waits for space (no loss)
+    DROP_OLDEST,    // evict the oldest queued message
+    DROP_NEWEST     // reject the message being published
+};
+
+/*
+ Bounded lock-free ring (Vyukov MPMC).
+ - Many publishers push
+ - The owning worker pops; DROP_OLDEST publishers pop too,
+   which is why this is multi-consumer
+ - Capacity is rounded up to a power of two
+*/
+template<typename T>
+class BoundedQueue {
+private:
+    struct Cell {
+        atomic<size_t> sequence;
+        T value;
+    };
+
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos{0};
+    alignas(64) atomic<size_t> dequeuePos{0};
+
+public:
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++)
+            cells[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    // Moves from value only on success
+    bool tryPush(T& value) {
+        Cell* cell;
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;               // full
+            else
+                pos = enqueuePos.load(memory_order_relaxed);
+        }
+        cell->value = move(value);
+        cell->sequence.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        Cell* cell;
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;               // empty
+            else
+                pos = dequeuePos.load(memory_order_relaxed);
+        }
+        out = move(cell->value);
+        cell->sequence.store(pos + mask + 1, memory_order_release);
+        return true;
+    }
 
+    bool empty() const {
+        return enqueuePos.load() == dequeuePos.load();
+    }
+};
 
+// Publish -> deliver latency in ns, recorded by one delivery worker
+// and read after it has been joined (common/LogHistogram.h)
+typedef LogHistogram<3> LatencyHistogram;
 
-#include<iostream>
-#include<unordered_map>
-#include<unordered_set>
-using namespace std;
+class DeliveryWorker;
 
-class Subscriber;
-class Topic;
+struct Delivery {
+    const string* topicName = nullptr;  // topics outlive their messages
+    Message msg;                        // shared, not copied
+    chrono::steady_clock::time_point publishedAt;
+};
 
-class Subscriber {
-    string subscriberName;
+class AsyncSubscriber : public Subscriber {
+private:
+    Subscriber* target;
+    BackpressurePolicy policy;
+    BoundedQueue<Delivery> queue;
+    DeliveryWorker* worker;
+    atomic<uint64_t> dropped{0};
+    atomic<int> pushing{0};             // enqueues past their stopped() check
+
+    bool push(Delivery& delivery);
 
 public:
-    Subscriber(string name) : subscriberName(name) {}
+    AsyncSubscriber(Subscriber* target, BackpressurePolicy policy,
+                    size_t capacity, DeliveryWorker* worker)
+        : Subscriber(target->getName()), target(target),
+          policy(policy), queue(capacity), worker(worker) {}
+
+    // Run on the publisher thread: enqueue only
+    void notify(const string& topicName, const Message& msg) override;
+    void notifyBatch(const string& topicName, const Message* batch, size_t count) override;
+
+    // Applies the backpressure policy; false if the message was dropped
+    bool enqueue(const string& topicName, const Message& msg,
+                 chrono::steady_clock::time_point publishedAt);
 
-    void notify(const string& topicName, const string& msg) {
-        cout << "[NOTIFY] " << subscriberName
-             << " received on [" << topicName << "]: "
-             << msg << endl;
+    // Runs on the worker thread; returns how many were delivered
+    int drain(int budget, LatencyHistogram& latency) {
+        Delivery delivery;
+        int delivered = 0;
+        while (delivered < budget && queue.tryPop(delivery)) {
+            auto waited = chrono::steady_clock::now() - delivery.publishedAt;
+            latency.record(chrono::duration_cast<chrono::nanoseconds>(waited).count());
+            target->notify(*delivery.topicName, delivery.msg);
+            delivered++;
+        }
+        return delivered;
     }
 
-    string getName() const {
-        return subscriberName;
+    // Counts a push still in flight, so the final drain waits for it
+    bool hasPending() const {
+        return pushing.load() > 0 || !queue.empty();
+    }
+
+    uint64_t getDropped() const {
+        return dropped.load();
     }
 };
 
-class Topic {
+/*
+ One worker thread draining a fixed set of mailboxes.
+ Each mailbox belongs to exactly one worker, so per-subscriber
+ ordering is preserved. Idle workers sleep; publishers wake
+ them only if they are actually asleep.
+*/
+class DeliveryWorker {
 private:
-    string topicName;
-    unordered_set<Subscriber*> subscribers;
+    static const int DRAIN_BUDGET = 64;     // fairness between mailboxes
+
+    RcuPtr<vector<AsyncSubscriber*>> mailboxes;
+    LatencyHistogram latency;
+    atomic<bool> running{true};
+    atomic<bool> sleeping{false};
+    mutex sleepMtx;
+    condition_variable wakeUp;
+    thread worker;
+
+    bool drainOnce() {
+        EpochGuard guard;
+        bool didWork = false;
+        for (AsyncSubscriber* mailbox : *mailboxes.read())
+            didWork |= mailbox->drain(DRAIN_BUDGET, latency) > 0;
+        return didWork;
+    }
+
+    bool hasPending() {
+        EpochGuard guard;
+        for (AsyncSubscriber* mailbox : *mailboxes.read())
+            if (mailbox->hasPending())
+                return true;
+        return false;
+    }
+
+    void run() {
+        while (true) {
+            if (drainOnce())
+                continue;
+            if (!running.load()) {
+                if (drainOnce())
+                    continue;
+                if (hasPending()) {         // a publisher is mid-push
+                    this_thread::yield();
+                    continue;
+                }
+                break;                      // stopped and fully drained
+            }
+
+            unique_lock<mutex> lock(sleepMtx);
+            sleeping.store(true);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (running.load() && !hasPending())
+                wakeUp.wait_for(lock, chrono::milliseconds(100));
+            sleeping.store(false);
+        }
+    }
 
 public:
-    Topic(const string& name) : topicName(name) {}
+    DeliveryWorker() : worker(&DeliveryWorker::run, this) {}
 
-    void subscribe(Subscriber* subscriber) {
-        if (subscribers.find(subscriber) != subscribers.end())
-            cout << "[INFO] " << subscriber->getName()
-                 << " already subscribed to " << topicName << endl;
-        else {
-            subscribers.insert(subscriber);
-            cout << "[SUBSCRIBE] " << subscriber->getName()
-                 << " subscribed to " << topicName << endl;
+    void add(AsyncSubscriber* mailbox) {
+        mailboxes.update([mailbox](vector<AsyncSubscriber*>& list) {
+            list.push_back(mailbox);
+            return true;
+        });
+    }
+
+    // Set by stop(): publishers must not wait on this worker any more
+    bool stopped() const {
+        return !running.load();
+    }
+
+    // Called by publishers after an enqueue
+    void wake() {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (sleeping.load(memory_order_relaxed)) {
+            lock_guard<mutex> lock(sleepMtx);
+            wakeUp.notify_one();
         }
     }
 
-    void unSubscribe(Subscriber* subscriber) {
-        if (subscribers.find(subscriber) == subscribers.end())
-            cout << "[INFO] " << subscriber->getName()
-                 << " is not subscribed to " << topicName << endl;
-        else {
-            subscribers.erase(subscriber);
-            cout << "[UNSUBSCRIBE] " << subscriber->getName()
-                 << " unsubscribed from " << topicName << endl;
+    // Delivers everything still queued, then joins
+    void stop() {
+        if (!worker.joinable())
+            return;
+        running.store(false);
+        {
+            lock_guard<mutex> lock(sleepMtx);
+            wakeUp.notify_one();
         }
+        worker.join();
     }
 
-    void notify(const string& msg) {
-        cout << "\n[PUBLISH] Message on topic: " << topicName << endl;
-        for (auto subscriber : subscribers)
-            subscriber->notify(topicName, msg);
+    const LatencyHistogram& getLatency() const {
+        return latency;
+    }
+
+    ~DeliveryWorker() {
+        stop();
     }
 };
 
-class Broker {
+bool AsyncSubscriber::enqueue(const string& topicName, const Message& msg,
+                              chrono::steady_clock::time_point publishedAt) {
+    Delivery delivery;
+    delivery.topicName = &topicName;
+    delivery.msg = msg;
+    delivery.publishedAt = publishedAt;
+
+    // A stopped pool drains no more: refuse instead of queueing
+    // (or, under BLOCK, waiting forever for space). pushing is raised
+    // before stopped() is read and stop() lowers running before the
+    // worker reads pushing (all seq_cst), so either this push is
+    // refused or the worker's final drain waits for it and delivers it
+    pushing.fetch_add(1);
+    bool queued = false;
+    if (worker->stopped())
+        dropped.fetch_add(1, memory_order_relaxed);
+    else
+        queued = push(delivery);
+    pushing.fetch_sub(1);
+    return queued;
+}
+
+bool AsyncSubscriber::push(Delivery& delivery) {
+    if (policy == BLOCK) {
+        while (!queue.tryPush(delivery)) {
+            if (worker->stopped()) {
+                dropped.fetch_add(1, memory_order_relaxed);
+                return false;
+            }
+            worker->wake();
+            this_thread::yield();
+        }
+    }
+    else if (policy == DROP_OLDEST) {
+        while (!queue.tryPush(delivery)) {
+            Delivery evicted;
+            if (queue.tryPop(evicted))
+                dropped.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    else if (!queue.tryPush(delivery)) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void AsyncSubscriber::notify(const string& topicName, const Message& msg) {
+    if (enqueue(topicName, msg, chrono::steady_clock::now()))
+        worker->wake();
+}
+
+void AsyncSubscriber::notifyBatch(const string& topicName, const Message* batch, size_t count) {
+    auto publishedAt = chrono::steady_clock::now();
+    bool queued = false;
+    for (size_t i = 0; i < count; i++)
+        queued |= enqueue(topicName, batch[i], publishedAt);
+    if (queued)
+        worker->wake();
+}
+
+class DeliveryPool {
 private:
-    unordered_map<string, Topic*> topics;
+    vector<DeliveryWorker*> workers;
+    vector<AsyncSubscriber*> mailboxes;
+    mutex registerMtx;
+    size_t nextWorker = 0;
 
 public:
-    Topic* createTopic(const string& topicName) {
-        if (topics.find(topicName) != topics.end()) {
-            cout << "[INFO] Topic already exists: " << topicName << endl;
-            return topics[topicName];
+    DeliveryPool(int workerCount) {
+        for (int i = 0; i < max(1, workerCount); i++)
+            workers.push_back(new DeliveryWorker());
+    }
+
+    // Subscribe the returned wrapper instead of the subscriber itself
+    Subscriber* async(Subscriber* target, BackpressurePolicy policy,
+                      size_t capacity = 1024) {
+        lock_guard<mutex> lock(registerMtx);
+        DeliveryWorker* worker = workers[nextWorker++ % workers.size()];
+        AsyncSubscriber* mailbox = new AsyncSubscriber(target, policy, capacity, worker);
+        mailboxes.push_back(mailbox);
+        worker->add(mailbox);
+        return mailbox;
+    }
+
+    // Stop accepting work: drains every queue and joins the workers.
+    // Later publishes to its mailboxes are dropped (and counted)
+    void shutdown() {
+        for (DeliveryWorker* worker : workers)
+            worker->stop();
+    }
+
+    // After shutdown(): the histograms are plain, the workers own them
+    void printLatency(const string& label) const {
+        LatencyHistogram merged;
+        for (DeliveryWorker* worker : workers)
+            merged.merge(worker->getLatency());
+        cout << label
+             << " samples=" << merged.count()
+             << " p50=" << merged.percentile(0.50) / 1000.0 << "us"
+             << " p99=" << merged.percentile(0.99) / 1000.0 << "us"
+             << " p999=" << merged.percentile(0.999) / 1000.0 << "us"
+             << " max=" << merged.max() / 1000.0 << "us" << endl;
+    }
+
+    uint64_t dropped() const {
+        uint64_t total = 0;
+        for (AsyncSubscriber* mailbox : mailboxes)
+            total += mailbox->getDropped();
+        return total;
+    }
+
+    ~DeliveryPool() {
+        shutdown();
+        for (DeliveryWorker* worker : workers)
+            delete worker;
+        for (AsyncSubscriber* mailbox : mailboxes)
+            delete mailbox;
+    }
+};
+
+/*
+--------------------------------------------------
+BENCHMARK: publish throughput vs publisher threads
+--------------------------------------------------
+- TOPIC_COUNT topics, SUBSCRIBERS_PER_TOPIC silent subscribers each
+- Each publisher thread walks the topics round-robin
+- A churn thread keeps subscribing/unsubscribing meanwhile,
+  to show that fan-out is never blocked by writers
+*/
+class CountingSubscriber : public Subscriber {
+    alignas(64) atomic<uint64_t> received{0};
+
+public:
+    CountingSubscriber(string name) : Subscriber(name) {}
+
+    void notify(const string&, const Message&) override {
+        received.fetch_add(1, memory_order_relaxed);
+    }
+
+    void notifyBatch(const string&, const Message*, size_t count) override {
+        received.fetch_add(count, memory_order_relaxed);
+    }
+
+    uint64_t getReceived() const {
+        return received.load();
+    }
+};
+
+// Simulates a subscriber doing real work (DB write, HTTP call...)
+class SlowSubscriber : public Subscriber {
+    chrono::microseconds workTime;
+
+public:
+    SlowSubscriber(string name, chrono::microseconds workTime)
+        : Subscriber(name), workTime(workTime) {}
+
+    void notify(const string& topicName, const Message& msg) override {
+        this_thread::sleep_for(workTime);
+        Subscriber::notify(topicName, msg);
+    }
+};
+
+void runPublishBenchmark() {
+    const int TOPIC_COUNT = 64;
+    const int SUBSCRIBERS_PER_TOPIC = 8;
+    const int MESSAGES_PER_THREAD = 200000;
+
+    // Silence setup logging; only the table is interesting here
+    optional<AsyncLog::Redirect> quiet(in_place, nullptr);
+
+    Broker broker;
+    vector<string> topicNames;
+    vector<CountingSubscriber*> counters;
+
+    for (int t = 0; t < TOPIC_COUNT; t++) {
+        topicNames.push_back("bench.topic." + to_string(t));
+        Topic* topic = broker.createTopic(topicNames.back());
+        for (int s = 0; s < SUBSCRIBERS_PER_TOPIC; s++) {
+            counters.push_back(new CountingSubscriber("sub" + to_string(t) + "_" + to_string(s)));
+            topic->subscribe(counters.back());
         }
-        Topic* newTopic = new Topic(topicName);
-        topics[topicName] = newTopic;
-        cout << "[BROKER] Created topic: " << topicName << endl;
-        return newTopic;
     }
 
-    Topic* getTopic(const string& name) {
-        if (topics.find(name) == topics.end()) {
-            cout << "[ERROR] No topic named: " << name << endl;
-            return nullptr;
+    CountingSubscriber churner("churner");
+
+    int maxThreads = max(4u, thread::hardware_concurrency());
+    vector<int> threadCounts;
+    for (int n = 1; n <= maxThreads; n *= 2)
+        threadCounts.push_back(n);
+    if (threadCounts.back() != maxThreads)
+        threadCounts.push_back(maxThreads);
+
+    quiet.reset();
+    cout << "\n==== PUBLISH THROUGHPUT (" << TOPIC_COUNT << " topics x "
+         << SUBSCRIBERS_PER_TOPIC << " subscribers) ====\n";
+    cout << "threads\tmsgs/sec\tdeliveries/sec\tspeedup\tchurn ops\n";
+
+    double baseline = 0;
+    for (int threads : threadCounts) {
+        quiet.emplace(nullptr);
+
+        atomic<bool> running{true};
+        atomic<uint64_t> churnOps{0};
+        thread churn([&]() {
+            Topic* hot = broker.getTopic(topicNames[0]);
+            while (running.load(memory_order_relaxed)) {
+                hot->subscribe(&churner);
+                hot->unSubscribe(&churner);
+                churnOps.fetch_add(2, memory_order_relaxed);
+            }
+        });
+
+        const Message payload("score update");
+        auto start = chrono::steady_clock::now();
+
+        vector<thread> publishers;
+        for (int p = 0; p < threads; p++) {
+            publishers.emplace_back([&, p]() {
+                for (int i = 0; i < MESSAGES_PER_THREAD; i++) {
+                    const string& name = topicNames[(i + p * 7) % TOPIC_COUNT];
+                    broker.getTopic(name)->deliver(payload);
+                }
+            });
         }
-        return topics[name];
+        for (auto& t : publishers)
+            t.join();
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        running = false;
+        churn.join();
+        quiet.reset();
+
+        double msgsPerSec = threads * (double)MESSAGES_PER_THREAD / seconds;
+        if (baseline == 0)
+            baseline = msgsPerSec;
+
+        cout << threads << "\t"
+             << (uint64_t)msgsPerSec << "\t"
+             << (uint64_t)(msgsPerSec * SUBSCRIBERS_PER_TOPIC) << "\t"
+             << msgsPerSec / baseline << "x\t"
+             << churnOps.load() << "\n";
     }
-};
 
-class Publisher {
-    Broker* broker;
-    string publisherName;
+    uint64_t delivered = 0;
+    for (auto c : counters) {
+        delivered += c->getReceived();
+        delete c;
+    }
+    cout << "total deliveries: " << delivered
+         << " (hardware threads: " << thread::hardware_concurrency() << ")\n";
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: async delivery per backpressure policy
+--------------------------------------------------
+- Fast counting subscribers plus one slow subscriber on topic 0
+- Publishers should keep their rate for DROP_* policies and be
+  throttled only under BLOCK
+*/
+class SilentSlowSubscriber : public CountingSubscriber {
+    chrono::microseconds workTime;
 
 public:
-    Publisher(string name, Broker* broker)
-        : publisherName(name), broker(broker) {}
+    SilentSlowSubscriber(string name, chrono::microseconds workTime)
+        : CountingSubscriber(name), workTime(workTime) {}
 
-    void publishMessage(const string& topic, const string& msg) {
-        cout << "\n[PUBLISHER] " << publisherName
-             << " publishing to " << topic << endl;
+    void notify(const string& topicName, const Message& msg) override {
+        this_thread::sleep_for(workTime);
+        CountingSubscriber::notify(topicName, msg);
+    }
 
-        Topic* topicObj = broker->getTopic(topic);
-        if (!topicObj)
-            cout << "[FAILED] Topic does not exist: " << topic << endl;
-        else
-            topicObj->notify(msg);
+    void notifyBatch(const string& topicName, const Message* batch, size_t count) override {
+        Subscriber::notifyBatch(topicName, batch, count);   // pay the work per message
+    }
+};
+
+void runAsyncDeliveryBenchmark() {
+    const int TOPIC_COUNT = 16;
+    const int SUBSCRIBERS_PER_TOPIC = 4;
+    const int PUBLISHERS = 2;
+    const int MESSAGES_PER_PUBLISHER = 50000;
+    const int WORKERS = 2;
+    const size_t QUEUE_CAPACITY = 256;
+
+    const BackpressurePolicy policies[] = {BLOCK, DROP_OLDEST, DROP_NEWEST};
+    const char* policyNames[] = {"BLOCK", "DROP_OLDEST", "DROP_NEWEST"};
+
+    cout << "\n==== ASYNC DELIVERY (" << TOPIC_COUNT << " topics x "
+         << SUBSCRIBERS_PER_TOPIC << " async subscribers, 1 slow, "
+         << WORKERS << " workers, queue " << QUEUE_CAPACITY << ") ====\n";
+
+    for (int p = 0; p < 3; p++) {
+        optional<AsyncLog::Redirect> quiet(in_place, nullptr);
+
+        Broker broker;
+        vector<string> topicNames;
+        vector<CountingSubscriber*> targets;
+        {
+            DeliveryPool pool(WORKERS);
+
+            for (int t = 0; t < TOPIC_COUNT; t++) {
+                topicNames.push_back("async.topic." + to_string(t));
+                Topic* topic = broker.createTopic(topicNames.back());
+                for (int s = 0; s < SUBSCRIBERS_PER_TOPIC; s++) {
+                    targets.push_back(new CountingSubscriber("fast" + to_string(t) + "_" + to_string(s)));
+                    topic->subscribe(pool.async(targets.back(), policies[p], QUEUE_CAPACITY));
+                }
+            }
+            targets.push_back(new SilentSlowSubscriber("slow", chrono::microseconds(50)));
+            broker.getTopic(topicNames[0])->subscribe(
+                pool.async(targets.back(), policies[p], QUEUE_CAPACITY));
+
+            const Message payload("price tick");
+            auto start = chrono::steady_clock::now();
+
+            vector<thread> publishers;
+            for (int id = 0; id < PUBLISHERS; id++) {
+                publishers.emplace_back([&, id]() {
+                    for (int i = 0; i < MESSAGES_PER_PUBLISHER; i++)
+                        broker.getTopic(topicNames[(i + id) % TOPIC_COUNT])->deliver(payload);
+                });
+            }
+            for (auto& t : publishers)
+                t.join();
+            double publishSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            pool.shutdown();
+            double drainSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            quiet.reset();
+
+            uint64_t delivered = 0;
+            for (auto c : targets)
+                delivered += c->getReceived();
+
+            cout << policyNames[p] << ":\n"
+                 << "  publish rate   " << (uint64_t)(PUBLISHERS * MESSAGES_PER_PUBLISHER / publishSeconds) << " msgs/sec\n"
+                 << "  drained after  " << drainSeconds * 1000 << " ms\n"
+                 << "  delivered      " << delivered << ", dropped " << pool.dropped() << "\n";
+            pool.printLatency("  publish->deliver");
+        }
+        for (auto c : targets)
+            delete c;
+    }
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: name lookup vs cached handle vs batches
+--------------------------------------------------
+- by name  : getTopic(name) + a fresh payload per publish
+- by handle: resolved TopicHandle + shared Message
+- batch    : publishBatch(handle, BATCH_SIZE messages)
+*/
+void runBatchPublishBenchmark() {
+    const int TOPIC_COUNT = 64;
+    const int SUBSCRIBERS_PER_TOPIC = 8;
+    const int MESSAGES = 1 << 20;
+    const int BATCH_SIZE = 64;
+
+    optional<AsyncLog::Redirect> quiet(in_place, nullptr);
+
+    Broker broker;
+    Publisher publisher("bench", &broker);
+    vector<string> topicNames;
+    vector<TopicHandle> handles;
+    vector<CountingSubscriber*> counters;
+
+    for (int t = 0; t < TOPIC_COUNT; t++) {
+        topicNames.push_back("batch.topic." + to_string(t));
+        Topic* topic = broker.createTopic(topicNames.back());
+        for (int s = 0; s < SUBSCRIBERS_PER_TOPIC; s++) {
+            counters.push_back(new CountingSubscriber("sub"));
+            topic->subscribe(counters.back());
+        }
+        handles.push_back(publisher.resolve(topicNames.back()));
+    }
+    quiet.reset();
+
+    const string text = "order book delta";
+    vector<Message> batch(BATCH_SIZE, Message(text));
+
+    auto measure = [&](const char* label, auto body) {
+        auto start = chrono::steady_clock::now();
+        body();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << label << "\t" << (uint64_t)(MESSAGES / seconds) << " msgs/sec\t"
+             << seconds * 1e9 / MESSAGES << " ns/msg\n";
+    };
+
+    cout << "\n==== BATCHED PUBLISH (1 thread, " << TOPIC_COUNT << " topics x "
+         << SUBSCRIBERS_PER_TOPIC << " subscribers) ====\n";
+
+    measure("by name", [&]() {
+        for (int i = 0; i < MESSAGES; i++)
+            broker.getTopic(topicNames[i % TOPIC_COUNT])->deliver(Message(text));
+    });
+    measure("by handle", [&]() {
+        const Message& shared = batch[0];
+        for (int i = 0; i < MESSAGES; i++)
+            publisher.publish(handles[i % TOPIC_COUNT], shared);
+    });
+    measure("batch/64", [&]() {
+        for (int i = 0; i < MESSAGES / BATCH_SIZE; i++)
+            publisher.publishBatch(handles[i % TOPIC_COUNT], batch);
+    });
+
+    for (auto c : counters)
+        delete c;
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: trie matching vs scanning every pattern
+--------------------------------------------------
+- PATTERN_COUNT random patterns, one subscriber each
+- For every concrete topic: trie match vs linear scan
+  (the scan doubles as a correctness check)
+- Then publish with the per-topic cache warm
+*/
+static vector<string> splitLevels(const string& name) {
+    vector<string> levels;
+    size_t start = 0;
+    while (true) {
+        size_t dot = name.find('.', start);
+        levels.push_back(name.substr(start, dot - start));
+        if (dot == string::npos)
+            return levels;
+        start = dot + 1;
+    }
+}
+
+// Reference matcher: one pattern against one topic
+static bool patternMatches(const vector<string>& pattern, size_t p,
+                           const vector<string>& topic, size_t t) {
+    if (p == pattern.size())
+        return t == topic.size();
+    if (pattern[p] == "#") {
+        for (size_t skip = t; skip <= topic.size(); skip++)
+            if (patternMatches(pattern, p + 1, topic, skip))
+                return true;
+        return false;
+    }
+    if (t == topic.size())
+        return false;
+    if (pattern[p] == "*" || pattern[p] == topic[t])
+        return patternMatches(pattern, p + 1, topic, t + 1);
+    return false;
+}
+
+void runWildcardBenchmark() {
+    const int PATTERN_COUNT = 5000;
+    const int PUBLISHES = 1 << 16;
+    const char* regions[] = {"india", "australia", "england", "japan", "brazil",
+                             "kenya", "canada", "france", "chile", "nepal"};
+    const char* sports[] = {"cricket", "hockey", "football", "tennis", "chess"};
+    const char* kinds[] = {"score", "news", "video", "stats"};
+
+    mt19937 rng(42);
+    auto pick = [&](int n) { return (int)(rng() % n); };
+
+    optional<AsyncLog::Redirect> quiet(in_place, nullptr);
+
+    Broker broker;
+    vector<string> topicNames;
+    for (auto region : regions)
+        for (auto sport : sports)
+            for (auto kind : kinds) {
+                topicNames.push_back(string("sports.") + region + "." + sport + "." + kind);
+                broker.createTopic(topicNames.back());
+            }
+
+    vector<string> patternList;
+    vector<CountingSubscriber*> counters;
+    for (int i = 0; i < PATTERN_COUNT; i++) {
+        string levels[] = {"sports", regions[pick(10)], sports[pick(5)], kinds[pick(4)]};
+        string pattern;
+        int shape = pick(10);
+        if (shape == 0)
+            pattern = "sports." + levels[1] + ".#";
+        else if (shape == 1)
+            pattern = "#." + levels[3];
+        else {
+            for (int l = 0; l < 4; l++) {
+                if (l > 0)
+                    pattern += ".";
+                pattern += (l > 0 && pick(3) == 0) ? "*" : levels[l];
+            }
+        }
+        patternList.push_back(pattern);
+        counters.push_back(new CountingSubscriber("p" + to_string(i)));
+        broker.subscribePattern(pattern, counters.back());
+    }
+    quiet.reset();
+
+    TopicPatternIndex index;
+    for (int i = 0; i < PATTERN_COUNT; i++)
+        index.add(patternList[i], counters[i]);
+
+    vector<vector<string>> splitPatterns;
+    for (auto& pattern : patternList)
+        splitPatterns.push_back(splitLevels(pattern));
+
+    size_t trieMatches = 0, scanMatches = 0, mismatches = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (auto& name : topicNames)
+        trieMatches += index.match(name).size();
+    double trieSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (auto& name : topicNames) {
+        vector<string> levels = splitLevels(name);
+        size_t found = 0;
+        for (auto& pattern : splitPatterns)
+            found += patternMatches(pattern, 0, levels, 0);
+        scanMatches += found;
+    }
+    double scanSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (auto& name : topicNames) {
+        vector<string> levels = splitLevels(name);
+        vector<Subscriber*> expected;
+        for (int i = 0; i < PATTERN_COUNT; i++)
+            if (patternMatches(splitPatterns[i], 0, levels, 0))
+                expected.push_back(counters[i]);
+        sort(expected.begin(), expected.end());
+        if (expected != index.match(name))
+            mismatches++;
+    }
+
+    Publisher publisher("bench", &broker);
+    vector<TopicHandle> handles;
+    for (auto& name : topicNames)
+        handles.push_back(publisher.resolve(name));
+    const Message payload("goal!");
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < PUBLISHES; i++)
+        publisher.publish(handles[i % handles.size()], payload);
+    double publishSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t delivered = 0;
+    for (auto c : counters)
+        delivered += c->getReceived();
+
+    cout << "\n==== WILDCARD MATCHING (" << PATTERN_COUNT << " patterns, "
+         << topicNames.size() << " topics) ====\n"
+         << "trie match\t" << trieSeconds * 1e9 / topicNames.size() << " ns/topic\n"
+         << "linear scan\t" << scanSeconds * 1e9 / topicNames.size() << " ns/topic\n"
+         << "matches\t\t" << trieMatches << " (scan " << scanMatches
+         << ", mismatching topics " << mismatches << ")\n"
+         << "cached publish\t" << (uint64_t)(PUBLISHES / publishSeconds) << " msgs/sec, "
+         << delivered / (double)PUBLISHES << " deliveries/msg\n";
+
+    for (auto c : counters)
+        delete c;
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: in-memory vs durable publish, replay
+--------------------------------------------------
+- Same topic shape with and without a log
+- Durable numbers include waiting for the final sync
+- Replay = one sequential pass over every segment
+- Recovery = reopening the log (checksum scan)
+*/
+void runDurableLogBenchmark() {
+    const int SUBSCRIBERS = 8;
+    const int MESSAGES = 1 << 20;
+    const int BATCH_SIZE = 64;
+    const string dir = (filesystem::temp_directory_path() / "lld-pubsub-bench").string();
+
+    filesystem::remove_all(dir);
+    optional<AsyncLog::Redirect> quiet(in_place, nullptr);
+
+    Broker broker;
+    Topic* memoryTopic = broker.createTopic("bench.memory");
+    Topic* durableTopic = broker.createTopic("bench.durable");
+    Topic* batchTopic = broker.createTopic("bench.durable.batch");
+    durableTopic->enableLog(dir + "/single");
+    batchTopic->enableLog(dir + "/batch");
+
+    vector<CountingSubscriber*> counters;
+    for (Topic* topic : {memoryTopic, durableTopic, batchTopic})
+        for (int s = 0; s < SUBSCRIBERS; s++) {
+            counters.push_back(new CountingSubscriber("sub"));
+            topic->subscribe(counters.back());
+        }
+    quiet.reset();
+
+    const Message payload(string(64, 'x'));
+    vector<Message> batch(BATCH_SIZE, payload);
+
+    auto timed = [](auto body) {
+        auto start = chrono::steady_clock::now();
+        body();
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+
+    double memorySeconds = timed([&]() {
+        for (int i = 0; i < MESSAGES; i++)
+            memoryTopic->deliver(payload);
+    });
+    double durableSeconds = timed([&]() {
+        for (int i = 0; i < MESSAGES; i++)
+            durableTopic->deliver(payload);
+        durableTopic->getLog()->awaitDurable(MESSAGES - 1);
+    });
+    double batchSeconds = timed([&]() {
+        for (int i = 0; i < MESSAGES / BATCH_SIZE; i++)
+            batchTopic->deliverBatch(batch.data(), batch.size());
+        batchTopic->getLog()->awaitDurable(MESSAGES - 1);
+    });
+
+    uint64_t replayed = 0;
+    double replaySeconds = timed([&]() {
+        durableTopic->getLog()->replay(0, [&](uint64_t, string_view) { replayed++; });
+    });
+
+    uint64_t recovered = 0;
+    double recoverySeconds = timed([&]() {
+        TopicLog reopened(dir + "/batch");
+        recovered = reopened.endOffset();
+    });
+
+    auto rate = [&](double seconds) { return (uint64_t)(MESSAGES / seconds); };
+
+    cout << "\n==== DURABLE LOG (" << MESSAGES << " x " << payload.size()
+         << " B, " << SUBSCRIBERS << " subscribers) ====\n"
+         << "in-memory\t" << rate(memorySeconds) << " msgs/sec\n"
+         << "durable\t\t" << rate(durableSeconds) << " msgs/sec ("
+         << durableSeconds / memorySeconds << "x slower, "
+         << durableTopic->getLog()->getSyncCount() << " group syncs)\n"
+         << "durable/batch\t" << rate(batchSeconds) << " msgs/sec ("
+         << batchSeconds / memorySeconds << "x slower, "
+         << batchTopic->getLog()->getSyncCount() << " group syncs)\n"
+         << "replay\t\t" << (uint64_t)(replayed / replaySeconds) << " msgs/sec ("
+         << replayed << " records)\n"
+         << "recovery\t" << recoverySeconds * 1000 << " ms for "
+         << recovered << " records\n";
+
+    for (auto c : counters)
+        delete c;
+    filesystem::remove_all(dir);
+}
+
+/*
+--------------------------------------------------
+BENCHMARK: liveness check per notification
+--------------------------------------------------
+The same fan-out list held three ways, notified from N threads:
+- raw      : Subscriber* (no protection, the floor)
+- handle   : SubscriberHandle, one generation compare
+- weak_ptr : weak_ptr::lock() per notify (atomic inc + dec on
+             a refcount line every publisher thread writes)
+Then subscription churn: pool + token vs make_shared, and a
+check that destroyed subscribers are skipped and pruned.
+*/
+class SinkSubscriber : public Subscriber {
+public:
+    SinkSubscriber(string name) : Subscriber(name) {}
+
+    void notify(const string&, const Message& msg) override {
+        thread_local uint64_t bytes = 0;
+        bytes += msg.view().size();
     }
 };
 
-int main() {
+void runHandleBenchmark() {
+    const int SUBSCRIBERS = 64;
+    const int ROUNDS_PER_THREAD = 50000;
+    const int CHURN_OPS = 100000;
+    const string topicName = "bench.handles";
+    const Message payload("tick");
+
+    vector<shared_ptr<Subscriber>> owners;
+    vector<Subscriber*> raw;
+    vector<weak_ptr<Subscriber>> weak;
+    vector<SubscriberHandle> handles;
+    SubscriberPool<SinkSubscriber, Epoch> pool;
+
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        handles.push_back(pool.create("pooled" + to_string(i)));
+        owners.push_back(make_shared<SinkSubscriber>("shared" + to_string(i)));
+        weak.push_back(owners.back());
+        raw.push_back(owners.back().get());
+    }
+
+    int maxThreads = max(4u, thread::hardware_concurrency());
+    vector<int> threadCounts;
+    for (int n = 1; n <= maxThreads; n *= 2)
+        threadCounts.push_back(n);
+    if (threadCounts.back() != maxThreads)
+        threadCounts.push_back(maxThreads);
+
+    auto measure = [&](int threads, auto fanOut) {
+        auto start = chrono::steady_clock::now();
+        vector<thread> publishers;
+        for (int p = 0; p < threads; p++) {
+            publishers.emplace_back([&]() {
+                for (int r = 0; r < ROUNDS_PER_THREAD; r++)
+                    fanOut();
+            });
+        }
+        for (auto& t : publishers)
+            t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return seconds * 1e9 / ((double)threads * ROUNDS_PER_THREAD * SUBSCRIBERS);
+    };
+
+    cout << "\n==== SUBSCRIBER LIVENESS CHECK (" << SUBSCRIBERS << " subscribers, ns/notify) ====\n";
+    cout << "sizeof: Subscriber* " << sizeof(Subscriber*) << "B, SubscriberHandle "
+         << sizeof(SubscriberHandle) << "B, weak_ptr " << sizeof(weak_ptr<Subscriber>) << "B\n";
+    cout << "threads\traw\thandle\tweak_ptr\n";
+
+    for (int threads : threadCounts) {
+        double rawNs = measure(threads, [&]() {
+            for (Subscriber* subscriber : raw)
+                subscriber->notify(topicName, payload);
+        });
+        double handleNs = measure(threads, [&]() {
+            for (const SubscriberHandle& handle : handles)
+                if (handle.alive())
+                    handle.target->notify(topicName, payload);
+        });
+        double weakNs = measure(threads, [&]() {
+            for (const weak_ptr<Subscriber>& entry : weak)
+                if (shared_ptr<Subscriber> subscriber = entry.lock())
+                    subscriber->notify(topicName, payload);
+        });
+        cout << threads << "\t" << rawNs << "\t" << handleNs << "\t" << weakNs << "\n";
+    }
+
+    // Subscribe/unsubscribe churn through a real topic
+    optional<AsyncLog::Redirect> quiet(in_place, nullptr);
+    Broker broker;
+    Topic* topic = broker.createTopic(topicName);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < CHURN_OPS; i++) {
+        SubscriberHandle handle = pool.create("churn");
+        Subscription token = topic->subscribe(handle);
+        token.reset();
+        pool.destroy(handle);
+    }
+    double pooledNs = chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e9 / CHURN_OPS;
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < CHURN_OPS; i++) {
+        shared_ptr<Subscriber> subscriber = make_shared<SinkSubscriber>("churn");
+        topic->subscribe(subscriber.get());
+        topic->unSubscribe(subscriber.get());
+    }
+    double sharedNs = chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e9 / CHURN_OPS;
+
+    // Destroy half the pooled subscribers while still subscribed
+    vector<Subscription> tokens;
+    for (const SubscriberHandle& handle : handles)
+        tokens.push_back(topic->subscribe(handle));
+    for (int i = 0; i < SUBSCRIBERS; i += 2)
+        pool.destroy(handles[i]);
+    size_t before = topic->subscriberCount();
+    topic->deliver(payload);
+    size_t after = topic->subscriberCount();
+    tokens.clear();
+    quiet.reset();
+
+    cout << "churn (create+subscribe+unsubscribe+destroy): pool+token " << pooledNs
+         << " ns/op, make_shared+raw " << sharedNs << " ns/op\n";
+    cout << "destroyed while subscribed: " << before << " entries -> " << after
+         << " after one publish (" << pool.size() << " live in pool, "
+         << topic->subscriberCount() << " left after tokens)\n";
+}
+
+/*
+=================================================================
+=                 LOAD SUITE: --load                             =
+=================================================================
+Machine-readable: one JSON line per case and publisher count
+(see bench/LoadHarness.h for flags and fields). 64 topics x 8
+counting subscribers; one op = one message fanned out to 8.
+- publish_by_name: broker lookup by string, then deliver
+- publish_by_handle: cached TopicHandle, shared Message
+- async_publish: every subscriber wrapped by a 2-worker
+  DeliveryPool (DROP_OLDEST); the op is the publisher's side
+  only, i.e. the cost of enqueueing into 8 rings
+Synchronous cases time 16 messages per sample (see batch).
+*/
+void runLoadSuite(const LoadHarness::Options& options) {
+    const int TOPIC_COUNT = 64;
+    const int SUBSCRIBERS_PER_TOPIC = 8;
+    const int SAMPLE_BATCH = 16;
+
+    LoadHarness::Reporter report("pubsub", options);
+    AsyncLog::Redirect quiet(nullptr);
+
+    Broker broker;
+    Publisher publisher("load", &broker);
+    vector<string> topicNames;
+    vector<TopicHandle> handles;
+    vector<CountingSubscriber*> counters;
+
+    for (int t = 0; t < TOPIC_COUNT; t++) {
+        topicNames.push_back("load.topic." + to_string(t));
+        Topic* topic = broker.createTopic(topicNames.back());
+        for (int s = 0; s < SUBSCRIBERS_PER_TOPIC; s++) {
+            counters.push_back(new CountingSubscriber("sub"));
+            topic->subscribe(counters.back());
+        }
+        handles.push_back(publisher.resolve(topicNames.back()));
+    }
+
+    const Message payload("score update");
+
+    if (options.wants("publish_by_name")) {
+        for (int publishers : options.threads) {
+            report.emit(LoadHarness::runLoad("publish_by_name", publishers, options.seconds,
+                [&](int p, uint64_t i) {
+                    broker.getTopic(topicNames[(i + p * 7) % TOPIC_COUNT])->deliver(payload);
+                }, SAMPLE_BATCH));
+        }
+    }
+
+    if (options.wants("publish_by_handle")) {
+        for (int publishers : options.threads) {
+            report.emit(LoadHarness::runLoad("publish_by_handle", publishers, options.seconds,
+                [&](int p, uint64_t i) {
+                    publisher.publish(handles[(i + p * 7) % TOPIC_COUNT], payload);
+                }, SAMPLE_BATCH));
+        }
+    }
+
+    if (options.wants("async_publish")) {
+        Topic* topic = broker.createTopic("load.async");
+        for (int publishers : options.threads) {
+            DeliveryPool pool(2);
+            vector<Subscriber*> mailboxes;
+            for (int s = 0; s < SUBSCRIBERS_PER_TOPIC; s++) {
+                mailboxes.push_back(pool.async(counters[s], DROP_OLDEST));
+                topic->subscribe(mailboxes.back());
+            }
+
+            report.emit(LoadHarness::runLoad("async_publish", publishers, options.seconds,
+                [&](int, uint64_t) {
+                    publisher.publish(topic, payload);
+                }));
+
+            // Detach the wrappers before the pool deletes them
+            pool.shutdown();
+            for (Subscriber* mailbox : mailboxes)
+                topic->unSubscribe(mailbox);
+        }
+    }
+
+    for (auto c : counters)
+        delete c;
+}
+
+int main(int argc, char* argv[]) {
+    AsyncLog::captureCout();
+
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runPublishBenchmark();
+        runBatchPublishBenchmark();
+        runWildcardBenchmark();
+        runDurableLogBenchmark();
+        runAsyncDeliveryBenchmark();
+        runHandleBenchmark();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--load") {
+        runLoadSuite(LoadHarness::Options::parse(argc, argv));
+        return 0;
+    }
+
     cout << "==== PUB-SUB SYSTEM DEMO ====\n\n";
 
     Broker* broker = new Broker();
@@ -194,6 +2614,112 @@ int main() {
     cout << "\n==== INVALID TOPIC TEST ====\n";
     sportsPublisher->publishMessage("Politics", "New bill passed.");
 
+    cout << "\n==== WILDCARD SUBSCRIPTIONS ====\n";
+    broker->createTopic("sports.india.cricket");
+    broker->createTopic("sports.australia.cricket");
+    broker->createTopic("sports.india.hockey");
+    broker->createTopic("news.india.politics");
+
+    broker->subscribePattern("sports.*.cricket", aditya);
+    broker->subscribePattern("news.#", rohan);
+    broker->subscribePattern("#.india.#", yash);
+
+    sportsPublisher->publishMessage("sports.india.cricket", "Kohli scores a century!");
+    sportsPublisher->publishMessage("sports.australia.cricket", "Ashes squad announced.");
+    sportsPublisher->publishMessage("sports.india.hockey", "India wins bronze.");
+    newsPublisher->publishMessage("news.india.politics", "Budget session begins.");
+
+    LOG_INFO("\n[ACTION] Yash drops #.india.#");
+    broker->unSubscribePattern("#.india.#", yash);
+    broker->unSubscribePattern("#.india.#", yash); // double unsubscribe
+    sportsPublisher->publishMessage("sports.india.cricket", "Series levelled 1-1.");
+
+    cout << "\n==== DURABLE LOG & REPLAY ====\n";
+    {
+        string logDir = (filesystem::temp_directory_path() / "lld-pubsub-demo").string();
+        filesystem::remove_all(logDir);
+
+        Topic* ordersTopic = broker->createTopic("orders");
+        ordersTopic->enableLog(logDir + "/orders");
+        ordersTopic->subscribe(aditya);
+
+        Publisher* ordersPublisher = new Publisher("OrdersPublisher", broker);
+        ordersPublisher->publishMessage("orders", "Order #1 placed");
+        ordersPublisher->publishMessage("orders", "Order #2 placed");
+        ordersPublisher->publishMessage("orders", "Order #1 shipped");
+
+        LOG_INFO("\n[ACTION] Rohan was offline, reconnects from offset 1");
+        ordersTopic->resume(rohan, 1);
+        ordersPublisher->publishMessage("orders", "Order #2 shipped");
+        ordersPublisher->publishMessage("orders", "");   // empty keep-alive, still a record
+        ordersPublisher->publishMessage("orders", "Order #3 placed");
+
+        if (ordersTopic->getLog()->awaitDurable(5))
+            LOG_INFO("[LOG] Offsets 0..5 are on disk");
+        if (!ordersTopic->getLog()->awaitDurable(99))
+            LOG_INFO("[LOG] Offset 99 was never appended, nothing to wait for");
+
+        LOG_INFO("\n[ACTION] Restart: reopening the orders log");
+        TopicLog reopened(logDir + "/orders");
+        reopened.replay(0, [](uint64_t offset, string_view payload) {
+            LOG_INFO("[REPLAY] offset {}: {}", offset, payload.empty() ? "(empty)" : payload);
+        });
+        if (reopened.endOffset() == 6)
+            LOG_INFO("[LOG] All 6 records recovered, the empty one included");
+        else
+            LOG_ERROR("[FAILED] Recovered {} of 6 records", reopened.endOffset());
+        filesystem::remove_all(logDir);
+    }
+
+    cout << "\n==== ASYNC DELIVERY TEST ====\n";
+    {
+        DeliveryPool pool(2);
+        Topic* alertsTopic = broker->createTopic("Alerts");
+        Subscriber* slowReader = new SlowSubscriber("SlowReader", chrono::milliseconds(20));
+
+        Subscriber* rohanMailbox = pool.async(rohan, BLOCK);
+        Subscriber* slowMailbox = pool.async(slowReader, DROP_NEWEST, 2);
+        alertsTopic->subscribe(rohanMailbox);
+        alertsTopic->subscribe(slowMailbox);
+
+        LOG_INFO("[ASYNC] Publishing 5 alerts without waiting for SlowReader");
+        auto start = chrono::steady_clock::now();
+        for (int i = 1; i <= 5; i++)
+            alertsTopic->deliver(Message("Alert #" + to_string(i)));
+        auto publishTime = chrono::steady_clock::now() - start;
+
+        pool.shutdown();
+        LOG_INFO("[ASYNC] Publisher spent {} us, dropped for full queues: {}", chrono::duration_cast<chrono::microseconds>(publishTime).count(), pool.dropped());
+        pool.printLatency("[ASYNC] publish->deliver");
+
+        // The pool deletes its mailboxes: detach them from the topic first
+        alertsTopic->unSubscribe(rohanMailbox);
+        alertsTopic->unSubscribe(slowMailbox);
+    }
+
+    cout << "\n==== POOLED SUBSCRIBERS (generational handles) ====\n";
+    {
+        SubscriberPool<Subscriber, Epoch> members;
+        Topic* weatherTopic = broker->createTopic("Weather");
+        SubscriberHandle priya = members.create("Priya");
+        SubscriberHandle kabir = members.create("Kabir");
+
+        Subscription priyaSubscription = weatherTopic->subscribe(priya);
+        {
+            Subscription kabirSubscription = weatherTopic->subscribe(kabir);
+            weatherTopic->notify(Message("Monsoon reaches Kerala"));
+        }   // token dies -> Kabir unsubscribed
+        weatherTopic->notify(Message("Heatwave alert for Delhi"));
+
+        LOG_INFO("\n[ACTION] Priya's account is deleted while still subscribed");
+        members.destroy(priya);
+        weatherTopic->notify(Message("Cyclone warning for Odisha"));
+        LOG_INFO("[POOL] {} live, Weather entries: {}, stale handle -> {}", members.size(), weatherTopic->subscriberCount(), members.get(priya) ? "alive" : "expired");
+    }
+
+    cout << "\n==== METRICS (Prometheus text) ====\n";
+    cout << Metrics::prometheusText();
+
     cout << "\n==== END OF DEMO ====\n";
     return 0;
-}
\ No newline at end of file
+}
@@ -52,6 +52,28 @@ SOLUTION:
 
 This removes complex conditionals and keeps behavior
 clean, extensible, and state-driven.
+
+MultiVM::Static::VendingMachine is the same machine with the
+state dispatch generated at compile time (std::variant).
+
+Fleet::FleetManager holds the stock of many machines in one
+flat array indexed by interned item ids; purchases decrement
+atomically and telemetry rolls the fleet up without locks.
+
+-----------------------------------------------------------
+RUN:
+- ./vending          -> demo
+- ./vending --bench  -> state dispatch: virtual states vs variant,
+                       fleet: oversell check, string map vs item ids,
+                       lock-free rollup
+- ./vending --load   -> JSON lines (throughput, p50/p99/p999) for
+                       N concurrent purchases on a shared fleet
+                       (flags: bench/LoadHarness.h)
+- machine messages are plain cout, captured by AsyncLog; only
+  diagnostics use LOG_* (stderr), so -DLOG_LEVEL=... never hides them
+- the demo ends with a Metrics.h scrape of the MultiVM machines
+  (sales, sold-out events, rejected selections);
+  -DMETRICS_ENABLED=0 compiles the metrics out
 ===========================================================
 */
 
@@ -59,6 +81,20 @@ clean, extensible, and state-driven.
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <variant>
+#include <sstream>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <random>
+#include <cstdint>
+#include <optional>
+
+#include "AsyncLog.h"
+#include "Metrics.h"
+#include "../bench/LoadHarness.h"
 using namespace std;
 
 /*
@@ -241,6 +277,25 @@ struct Item {
     int quantity;
 };
 
+// Shared by every MultiVM machine, virtual and Static alike
+struct VendingMetrics {
+    Metrics::Counter& sales = Metrics::counter(
+        "vending_sales_total", "Items dispensed");
+    Metrics::Counter& soldOut = Metrics::counter(
+        "vending_sold_out_total", "Dispenses that left a machine with nothing to sell");
+    Metrics::Counter& itemEmpty = Metrics::counter(
+        "vending_rejected_selections_total", "Selections refused", "reason=\"sold_out\"");
+    Metrics::Counter& shortCoins = Metrics::counter(
+        "vending_rejected_selections_total", "Selections refused", "reason=\"insufficient_coins\"");
+    Metrics::Counter& unknownItem = Metrics::counter(
+        "vending_rejected_selections_total", "Selections refused", "reason=\"unknown_item\"");
+};
+
+inline VendingMetrics& metrics() {
+    static VendingMetrics instance;
+    return instance;
+}
+
 class VendingMachine;
 class VendingState;
 
@@ -289,6 +344,12 @@ public:
     VendingState* getDispenseState() { return dispenseState; }
     VendingState* getSoldOutState() { return soldOutState; }
 
+    // 0 NO_COIN, 1 HAS_COIN, 2 DISPENSING, 3 SOLD_OUT (as in Static)
+    int getStateIndex() {
+        return currentState == noCoinState ? 0 : currentState == hasCoinState ? 1
+             : currentState == dispenseState ? 2 : 3;
+    }
+
     void insertCoin(int c) { currentState = currentState->insertCoin(this, c); }
     void selectItem(const string& n) { currentState = currentState->selectItem(this, n); }
     void dispense() { currentState = currentState->dispense(this); }
@@ -323,9 +384,11 @@ public:
     }
     VendingState* selectItem(VendingMachine* m, const string& n) override {
         auto& inv = m->getInventory();
-        if (!inv.count(n)) return this;
-        Item& i = inv[n];
-        if (i.quantity == 0 || m->getCoins() < i.price) return this;
+        auto it = inv.find(n);
+        if (it == inv.end()) { metrics().unknownItem.inc(); return this; }
+        Item& i = it->second;
+        if (i.quantity == 0) { metrics().itemEmpty.inc(); return this; }
+        if (m->getCoins() < i.price) { metrics().shortCoins.inc(); return this; }
         m->setSelectedItem(&i);
         return m->getDispenseState();
     }
@@ -347,11 +410,13 @@ public:
         i->quantity--;
         m->setCoins(0);
         m->setSelectedItem(nullptr);
+        metrics().sales.inc();
 
         for (auto& it : m->getInventory())
             if (it.second.quantity > 0)
                 return m->getNoCoinState();
 
+        metrics().soldOut.inc();
         return m->getSoldOutState();
     }
     VendingState* returnCoin(VendingMachine*) override { return this; }
@@ -389,14 +454,747 @@ void VendingMachine::printStatus() {
         cout << "  " << i.first << " Qty: " << i.second.quantity << endl;
 }
 
+/*
+-----------------------------------------------------------------
+ COMPILE-TIME STATE MACHINE
+-----------------------------------------------------------------
+MultiVM::Static::VendingMachine has the same behavior and API as
+MultiVM::VendingMachine, but the transitions are fixed at
+compile time:
+- states are empty tags in a std::variant, not heap objects
+- every event is an overload set with one overload per state;
+  the generic template is the "stay put" default
+- std::visit jumps on the variant index, no virtual call
+*/
+namespace Static {
+
+struct NoCoin {};
+struct HasCoin {};
+struct Dispensing {};
+struct SoldOut {};
+
+using State = variant<NoCoin, HasCoin, Dispensing, SoldOut>;
+
+class VendingMachine {
+private:
+    State state = SoldOut{};
+    unordered_map<string, Item> inventory;
+    Item* selectedItem = nullptr;
+    int coins = 0;
+
+    // ---- insertCoin ----
+    State onInsertCoin(NoCoin, int c) { coins = c; return HasCoin{}; }
+    State onInsertCoin(HasCoin s, int c) { coins += c; return s; }
+    template <class S> State onInsertCoin(S s, int) { return s; }
+
+    // ---- selectItem ----
+    State onSelectItem(NoCoin s, const string&) {
+        cout << "Insert coin first\n"; return s;
+    }
+    State onSelectItem(HasCoin s, const string& n) {
+        auto it = inventory.find(n);
+        if (it == inventory.end()) { metrics().unknownItem.inc(); return s; }
+        Item& i = it->second;
+        if (i.quantity == 0) { metrics().itemEmpty.inc(); return s; }
+        if (coins < i.price) { metrics().shortCoins.inc(); return s; }
+        selectedItem = &i;
+        return Dispensing{};
+    }
+    template <class S> State onSelectItem(S s, const string&) { return s; }
+
+    // ---- dispense ----
+    State onDispense(Dispensing) {
+        selectedItem->quantity--;
+        coins = 0;
+        selectedItem = nullptr;
+        metrics().sales.inc();
+
+        for (auto& it : inventory)
+            if (it.second.quantity > 0)
+                return NoCoin{};
+
+        metrics().soldOut.inc();
+        return SoldOut{};
+    }
+    template <class S> State onDispense(S s) { return s; }
+
+    // ---- returnCoin ----
+    State onReturnCoin(HasCoin) { coins = 0; return NoCoin{}; }
+    template <class S> State onReturnCoin(S s) { return s; }
+
+    // ---- refill ----
+    State onRefill(NoCoin s, const string& n, int q) {
+        inventory[n].quantity += q; return s;
+    }
+    State onRefill(SoldOut, const string& n, int q) {
+        inventory[n].quantity += q; return NoCoin{};
+    }
+    template <class S> State onRefill(S s, const string&, int) { return s; }
+
+public:
+    void addItem(string name, int price, int quantity) {
+        inventory[name] = {name, price, quantity};
+        if (holds_alternative<SoldOut>(state) && quantity > 0)
+            state = NoCoin{};
+    }
+
+    unordered_map<string, Item>& getInventory() { return inventory; }
+    int getCoins() { return coins; }
+
+    void insertCoin(int c) {
+        state = visit([&](auto s) { return onInsertCoin(s, c); }, state);
+    }
+    void selectItem(const string& n) {
+        state = visit([&](auto s) { return onSelectItem(s, n); }, state);
+    }
+    void dispense() {
+        state = visit([&](auto s) { return onDispense(s); }, state);
+    }
+    void returnCoin() {
+        state = visit([&](auto s) { return onReturnCoin(s); }, state);
+    }
+    void refill(const string& n, int q) {
+        state = visit([&](auto s) { return onRefill(s, n, q); }, state);
+    }
+
+    int getStateIndex() { return (int)state.index(); }
+
+    string getStateName() {
+        static const char* names[] = {"NO_COIN", "HAS_COIN", "DISPENSING", "SOLD_OUT"};
+        return names[state.index()];
+    }
+
+    void printStatus() {
+        cout << "State: " << getStateName()
+             << " | Balance: Rs " << coins << endl;
+        for (auto& i : inventory)
+            cout << "  " << i.first << " Qty: " << i.second.quantity << endl;
+    }
+};
+
+} // namespace Static
+
 } // namespace MultiVM
 
+/*
+=================================================================
+=                 FLEET-WIDE VENDING INVENTORY                  =
+=================================================================
+One FleetManager owns the stock of every machine in the fleet:
+- item names are interned once into small dense ItemIds; the
+  purchase path never hashes a string
+- quantities live in one flat array, row per machine, column
+  per ItemId: quantity[machine * stride + item]
+- a dispense is a CAS decrement that refuses to go below zero,
+  so concurrent purchases of the last unit never oversell
+- rollup() walks the array with relaxed loads: telemetry never
+  locks or pauses a machine (each counter is exact, the totals
+  are a moment-by-moment view while sales continue)
+
+Fleet::VendingMachine is the per-machine front end (same
+events as MultiVM::VendingMachine) whose inventory is its row.
+*/
+namespace Fleet {
+
+typedef uint32_t ItemId;
+const ItemId NO_ITEM = UINT32_MAX;
+
+// Name <-> dense id; filled at setup, read-only afterwards
+class ItemCatalog {
+private:
+    unordered_map<string, ItemId> ids;
+    vector<string> names;
+
+public:
+    ItemId intern(const string& name) {
+        auto it = ids.find(name);
+        if (it != ids.end())
+            return it->second;
+        ItemId id = (ItemId)names.size();
+        ids[name] = id;
+        names.push_back(name);
+        return id;
+    }
+
+    ItemId find(const string& name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? NO_ITEM : it->second;
+    }
+
+    const string& getName(ItemId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+};
+
+struct ItemRollup {
+    string name;
+    long long quantity = 0;
+    int machinesStocking = 0;     // machines that carry the item
+    int machinesEmpty = 0;        // ...and have run out of it
+};
+
+struct FleetTelemetry {
+    vector<ItemRollup> items;
+    unsigned long long sales = 0;
+    long long revenue = 0;
+    int soldOutMachines = 0;
+};
+
+/*
+Dispensing is one CAS on the slot. Sales are not counted on that
+path: a slot's sales are the units it received (stock + refills)
+minus what is left, and rollup() adds them up. The sold-out check
+reads a per-machine count of stocked slots, which only changes
+when a slot empties or is refilled from empty.
+*/
+class FleetManager {
+private:
+    // Per machine, own cache line each; off the dispense path
+    struct alignas(64) MachineCounters {
+        atomic<int32_t> stockedSlots{0};     // slots with quantity > 0
+        atomic<uint64_t> settledSales{0};    // sales before a re-stock()
+        atomic<int64_t> settledRevenue{0};
+    };
+
+    ItemCatalog catalog;
+    size_t machineCount;
+    size_t stride;                           // item columns per machine
+    unique_ptr<atomic<int32_t>[]> quantity;  // [machine * stride + item]
+    unique_ptr<atomic<int64_t>[]> received;  // units ever put in the slot
+    unique_ptr<int32_t[]> price;             // 0 = machine doesn't carry it
+    unique_ptr<MachineCounters[]> counters;
+
+    size_t slot(size_t machine, ItemId item) const {
+        return machine * stride + item;
+    }
+
+public:
+    FleetManager(size_t machines, size_t maxItems)
+        : machineCount(machines), stride(maxItems),
+          quantity(new atomic<int32_t>[machines * maxItems]),
+          received(new atomic<int64_t>[machines * maxItems]),
+          price(new int32_t[machines * maxItems]()),
+          counters(new MachineCounters[machines]) {
+        for (size_t i = 0; i < machines * maxItems; i++) {
+            quantity[i].store(0, memory_order_relaxed);
+            received[i].store(0, memory_order_relaxed);
+        }
+    }
+
+    // Setup: names beyond maxItems are refused (NO_ITEM)
+    ItemId addItem(const string& name) {
+        if (catalog.find(name) == NO_ITEM && catalog.size() == stride)
+            return NO_ITEM;
+        return catalog.intern(name);
+    }
+
+    // Setup: what a machine sells and at what price (sales so far
+    // are settled at the old price first)
+    void stock(size_t machine, ItemId item, int itemPrice, int count) {
+        size_t at = slot(machine, item);
+        int32_t left = quantity[at].exchange(count, memory_order_acq_rel);
+        int64_t sold = received[at].exchange(count, memory_order_acq_rel) - left;
+        counters[machine].settledSales.fetch_add(sold, memory_order_relaxed);
+        counters[machine].settledRevenue.fetch_add(sold * price[at], memory_order_relaxed);
+        counters[machine].stockedSlots.fetch_add((count > 0) - (left > 0), memory_order_relaxed);
+        price[at] = itemPrice;
+    }
+
+    void refill(size_t machine, ItemId item, int count) {
+        size_t at = slot(machine, item);
+        if (count <= 0 || price[at] == 0)
+            return;
+        received[at].fetch_add(count, memory_order_relaxed);
+        if (quantity[at].fetch_add(count, memory_order_acq_rel) <= 0)
+            counters[machine].stockedSlots.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Takes one unit; false when another purchase got the last one
+    bool tryDispense(size_t machine, ItemId item) {
+        atomic<int32_t>& units = quantity[slot(machine, item)];
+        int32_t current = units.load(memory_order_relaxed);
+        while (current > 0) {
+            if (units.compare_exchange_weak(current, current - 1,
+                                            memory_order_acq_rel, memory_order_relaxed)) {
+                if (current == 1)
+                    counters[machine].stockedSlots.fetch_sub(1, memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int getQuantity(size_t machine, ItemId item) const {
+        return quantity[slot(machine, item)].load(memory_order_acquire);
+    }
+
+    int getPrice(size_t machine, ItemId item) const {
+        return price[slot(machine, item)];
+    }
+
+    bool carries(size_t machine, ItemId item) const {
+        return item < catalog.size() && price[slot(machine, item)] > 0;
+    }
+
+    bool isSoldOut(size_t machine) const {
+        return counters[machine].stockedSlots.load(memory_order_relaxed) <= 0;
+    }
+
+    // Lock-free pass over the whole fleet, one row at a time
+    FleetTelemetry rollup() const {
+        size_t items = catalog.size();
+        FleetTelemetry telemetry;
+        telemetry.items.resize(items);
+        for (ItemId item = 0; item < items; item++)
+            telemetry.items[item].name = catalog.getName(item);
+
+        for (size_t machine = 0; machine < machineCount; machine++) {
+            const atomic<int32_t>* row = &quantity[machine * stride];
+            const atomic<int64_t>* in = &received[machine * stride];
+            const int32_t* prices = &price[machine * stride];
+            long long machineStock = 0;
+            for (ItemId item = 0; item < items; item++) {
+                if (prices[item] == 0)
+                    continue;
+                int32_t units = row[item].load(memory_order_relaxed);
+                int64_t sold = in[item].load(memory_order_relaxed) - units;
+                ItemRollup& total = telemetry.items[item];
+                total.quantity += units;
+                total.machinesStocking++;
+                total.machinesEmpty += units == 0;
+                machineStock += units;
+                telemetry.sales += sold;
+                telemetry.revenue += sold * prices[item];
+            }
+            telemetry.soldOutMachines += machineStock == 0;
+            telemetry.sales += counters[machine].settledSales.load(memory_order_relaxed);
+            telemetry.revenue += counters[machine].settledRevenue.load(memory_order_relaxed);
+        }
+        return telemetry;
+    }
+
+    const ItemCatalog& getCatalog() const { return catalog; }
+    size_t getMachineCount() const { return machineCount; }
+};
+
+/*
+One machine of the fleet. Same states and events as
+MultiVM::VendingMachine (compile-time dispatch as in
+MultiVM::Static); the selection is an ItemId instead of a
+pointer into a map, and the unit is only taken at dispense
+time, so a purchase that loses the race keeps its coins.
+*/
+struct NoCoin {};
+struct HasCoin {};
+struct Dispensing {};
+struct SoldOut {};
+
+using State = variant<NoCoin, HasCoin, Dispensing, SoldOut>;
+
+class VendingMachine {
+private:
+    FleetManager& fleet;
+    size_t machine;
+    State state;
+    ItemId selectedItem = NO_ITEM;
+    int coins = 0;
+
+    State idleState() {
+        return fleet.isSoldOut(machine) ? State(SoldOut{}) : State(NoCoin{});
+    }
+
+    // ---- insertCoin ----
+    State onInsertCoin(NoCoin, int c) { coins = c; return HasCoin{}; }
+    State onInsertCoin(HasCoin s, int c) { coins += c; return s; }
+    template <class S> State onInsertCoin(S s, int) { return s; }
+
+    // ---- selectItem ----
+    State onSelectItem(NoCoin s, ItemId) {
+        cout << "Insert coin first\n"; return s;
+    }
+    State onSelectItem(HasCoin s, ItemId item) {
+        if (!fleet.carries(machine, item) || fleet.getQuantity(machine, item) == 0 ||
+            coins < fleet.getPrice(machine, item))
+            return s;
+        selectedItem = item;
+        return Dispensing{};
+    }
+    template <class S> State onSelectItem(S s, ItemId) { return s; }
+
+    // ---- dispense ----
+    State onDispense(Dispensing) {
+        ItemId item = selectedItem;
+        selectedItem = NO_ITEM;
+        if (!fleet.tryDispense(machine, item))
+            return HasCoin{};                // sold elsewhere meanwhile
+        coins = 0;
+        return idleState();
+    }
+    template <class S> State onDispense(S s) { return s; }
+
+    // ---- returnCoin ----
+    State onReturnCoin(HasCoin) { coins = 0; return NoCoin{}; }
+    template <class S> State onReturnCoin(S s) { return s; }
+
+    // ---- refill ----
+    State onRefill(NoCoin s, ItemId item, int q) {
+        fleet.refill(machine, item, q); return s;
+    }
+    State onRefill(SoldOut, ItemId item, int q) {
+        fleet.refill(machine, item, q); return idleState();
+    }
+    template <class S> State onRefill(S s, ItemId, int) { return s; }
+
+public:
+    VendingMachine(FleetManager& fleet, size_t machine)
+        : fleet(fleet), machine(machine) {
+        state = idleState();
+    }
+
+    // Stock changed from outside (setup, restock run)
+    void sync() {
+        if (holds_alternative<NoCoin>(state) || holds_alternative<SoldOut>(state))
+            state = idleState();
+    }
+
+    int getCoins() { return coins; }
+
+    void insertCoin(int c) {
+        state = visit([&](auto s) { return onInsertCoin(s, c); }, state);
+    }
+    void selectItem(ItemId item) {
+        state = visit([&](auto s) { return onSelectItem(s, item); }, state);
+    }
+    void selectItem(const string& name) {
+        selectItem(fleet.getCatalog().find(name));
+    }
+    void dispense() {
+        state = visit([&](auto s) { return onDispense(s); }, state);
+    }
+    void returnCoin() {
+        state = visit([&](auto s) { return onReturnCoin(s); }, state);
+    }
+    void refill(const string& name, int q) {
+        ItemId item = fleet.getCatalog().find(name);
+        if (item == NO_ITEM)
+            return;
+        state = visit([&](auto s) { return onRefill(s, item, q); }, state);
+    }
+
+    string getStateName() {
+        static const char* names[] = {"NO_COIN", "HAS_COIN", "DISPENSING", "SOLD_OUT"};
+        return names[state.index()];
+    }
+
+    void printStatus() {
+        cout << "State: " << getStateName()
+             << " | Balance: Rs " << coins << endl;
+        const ItemCatalog& catalog = fleet.getCatalog();
+        for (ItemId item = 0; item < catalog.size(); item++)
+            if (fleet.carries(machine, item))
+                cout << "  " << catalog.getName(item) << " Qty: "
+                     << fleet.getQuantity(machine, item) << endl;
+    }
+};
+
+} // namespace Fleet
+
+/*
+=================================================================
+=                 BENCHMARK: STATE DISPATCH                      =
+=================================================================
+Same event stream through MultiVM::VendingMachine (virtual
+states) and MultiVM::Static::VendingMachine:
+- behavior: the demo purchase script prints the same output
+- latency: a cycle of events that touch only the state and
+  coins (no item lookups), then a full purchase cycle
+*/
+
+template <class Machine>
+string runPurchaseScript() {
+    Machine m;
+    ostringstream out;
+    optional<AsyncLog::Redirect> capture(in_place, out.rdbuf());
+
+    m.addItem("Water", 20, 1);
+    m.addItem("Coke", 30, 1);
+    m.addItem("Chips", 15, 2);
+    m.selectItem("Water");
+    m.insertCoin(10); m.selectItem("Coke"); m.returnCoin();
+    m.insertCoin(20); m.selectItem("Water"); m.dispense();
+    m.insertCoin(15); m.selectItem("Chips"); m.dispense();
+    m.insertCoin(15); m.selectItem("Chips"); m.dispense();
+    m.insertCoin(30); m.selectItem("Coke"); m.dispense();
+    m.insertCoin(10); m.dispense(); m.returnCoin();
+    m.refill("Water", 2);
+    m.refill("Coke", 1);
+    m.printStatus();
+
+    capture.reset();
+    return out.str();
+}
+
+/*
+ Every event's coins and state index are folded into `checksum`
+ (printed by the caller), so the compiler cannot drop the events:
+ an unused result let it delete the whole loop (~0.1 ns/event).
+*/
+template <class Machine>
+double timeEvents(Machine& m, int cycles, bool purchase, uint64_t& checksum) {
+    auto observe = [&]() { checksum = checksum * 31 + m.getCoins() * 4 + m.getStateIndex(); };
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < cycles; i++) {
+        if (purchase) {
+            m.insertCoin(20); observe();
+            m.selectItem("Water"); observe();
+            m.dispense(); observe();
+        } else {
+            m.insertCoin(5); observe();
+            m.insertCoin(5); observe();
+            m.dispense(); observe();
+            m.returnCoin(); observe();
+            m.dispense(); observe();
+            m.returnCoin(); observe();
+        }
+    }
+    double events = (double)cycles * (purchase ? 3 : 6);
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / events;
+}
+
+void runDispatchBenchmark() {
+    const int CYCLES = 5000000;
+
+    bool sameBehavior = runPurchaseScript<MultiVM::VendingMachine>()
+                        == runPurchaseScript<MultiVM::Static::VendingMachine>();
+
+    MultiVM::VendingMachine dynamicVM;
+    MultiVM::Static::VendingMachine staticVM;
+    dynamicVM.addItem("Water", 20, 1000000000);
+    staticVM.addItem("Water", 20, 1000000000);
+
+    uint64_t dynamicSum = 0, staticSum = 0;
+    double dynamicNs = timeEvents(dynamicVM, CYCLES, false, dynamicSum);
+    double staticNs = timeEvents(staticVM, CYCLES, false, staticSum);
+    double dynamicBuyNs = timeEvents(dynamicVM, CYCLES, true, dynamicSum);
+    double staticBuyNs = timeEvents(staticVM, CYCLES, true, staticSum);
+
+    cout << "\n==== VENDING STATE DISPATCH (" << CYCLES << " cycles) ====\n"
+         << "same behavior\t\t" << (sameBehavior ? "yes" : "NO") << "\n"
+         << "event checksums\t\t" << hex << dynamicSum << " / " << staticSum << dec
+         << (dynamicSum == staticSum ? " (match)" : " (DIFFER)") << "\n"
+         << "virtual, state only\t" << dynamicNs << " ns per event\n"
+         << "variant, state only\t" << staticNs << " ns per event\n"
+         << "virtual, purchase\t" << dynamicBuyNs << " ns per event\n"
+         << "variant, purchase\t" << staticBuyNs << " ns per event\n";
+}
+
+/*
+=================================================================
+=                 BENCHMARK: FLEET INVENTORY                     =
+=================================================================
+- oversell: THREADS purchases race for random slots of a
+  fleet while a telemetry thread keeps rolling it up; stock
+  sold must equal successful purchases, nothing below zero,
+  and a single hot slot must sell exactly its stock
+- purchase path: MultiVM (string-keyed map) vs Fleet
+  (interned ItemId, flat array), one machine, one thread
+- rollup: one lock-free pass over the whole fleet
+*/
+
+void runFleetBenchmark() {
+    const int MACHINES = 5000;
+    const int ITEMS = 32;
+    const int THREADS = 8;
+    const int ATTEMPTS_PER_THREAD = 500000;
+    const int HOT_STOCK = 1000;
+    const int PURCHASES = 2000000;
+
+    vector<string> names;
+    for (int i = 0; i < ITEMS; i++)
+        names.push_back("Item-" + to_string(i));
+
+    Fleet::FleetManager fleet(MACHINES, ITEMS);
+    for (auto& name : names)
+        fleet.addItem(name);
+    mt19937 rng(7);
+    long long stockBefore = 0;
+    for (int m = 0; m < MACHINES; m++)
+        for (Fleet::ItemId item = 0; item < ITEMS; item++) {
+            int units = rng() % 21;
+            fleet.stock(m, item, 10 + rng() % 41, units);
+            stockBefore += units;
+        }
+
+    // ---- concurrent purchases + telemetry ----
+    atomic<bool> selling{true};
+    atomic<long long> sold{0};
+    int rollups = 0;
+    thread telemetry([&]() {
+        while (selling.load()) {
+            fleet.rollup();
+            rollups++;
+        }
+    });
+
+    vector<thread> buyers;
+    for (int t = 0; t < THREADS; t++)
+        buyers.emplace_back([&, t]() {
+            mt19937 local(t + 1);
+            long long ok = 0;
+            for (int i = 0; i < ATTEMPTS_PER_THREAD; i++)
+                ok += fleet.tryDispense(local() % MACHINES, local() % ITEMS);
+            sold += ok;
+        });
+    for (auto& t : buyers) t.join();
+    selling = false;
+    telemetry.join();
+
+    Fleet::FleetTelemetry after = fleet.rollup();
+    long long stockAfter = 0;
+    bool negative = false;
+    for (auto& item : after.items)
+        stockAfter += item.quantity;
+    for (int m = 0; m < MACHINES; m++)
+        for (Fleet::ItemId item = 0; item < ITEMS; item++)
+            negative = negative || fleet.getQuantity(m, item) < 0;
+    bool conserved = stockBefore - stockAfter == sold && (long long)after.sales == sold && !negative;
+
+    // ---- one hot slot ----
+    Fleet::FleetManager hot(1, 1);
+    Fleet::ItemId water = hot.addItem("Water");
+    hot.stock(0, water, 20, HOT_STOCK);
+    atomic<int> hotSold{0};
+    vector<thread> racers;
+    for (int t = 0; t < THREADS; t++)
+        racers.emplace_back([&]() {
+            for (int i = 0; i < HOT_STOCK; i++)
+                hotSold += hot.tryDispense(0, water);
+        });
+    for (auto& t : racers) t.join();
+    bool noOversell = hotSold == HOT_STOCK && hot.getQuantity(0, water) == 0;
+
+    // ---- purchase path ----
+    MultiVM::VendingMachine mapVM;
+    Fleet::FleetManager single(1, ITEMS);
+    for (int i = 0; i < ITEMS; i++) {
+        mapVM.addItem(names[i], 20, 1000000000);
+        single.stock(0, single.addItem(names[i]), 20, 1000000000);
+    }
+    Fleet::VendingMachine fleetVM(single, 0);
+
+    auto timedPurchases = [&](auto buy) {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < PURCHASES; i++)
+            buy(i % ITEMS);
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / PURCHASES;
+    };
+    double mapNs = timedPurchases([&](int i) {
+        mapVM.insertCoin(20); mapVM.selectItem(names[i]); mapVM.dispense();
+    });
+    double nameNs = timedPurchases([&](int i) {
+        fleetVM.insertCoin(20); fleetVM.selectItem(names[i]); fleetVM.dispense();
+    });
+    double idNs = timedPurchases([&](int i) {
+        fleetVM.insertCoin(20); fleetVM.selectItem((Fleet::ItemId)i); fleetVM.dispense();
+    });
+
+    // ---- rollup ----
+    const int PASSES = 200;
+    auto start = chrono::steady_clock::now();
+    long long checksum = 0;
+    for (int i = 0; i < PASSES; i++)
+        checksum += fleet.rollup().items[i % ITEMS].quantity;
+    double rollupUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / PASSES;
+
+    cout << "\n==== FLEET INVENTORY (" << MACHINES << " machines x " << ITEMS << " items) ====\n"
+         << "concurrent purchases\t" << THREADS << " threads, " << sold << " sold, "
+         << rollups << " rollups meanwhile, " << (conserved ? "stock conserved" : "STOCK WRONG") << "\n"
+         << "hot slot\t\t" << hotSold << " of " << HOT_STOCK << " sold, "
+         << (noOversell ? "no oversell" : "OVERSOLD") << "\n"
+         << "purchase, string map\t" << mapNs << " ns\n"
+         << "purchase, fleet name\t" << nameNs << " ns\n"
+         << "purchase, fleet id\t" << idNs << " ns\n"
+         << "rollup\t\t\t" << rollupUs << " us per pass ("
+         << rollupUs * 1000 / MACHINES << " ns per machine)"
+         << (checksum < 0 ? "!" : "") << "\n";
+}
+
+/*
+=================================================================
+=                 LOAD SUITE: --load                             =
+=================================================================
+Machine-readable: one JSON line per case and buyer count (see
+bench/LoadHarness.h for flags and fields). One shared fleet of
+MACHINES x ITEMS slots, stocked deep enough not to run out.
+- machine_purchase: each buyer stands at its own machine of
+  the fleet; one op = insertCoin + selectItem(id) + dispense,
+  timed 8 purchases per sample (see batch)
+- fleet_dispense: buyers race on random slots of the whole
+  fleet; one op = one tryDispense (CAS on the slot)
+*/
+void runLoadSuite(const LoadHarness::Options& options) {
+    const int MACHINES = 5000;
+    const int ITEMS = 32;
+    const int STOCK = 1000000;
+
+    LoadHarness::Reporter report("vending", options);
+    AsyncLog::Redirect quiet(nullptr);
+
+    Fleet::FleetManager fleet(MACHINES, ITEMS);
+    for (int i = 0; i < ITEMS; i++)
+        fleet.addItem("Item-" + to_string(i));
+    for (int m = 0; m < MACHINES; m++)
+        for (Fleet::ItemId item = 0; item < ITEMS; item++)
+            fleet.stock(m, item, 20, STOCK);
+
+    if (options.wants("machine_purchase")) {
+        for (int buyers : options.threads) {
+            vector<unique_ptr<Fleet::VendingMachine>> machines;
+            for (int b = 0; b < buyers; b++)
+                machines.emplace_back(new Fleet::VendingMachine(fleet, b % MACHINES));
+
+            report.emit(LoadHarness::runLoad("machine_purchase", buyers, options.seconds,
+                [&](int b, uint64_t i) {
+                    Fleet::VendingMachine& vm = *machines[b];
+                    vm.insertCoin(20);
+                    vm.selectItem((Fleet::ItemId)(i % ITEMS));
+                    vm.dispense();
+                }, 8));
+        }
+    }
+
+    if (options.wants("fleet_dispense")) {
+        for (int buyers : options.threads) {
+            vector<mt19937> rngs;
+            for (int b = 0; b < buyers; b++)
+                rngs.emplace_back(b + 1);
+
+            report.emit(LoadHarness::runLoad("fleet_dispense", buyers, options.seconds,
+                [&](int b, uint64_t) {
+                    mt19937& rng = rngs[b];
+                    if (!fleet.tryDispense(rng() % MACHINES, rng() % ITEMS))
+                        LOG_WARN("fleet slot ran out under load");
+                }));
+        }
+    }
+}
+
 /*
 =================================================================
 =                           MAIN                                =
 =================================================================
 */
-int main() {
+int main(int argc, char* argv[]) {
+    AsyncLog::captureCout();
+
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runDispatchBenchmark();
+        runFleetBenchmark();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--load") {
+        runLoadSuite(LoadHarness::Options::parse(argc, argv));
+        return 0;
+    }
 
     /* =========================================================
        SIMPLE VENDING MACHINE : TEST ALL STATES
@@ -541,5 +1339,40 @@ int main() {
     mm.refill("Water", 2);
     mm.printStatus();
 
+    /* =========================================================
+       FLEET : SAME MACHINES, SHARED FLAT INVENTORY
+       ========================================================= */
+    cout << "\n================ VENDING FLEET ================\n";
+
+    Fleet::FleetManager fleet(3, 8);
+    Fleet::ItemId water = fleet.addItem("Water");
+    Fleet::ItemId coke = fleet.addItem("Coke");
+    for (size_t m = 0; m < 3; m++) {
+        fleet.stock(m, water, 20, 2);
+        fleet.stock(m, coke, 30, (int)m);
+    }
+    Fleet::VendingMachine station(fleet, 0);
+
+    cout << "\n[ACTION] Machine 0: buying Water, then Coke (none left here)\n";
+    station.insertCoin(20);
+    station.selectItem("Water");
+    station.dispense();
+    station.insertCoin(30);
+    station.selectItem(coke);
+    station.returnCoin();
+    station.printStatus();
+
+    cout << "\n[TELEMETRY] Fleet rollup\n";
+    Fleet::FleetTelemetry rollup = fleet.rollup();
+    for (auto& item : rollup.items)
+        cout << "  " << item.name << " Qty: " << item.quantity
+             << " | machines: " << item.machinesStocking
+             << " | empty: " << item.machinesEmpty << endl;
+    cout << "  Sales: " << rollup.sales << " | Revenue: Rs " << rollup.revenue
+         << " | Sold-out machines: " << rollup.soldOutMachines << endl;
+
+    cout << "\n================ METRICS (Prometheus text) ================\n";
+    cout << Metrics::prometheusText();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+/*
+===========================================================
+ALLOC COUNTER (shared by the --bench modes that report
+heap allocations per operation)
+===========================================================
+Header-only, like LoadHarness.h, included with a relative
+path. It replaces the global operator new/delete family, so
+include it from exactly one translation unit (every example
+is a single file).
+
+- AllocCounter::count(): operator new calls so far, every
+  thread; take the difference around the code being measured
+- plain, array and over-aligned (align_val_t) forms are all
+  counted; the library's nothrow forms call the plain ones
+- every replacement is noinline: once GCC inlines a new (or
+  a delete) into a caller it sees malloc() paired with the
+  library's operator delete (or the reverse) and reports
+  -Wmismatched-new-delete
+- one relaxed fetch_add per allocation: fine for counting,
+  not meant to stay in a production build
+===========================================================
+*/
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace AllocCounter {
+
+inline std::atomic<size_t> allocations{0};
+
+inline size_t count() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+[[gnu::noinline]] inline void* allocate(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+// aligned_alloc wants a size that is a multiple of the alignment
+[[gnu::noinline]] inline void* allocate(size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    size_t rounded = (size + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, rounded ? rounded : align))
+        return p;
+    throw std::bad_alloc();
+}
+
+} // namespace AllocCounter
+
+[[gnu::noinline]] void* operator new(size_t size) {
+    return AllocCounter::allocate(size);
+}
+[[gnu::noinline]] void* operator new[](size_t size) {
+    return AllocCounter::allocate(size);
+}
+[[gnu::noinline]] void* operator new(size_t size, std::align_val_t alignment) {
+    return AllocCounter::allocate(size, alignment);
+}
+[[gnu::noinline]] void* operator new[](size_t size, std::align_val_t alignment) {
+    return AllocCounter::allocate(size, alignment);
+}
+
+// malloc and aligned_alloc blocks are both released with free()
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+#endif // ALLOC_COUNTER_H
@@ -0,0 +1,228 @@
+/*
+===========================================================
+LOAD HARNESS (shared by every example's --load mode)
+===========================================================
+Header-only, like AsyncLog.h. Each example includes it with a
+relative path, so `g++ file.cpp` keeps working without flags.
+
+- runLoad(): N worker threads call op(worker, iteration) in a
+  closed loop for a fixed time; every call is timed
+- every worker records into its own log-linear histogram (no
+  locks, no allocation while measuring); they are merged at
+  the end. Percentiles are bucket upper bounds, within ~3%
+  (32 sub-buckets per power of two)
+- ops cheaper than the clock itself (~20 ns) pass a batch:
+  one sample = `batch` back-to-back calls, recorded per call
+- one JSON object per line (JSON Lines) per case and thread
+  count, written with stdio so it bypasses AsyncLog's capture
+  of cout and stays clean while the example's logging is
+  silenced:
+  {"suite":"parkinglot","case":"gate_visit","threads":8,
+   "batch":1,"ops":123456,"seconds":1.0002,"ops_per_sec":123431,
+   "p50_ns":812,"p99_ns":2431,"p999_ns":9215,"max_ns":104857}
+
+COMMAND LINE (Options::parse):
+  ./example --load [--threads 1,2,8] [--seconds 0.5]
+                   [--case name] [--out results.jsonl]
+- --threads: comma list; default 1, 2, 4, ... max(4, hardware)
+- --case: run only the case with that name
+- --out: append the lines to a file instead of stdout
+
+BUILD AND COMPARE (CMakeLists.txt at the repo root):
+  cmake --build build --target load   -> build/load_results.jsonl
+  python3 bench/compare_load.py baseline.jsonl current.jsonl
+
+Closed loop: a slow call delays that worker's next one, so the
+tails are service times, not what clients arriving at a fixed
+rate would see (coordinated omission).
+===========================================================
+*/
+#ifndef LOAD_HARNESS_H
+#define LOAD_HARNESS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/LogHistogram.h"
+
+namespace LoadHarness {
+
+// One per worker, merged at the end (see common/LogHistogram.h)
+typedef LogHistogram<5> Histogram;
+
+struct Options {
+    std::vector<int> threads;
+    double seconds = 1.0;
+    std::string only;
+    std::string out;
+
+    bool wants(const char* name) const {
+        return only.empty() || only == name;
+    }
+
+    static void usage(const char* program) {
+        std::fprintf(stderr, "usage: %s --load [--threads 1,2,8] [--seconds S] "
+                             "[--case name] [--out file]\n", program);
+        std::exit(2);
+    }
+
+    // argv[first] onwards; exits with the usage line on bad input
+    static Options parse(int argc, char* argv[], int first = 2) {
+        Options options;
+        for (int i = first; i < argc; i++) {
+            std::string flag = argv[i];
+            if (i + 1 >= argc)
+                usage(argv[0]);
+            std::string value = argv[++i];
+            if (flag == "--threads") {
+                size_t at = 0;
+                while (at < value.size()) {
+                    size_t comma = value.find(',', at);
+                    if (comma == std::string::npos)
+                        comma = value.size();
+                    int n = std::atoi(value.substr(at, comma - at).c_str());
+                    if (n <= 0)
+                        usage(argv[0]);
+                    options.threads.push_back(n);
+                    at = comma + 1;
+                }
+            } else if (flag == "--seconds") {
+                options.seconds = std::atof(value.c_str());
+                if (options.seconds <= 0)
+                    usage(argv[0]);
+            } else if (flag == "--case") {
+                options.only = value;
+            } else if (flag == "--out") {
+                options.out = value;
+            } else {
+                usage(argv[0]);
+            }
+        }
+        if (options.threads.empty()) {
+            int maxThreads = (int)std::max(4u, std::thread::hardware_concurrency());
+            for (int n = 1; n <= maxThreads; n *= 2)
+                options.threads.push_back(n);
+            if (options.threads.back() != maxThreads)
+                options.threads.push_back(maxThreads);
+        }
+        return options;
+    }
+};
+
+struct Result {
+    std::string name;
+    int threads = 0;
+    int batch = 1;
+    uint64_t ops = 0;
+    double seconds = 0;
+    Histogram latency;     // ns per op
+};
+
+class Reporter {
+private:
+    std::string suite;
+    FILE* file;
+
+public:
+    Reporter(const std::string& suite, const Options& options) : suite(suite) {
+        file = options.out.empty() ? stdout : std::fopen(options.out.c_str(), "a");
+        if (!file) {
+            std::fprintf(stderr, "cannot open %s\n", options.out.c_str());
+            std::exit(1);
+        }
+    }
+
+    ~Reporter() {
+        if (file != stdout)
+            std::fclose(file);
+    }
+
+    Reporter(const Reporter&) = delete;
+    Reporter& operator=(const Reporter&) = delete;
+
+    void emit(const Result& r) {
+        double perSecond = r.seconds > 0 ? (double)r.ops / r.seconds : 0;
+        std::fprintf(file,
+            "{\"suite\":\"%s\",\"case\":\"%s\",\"threads\":%d,\"batch\":%d,"
+            "\"ops\":%llu,\"seconds\":%.4f,\"ops_per_sec\":%.0f,"
+            "\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu}\n",
+            suite.c_str(), r.name.c_str(), r.threads, r.batch,
+            (unsigned long long)r.ops, r.seconds, perSecond,
+            (unsigned long long)r.latency.percentile(0.50),
+            (unsigned long long)r.latency.percentile(0.99),
+            (unsigned long long)r.latency.percentile(0.999),
+            (unsigned long long)r.latency.max());
+        std::fflush(file);
+    }
+};
+
+/*
+ Runs op(worker, iteration) on `threads` workers for `seconds`.
+ Workers start together; per-worker state belongs to the
+ caller (index it by `worker`), set up before and torn down
+ after this call.
+*/
+template <class Op>
+Result runLoad(const char* name, int threads, double seconds, Op op, int batch = 1) {
+    using Clock = std::chrono::steady_clock;
+
+    struct alignas(64) Worker {
+        Histogram latency;
+        uint64_t ops = 0;
+    };
+    std::vector<Worker> workers(threads);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> pool;
+    for (int w = 0; w < threads; w++) {
+        pool.emplace_back([&, w] {
+            Worker& self = workers[w];
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            uint64_t iteration = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto start = Clock::now();
+                for (int b = 0; b < batch; b++)
+                    op(w, iteration++);
+                uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - start).count();
+                self.latency.record(ns / (uint64_t)batch, (uint64_t)batch);
+                self.ops += (uint64_t)batch;
+            }
+        });
+    }
+
+    while (ready.load() < threads)
+        std::this_thread::yield();
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& t : pool)
+        t.join();
+
+    Result result;
+    result.name = name;
+    result.threads = threads;
+    result.batch = batch;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (const Worker& w : workers) {
+        result.latency.merge(w.latency);
+        result.ops += w.ops;
+    }
+    return result;
+}
+
+} // namespace LoadHarness
+
+#endif
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""
+Compare two --load result files (JSON Lines) case by case.
+
+    python3 bench/compare_load.py baseline.jsonl current.jsonl [--tolerance 0.10]
+
+Rows are matched on (suite, case, threads). Prints the
+throughput and p99 ratio current / baseline; a row whose
+throughput fell, or whose p99 grew, by more than the tolerance
+is marked REGRESSED and makes the exit status 1. A baseline
+row with no match in the current run (a case that crashed,
+was renamed or was dropped) is listed as MISSING and fails
+the same way; rows only in the current run are new, not
+compared.
+"""
+import json
+import sys
+
+
+def load(path):
+    rows = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line:
+                r = json.loads(line)
+                rows[(r["suite"], r["case"], r["threads"])] = r
+    return rows
+
+
+def main(argv):
+    args = [a for a in argv[1:] if not a.startswith("--")]
+    tolerance = 0.10
+    if "--tolerance" in argv:
+        tolerance = float(argv[argv.index("--tolerance") + 1])
+        args.remove(argv[argv.index("--tolerance") + 1])
+    if len(args) != 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    baseline, current = load(args[0]), load(args[1])
+    regressed = compared = 0
+    print("suite\tcase\tthreads\tops/s ratio\tp99 ratio")
+    for key in sorted(current):
+        if key not in baseline:
+            continue
+        old, new = baseline[key], current[key]
+        compared += 1
+        speed = new["ops_per_sec"] / old["ops_per_sec"] if old["ops_per_sec"] else 0
+        p99 = new["p99_ns"] / old["p99_ns"] if old["p99_ns"] else 0
+        bad = speed < 1 - tolerance or p99 > 1 + tolerance
+        regressed += bad
+        print("%s\t%s\t%d\t%.2fx\t\t%.2fx%s" % (key[0], key[1], key[2], speed, p99,
+                                                "\tREGRESSED" if bad else ""))
+    missing = sorted(key for key in baseline if key not in current)
+    for key in missing:
+        print("%s\t%s\t%d\t-\t\t-\tMISSING" % key)
+    print("%d of %d rows regressed, %d missing" % (regressed, compared, len(missing)))
+    return 1 if regressed or missing else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
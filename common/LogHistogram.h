@@ -0,0 +1,108 @@
+/*
+===========================================================
+LOG-LINEAR HISTOGRAM (shared by LoadHarness.h, Metrics.h and
+the Pub-Sub delivery workers)
+===========================================================
+Header-only, like WorkStealingPool.h, included with a
+relative path.
+
+- HDR-style: every power of two is split into 2^SUB_BITS
+  equal sub-buckets, values below 2^SUB_BITS get a bucket
+  each, so a percentile is within 1 / 2^SUB_BITS of the true
+  value over the whole 64-bit range
+    LogHistogram<3>: 8 sub-buckets, 12.5%, 496 buckets
+    LogHistogram<5>: 32 sub-buckets, ~3%, 1920 buckets
+- fixed size, no allocation; record() is an index and two adds
+- not thread-safe: give each writer its own and merge() them.
+  Metrics.h keeps atomic per-slot counts with the same
+  bucketFor() and folds them in with add() / addSum()
+- percentile(p) is the upper bound of the bucket holding the
+  ceil(p * count)-th value, capped at max()
+===========================================================
+*/
+#ifndef LOG_HISTOGRAM_H
+#define LOG_HISTOGRAM_H
+
+#include <cmath>
+#include <cstdint>
+
+template <int SUB_BITS>
+class LogHistogram {
+public:
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    static int bucketFor(uint64_t value) {
+        if (value < SUB_BUCKETS)
+            return (int)value;
+        int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + (int)((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static uint64_t upperBound(int bucket) {
+        if (bucket < SUB_BUCKETS)
+            return (uint64_t)bucket;
+        int shift = bucket / SUB_BUCKETS - 1;
+        uint64_t sub = (uint64_t)(bucket % SUB_BUCKETS);
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+
+    void record(uint64_t value, uint64_t times = 1) {
+        counts[bucketFor(value)] += times;
+        total += times;
+        sumValue += value * times;
+        if (value > maxValue)
+            maxValue = value;
+    }
+
+    // Folds in counts kept elsewhere with the same bucketFor(); the
+    // exact values are gone, so max() becomes the bucket's upper bound
+    void add(int bucket, uint64_t n) {
+        if (n == 0)
+            return;
+        counts[bucket] += n;
+        total += n;
+        if (upperBound(bucket) > maxValue)
+            maxValue = upperBound(bucket);
+    }
+
+    void addSum(uint64_t sum) {
+        sumValue += sum;
+    }
+
+    void merge(const LogHistogram& other) {
+        for (int i = 0; i < BUCKETS; i++)
+            counts[i] += other.counts[i];
+        total += other.total;
+        sumValue += other.sumValue;
+        if (other.maxValue > maxValue)
+            maxValue = other.maxValue;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t sum() const { return sumValue; }
+    uint64_t max() const { return maxValue; }
+
+    uint64_t percentile(double p) const {
+        if (total == 0)
+            return 0;
+        uint64_t target = (uint64_t)std::ceil(p * (double)total);
+        if (target == 0)
+            target = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= target)
+                return upperBound(i) < maxValue ? upperBound(i) : maxValue;
+        }
+        return maxValue;
+    }
+
+private:
+    uint64_t counts[BUCKETS] = {};
+    uint64_t total = 0;
+    uint64_t sumValue = 0;
+    uint64_t maxValue = 0;
+};
+
+#endif // LOG_HISTOGRAM_H
@@ -0,0 +1,366 @@
+/*
+===========================================================
+PAYMENT LANES (shared by strategy_payment.cpp and the
+parking lot's exit gates)
+===========================================================
+Header-only, like AsyncLog.h and LoadHarness.h, included with
+a relative path.
+
+- PaymentStrategy: pay() one payment, payBatch() many in one
+  provider round-trip; the lanes only ever call payBatch()
+- submit() queues the payment and returns a future at once,
+  so the caller never waits on the network
+- ONE LANE PER PROVIDER, each with its own queue and workers:
+  a slow provider only ever backs up its own lane
+- a worker takes up to `maxBatch` queued payments (waiting
+  `linger` for the batch to fill) and sends them in one
+  payBatch(); `maxInFlight` workers = at most that many
+  concurrent round-trips to the provider
+- every attempt gets `timeout`; FAILED / TIMED_OUT payments
+  are retried up to `maxRetries` times after an exponential
+  backoff
+- `deadline` bounds the whole payment, queueing and retries
+  included: a reaper thread settles an overdue future as
+  TIMED_OUT even if the provider hangs, and a payment still
+  queued after it is not sent
+- a payBatch() that throws counts as FAILED for its batch
+- C++17 has no coroutines here, so the awaitable is a
+  std::future
+===========================================================
+*/
+#ifndef PAYMENT_LANE_H
+#define PAYMENT_LANE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// FAILED and TIMED_OUT are transient and retried; DECLINED is final
+enum PaymentStatus { APPROVED, DECLINED, FAILED, TIMED_OUT };
+
+inline const char* statusName(PaymentStatus status) {
+    switch (status) {
+        case APPROVED:  return "APPROVED";
+        case DECLINED:  return "DECLINED";
+        case FAILED:    return "FAILED";
+        case TIMED_OUT: return "TIMED_OUT";
+    }
+    return "UNKNOWN";
+}
+
+struct PaymentResult {
+    PaymentStatus status;
+    int attempts;                        // round-trips this payment took part in
+    std::chrono::microseconds latency;   // submit -> result, queueing included
+};
+
+class PaymentStrategy {
+public:
+    // The provider's answer for one payment; may block on the network
+    virtual PaymentStatus pay(int amount) = 0;
+
+    // Answers payments in one round-trip and must return by `deadline`
+    // (the network timeout). Callers fill `results` with TIMED_OUT
+    // first; whatever is not answered keeps it.
+    // Default: the provider has no batch API, so pay() them one by one
+    // until the deadline; a pay() that throws is FAILED
+    virtual void payBatch(const int* amounts, PaymentStatus* results, size_t count,
+                          std::chrono::steady_clock::time_point deadline) {
+        for (size_t i = 0; i < count && std::chrono::steady_clock::now() < deadline; i++) {
+            try {
+                results[i] = pay(amounts[i]);
+            } catch (...) {
+                results[i] = FAILED;
+            }
+        }
+    }
+
+    virtual ~PaymentStrategy() {}
+};
+
+struct PaymentLaneConfig {
+    size_t maxBatch = 32;                          // payments per round-trip
+    int maxInFlight = 4;                           // concurrent round-trips
+    std::chrono::microseconds linger{200};         // wait for a batch to fill
+    std::chrono::milliseconds timeout{50};         // one attempt
+    int maxRetries = 2;                            // extra attempts for transient results
+    std::chrono::milliseconds backoff{2};          // doubled on every retry
+    std::chrono::milliseconds deadline{500};       // the whole payment
+};
+
+/*
+ Deadline enforcement
+ - every payment's promise sits in a Ticket shared by the queue,
+   the worker sending it and the lane's reaper thread
+ - whoever settles the ticket first sets the promise; a later
+   answer (a round-trip that came back after the deadline) is
+   dropped
+ - the reaper settles overdue tickets as TIMED_OUT even while
+   every worker is stuck in payBatch(), so future.get() returns
+   by `deadline`. Deadlines are submit time + one constant, so
+   the reaper's list is in deadline order and only its front is
+   ever checked
+*/
+class PaymentLane {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Ticket {
+        std::promise<PaymentResult> result;
+        std::atomic<bool> settled{false};
+        std::atomic<int> attempts{0};
+        Clock::time_point submitted;
+    };
+
+    struct Pending {
+        int amount;
+        Clock::time_point notBefore;          // end of the retry backoff
+        std::shared_ptr<Ticket> ticket;
+    };
+
+    PaymentStrategy* strategy;
+    PaymentLaneConfig config;
+
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<Pending> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    std::condition_variable reaperWake;
+    std::deque<std::shared_ptr<Ticket>> byDeadline;   // submit order = deadline order
+    bool reaperStopping = false;
+    std::thread reaper;
+
+    std::atomic<uint64_t> roundTrips{0};
+    std::atomic<uint64_t> retries{0};
+    std::atomic<uint64_t> reaped{0};
+
+    // First caller wins; false if the ticket was already settled
+    static bool complete(Ticket& ticket, PaymentStatus status, Clock::time_point now) {
+        if (ticket.settled.exchange(true, std::memory_order_acq_rel))
+            return false;
+        ticket.result.set_value({status, ticket.attempts.load(std::memory_order_relaxed),
+            std::chrono::duration_cast<std::chrono::microseconds>(now - ticket.submitted)});
+        return true;
+    }
+
+    // Caller holds `lock`
+    bool dueBefore(Clock::time_point when) const {
+        return std::any_of(queue.begin(), queue.end(),
+                           [&](const Pending& pending) { return pending.notBefore < when; });
+    }
+
+    // Blocks until there is something to send; false once stopped and drained.
+    // Payments the reaper already settled are dropped from the queue here
+    bool takeBatch(std::vector<Pending>& batch) {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            ready.wait(guard, [&] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return false;
+
+            if (!stopping && queue.size() < config.maxBatch)
+                ready.wait_for(guard, config.linger,
+                               [&] { return stopping || queue.size() >= config.maxBatch; });
+
+            auto now = Clock::now();
+            auto nextRetry = Clock::time_point::max();
+            for (auto it = queue.begin(); it != queue.end() && batch.size() < config.maxBatch;) {
+                if (it->ticket->settled.load(std::memory_order_acquire)) {
+                    it = queue.erase(it);
+                } else if (it->notBefore <= now) {
+                    batch.push_back(std::move(*it));
+                    it = queue.erase(it);
+                } else {
+                    nextRetry = std::min(nextRetry, it->notBefore);
+                    ++it;
+                }
+            }
+            if (!batch.empty())
+                return true;
+            // Another worker (or the reaper) emptied the queue meanwhile
+            if (nextRetry == Clock::time_point::max())
+                continue;
+            // Only backing-off retries are queued. Wake early for anything
+            // due sooner (a new submit), or once the queue is emptied, so
+            // the stop check above runs again instead of missing notify_all
+            ready.wait_until(guard, nextRetry,
+                             [&] { return queue.empty() || dueBefore(nextRetry); });
+        }
+    }
+
+    // Delivers final results; transient ones go back in the queue
+    void finish(std::vector<Pending>& batch, const std::vector<PaymentStatus>& results) {
+        auto now = Clock::now();
+        size_t requeued = 0;
+        for (size_t i = 0; i < batch.size(); i++) {
+            Pending& pending = batch[i];
+            Ticket& ticket = *pending.ticket;
+            int attempts = ticket.attempts.fetch_add(1, std::memory_order_relaxed) + 1;
+            bool transient = results[i] == FAILED || results[i] == TIMED_OUT;
+            if (!transient || attempts > config.maxRetries
+                || now - ticket.submitted >= config.deadline) {
+                complete(ticket, results[i], now);
+                continue;
+            }
+            if (ticket.settled.load(std::memory_order_acquire))
+                continue;                     // reaped while in flight
+            pending.notBefore = now + config.backoff * (1 << (attempts - 1));
+            batch[requeued++] = std::move(pending);
+        }
+        if (!requeued)
+            return;
+
+        retries.fetch_add(requeued, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (size_t i = 0; i < requeued; i++)
+                queue.push_back(std::move(batch[i]));
+        }
+        ready.notify_one();
+    }
+
+    void run() {
+        std::vector<Pending> batch;
+        std::vector<int> amounts;
+        std::vector<PaymentStatus> results;
+        while (takeBatch(batch)) {
+            amounts.clear();
+            for (const Pending& pending : batch)
+                amounts.push_back(pending.amount);
+            results.assign(batch.size(), TIMED_OUT);
+
+            // A provider that throws failed the whole round-trip (retried)
+            try {
+                strategy->payBatch(amounts.data(), results.data(), batch.size(),
+                                   Clock::now() + config.timeout);
+            } catch (...) {
+                results.assign(batch.size(), FAILED);
+            }
+            roundTrips.fetch_add(1, std::memory_order_relaxed);
+
+            finish(batch, results);
+            batch.clear();
+        }
+    }
+
+    // Settles overdue tickets as TIMED_OUT, whatever the workers are doing
+    void reap() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            while (!byDeadline.empty() && byDeadline.front()->settled.load(std::memory_order_acquire))
+                byDeadline.pop_front();
+            if (byDeadline.empty()) {
+                if (reaperStopping)
+                    return;
+                reaperWake.wait(guard);
+                continue;
+            }
+            auto due = byDeadline.front()->submitted + config.deadline;
+            auto now = Clock::now();
+            if (now < due) {
+                reaperWake.wait_until(guard, due);
+                continue;
+            }
+            std::shared_ptr<Ticket> overdue = std::move(byDeadline.front());
+            byDeadline.pop_front();
+            guard.unlock();
+            if (complete(*overdue, TIMED_OUT, now))
+                reaped.fetch_add(1, std::memory_order_relaxed);
+            guard.lock();
+        }
+    }
+
+public:
+    PaymentLane(PaymentStrategy* strategy, const PaymentLaneConfig& config)
+        : strategy(strategy), config(config) {
+        for (int i = 0; i < std::max(1, config.maxInFlight); i++)
+            workers.emplace_back([this] { run(); });
+        reaper = std::thread([this] { reap(); });
+    }
+
+    // Every submitted future is settled by its deadline; the destructor
+    // also waits for round-trips in progress (payBatch must return)
+    ~PaymentLane() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            reaperStopping = true;
+        }
+        reaperWake.notify_one();
+        reaper.join();
+    }
+
+    PaymentLane(const PaymentLane&) = delete;
+    PaymentLane& operator=(const PaymentLane&) = delete;
+
+    std::future<PaymentResult> submit(int amount) {
+        auto ticket = std::make_shared<Ticket>();
+        std::future<PaymentResult> result = ticket->result.get_future();
+        bool firstPending;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto now = Clock::now();          // under the lock: keeps byDeadline sorted
+            ticket->submitted = now;
+            queue.push_back({amount, now, ticket});
+            firstPending = byDeadline.empty();
+            byDeadline.push_back(std::move(ticket));
+        }
+        ready.notify_one();
+        if (firstPending)
+            reaperWake.notify_one();
+        return result;
+    }
+
+    uint64_t getRoundTrips() const { return roundTrips.load(std::memory_order_relaxed); }
+    uint64_t getRetries() const { return retries.load(std::memory_order_relaxed); }
+    uint64_t getReaped() const { return reaped.load(std::memory_order_relaxed); }
+};
+
+class PaymentPipeline {
+private:
+    PaymentLaneConfig defaults;
+    std::mutex lock;
+    std::unordered_map<PaymentStrategy*, std::unique_ptr<PaymentLane>> lanes;
+
+public:
+    explicit PaymentPipeline(const PaymentLaneConfig& defaults = PaymentLaneConfig())
+        : defaults(defaults) {}
+
+    // Gives a provider its own limits; false if it already has a lane
+    bool addProvider(PaymentStrategy* strategy, const PaymentLaneConfig& config) {
+        std::lock_guard<std::mutex> guard(lock);
+        return lanes.emplace(strategy, std::make_unique<PaymentLane>(strategy, config)).second;
+    }
+
+    // Providers nobody configured get a lane with the defaults
+    PaymentLane& laneFor(PaymentStrategy* strategy) {
+        std::lock_guard<std::mutex> guard(lock);
+        std::unique_ptr<PaymentLane>& lane = lanes[strategy];
+        if (!lane)
+            lane = std::make_unique<PaymentLane>(strategy, defaults);
+        return *lane;
+    }
+
+    std::future<PaymentResult> submit(PaymentStrategy* strategy, int amount) {
+        return laneFor(strategy).submit(amount);
+    }
+};
+
+#endif // PAYMENT_LANE_H
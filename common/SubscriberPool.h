@@ -0,0 +1,183 @@
+/*
+===========================================================
+SUBSCRIBER POOL + GENERATIONAL HANDLES (shared by the
+observer example and Pub-Sub)
+===========================================================
+Header-only, like WorkStealingPool.h, included with a
+relative path.
+
+- SubscriberPool<T> owns subscriber objects in chunked slots
+  that are never returned to the heap while the pool lives;
+  create() reuses a free slot, so steady-state churn never
+  allocates
+- a slot carries a generation; destroy() bumps it, so every
+  handle issued before reads as dead: one 32-bit compare, no
+  refcount, readers only load the slot line
+- GenerationHandle<Base> = (slot, generation it was issued at,
+  target). A handle to a T converts to one to any base of T,
+  which is what the channels and topics store
+- unmanaged(): a bare pointer whose generation never changes
+  (the caller owns the lifetime, the old behaviour)
+- create() / destroy() take a lock, alive() never does
+- GracePeriod::synchronize() runs between the bump and the
+  destructor. Pub-Sub passes its Epoch so a publisher that
+  passed alive() just before the bump finishes its notify on a
+  live object; the default waits for nothing, so the caller
+  must not destroy during a notify
+- the pool must outlive every registry that still lists one of
+  its subscribers (the slot memory is what alive() reads)
+===========================================================
+*/
+#ifndef SUBSCRIBER_POOL_H
+#define SUBSCRIBER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+struct SubscriberSlot {
+    std::atomic<uint32_t> generation{1};
+
+    // Shared by every handle made from a bare pointer
+    static SubscriberSlot* unmanaged() {
+        static SubscriberSlot slot;
+        return &slot;
+    }
+};
+
+template <class Base>
+struct GenerationHandle {
+    SubscriberSlot* slot = nullptr;
+    uint32_t generation = 0;
+    Base* target = nullptr;
+
+    GenerationHandle() = default;
+    GenerationHandle(SubscriberSlot* slot, uint32_t generation, Base* target)
+        : slot(slot), generation(generation), target(target) {}
+
+    template <class Derived>
+    GenerationHandle(const GenerationHandle<Derived>& other)
+        : slot(other.slot), generation(other.generation), target(other.target) {}
+
+    // Legacy path: the caller guarantees the subscriber outlives
+    // its subscriptions (the unmanaged slot never changes)
+    static GenerationHandle unmanaged(Base* subscriber) {
+        SubscriberSlot* slot = SubscriberSlot::unmanaged();
+        return {slot, slot->generation.load(), subscriber};
+    }
+
+    bool isUnmanaged() const {
+        return slot == SubscriberSlot::unmanaged();
+    }
+
+    // A plain load and compare on x86/ARM: no locked instruction
+    bool alive() const {
+        return slot && slot->generation.load(std::memory_order_acquire) == generation;
+    }
+
+    bool operator==(const GenerationHandle& other) const {
+        return slot == other.slot && generation == other.generation && target == other.target;
+    }
+};
+
+struct NoGracePeriod {
+    static void synchronize() {}
+};
+
+template <class T, class GracePeriod = NoGracePeriod>
+class SubscriberPool {
+private:
+    static const size_t CHUNK_SLOTS = 64;
+
+    struct Slot : SubscriberSlot {
+        bool live = false;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* object() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    std::mutex mtx;
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    std::vector<Slot*> freeSlots;
+    size_t liveCount = 0;
+
+    void grow() {
+        chunks.emplace_back(new Slot[CHUNK_SLOTS]);
+        Slot* chunk = chunks.back().get();
+        for (size_t i = CHUNK_SLOTS; i-- > 0;)
+            freeSlots.push_back(&chunk[i]);
+    }
+
+public:
+    SubscriberPool() = default;
+    SubscriberPool(const SubscriberPool&) = delete;
+    SubscriberPool& operator=(const SubscriberPool&) = delete;
+
+    // Nobody may still be notifying when the pool dies
+    ~SubscriberPool() {
+        for (auto& chunk : chunks)
+            for (size_t i = 0; i < CHUNK_SLOTS; i++)
+                if (chunk[i].live)
+                    chunk[i].object()->~T();
+    }
+
+    template <class... Args>
+    GenerationHandle<T> create(Args&&... args) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (freeSlots.empty())
+            grow();
+        Slot* slot = freeSlots.back();
+        T* object = new (slot->storage) T(std::forward<Args>(args)...);
+        freeSlots.pop_back();
+        slot->live = true;
+        liveCount++;
+        return {slot, slot->generation.load(), object};
+    }
+
+    // nullptr once the handle's subscriber has been destroyed
+    template <class Base>
+    T* get(const GenerationHandle<Base>& handle) const {
+        return handle.alive() ? static_cast<T*>(handle.target) : nullptr;
+    }
+
+    /*
+     Invalidates every outstanding handle (and every registry
+     entry made from one), then runs the destructor after the
+     grace period. Returns false for a stale or unmanaged handle.
+    */
+    template <class Base>
+    bool destroy(const GenerationHandle<Base>& handle) {
+        if (!handle.slot || handle.isUnmanaged())
+            return false;
+        Slot* slot = static_cast<Slot*>(handle.slot);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!handle.alive() || !slot->live)
+                return false;
+            slot->generation.fetch_add(1);
+        }
+
+        GracePeriod::synchronize();
+        slot->object()->~T();
+
+        std::lock_guard<std::mutex> lock(mtx);
+        slot->live = false;
+        liveCount--;
+        freeSlots.push_back(slot);
+        return true;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return liveCount;
+    }
+};
+
+#endif // SUBSCRIBER_POOL_H
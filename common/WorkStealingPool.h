@@ -0,0 +1,188 @@
+/*
+===========================================================
+WORK-STEALING POOL (shared by the parallel sorts, the
+observer's parallel delivery and the ATM session engine)
+===========================================================
+Header-only, like AsyncLog.h and LoadHarness.h, included with
+a relative path.
+
+- threads are started once and reused by every fork/join
+- one deque per worker: a worker pops its own newest task and
+  steals the oldest task of another worker
+- a thread from outside the pool is worker 0 and runs tasks
+  too; size() counts it, so a pool of 1 has no background
+  threads and runs everything inline
+- run() + wait(): fork tasks into a TaskGroup, then help until
+  they are done. A task may fork and wait itself without
+  deadlock, because waiting runs tasks instead of blocking
+- runAll(count, fn): fn(0) .. fn(count - 1), one push and one
+  wake-up for the whole batch
+===========================================================
+*/
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct TaskGroup {
+    std::atomic<long> pending{0};
+};
+
+class WorkStealingPool {
+private:
+    // The group is kept beside the task rather than wrapped around it:
+    // a small task (a pointer and an id) then fits std::function's
+    // inline buffer and run() does not allocate
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;    // [0] = whoever calls in from outside
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopping{false};
+    std::atomic<long> queued{0};
+    std::atomic<int> sleepers{0};
+    std::mutex sleepLock;
+    std::condition_variable wake;
+
+    static inline thread_local const WorkStealingPool* currentPool = nullptr;
+    static inline thread_local size_t currentWorker = 0;
+
+    size_t self() const {
+        return currentPool == this ? currentWorker : 0;
+    }
+
+    bool popOwn(size_t me, Task& task) {
+        Worker& w = *workers[me];
+        std::lock_guard<std::mutex> guard(w.lock);
+        if (w.tasks.empty()) return false;
+        task = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t me, Task& task) {
+        for (size_t k = 1; k < workers.size(); k++) {
+            Worker& victim = *workers[(me + k) % workers.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.tasks.empty()) continue;
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool runOne(size_t me) {
+        if (queued.load(std::memory_order_relaxed) == 0) return false;
+        Task task;
+        if (!popOwn(me, task) && !steal(me, task)) return false;
+        queued--;
+        task.fn();
+        task.group->pending--;
+        return true;
+    }
+
+    void workerLoop(size_t index) {
+        currentPool = this;
+        currentWorker = index;
+        while (true) {
+            if (runOne(index)) continue;
+            std::unique_lock<std::mutex> guard(sleepLock);
+            sleepers++;
+            wake.wait(guard, [this] { return stopping || queued > 0; });
+            sleepers--;
+            if (stopping) return;
+        }
+    }
+
+    // queued is raised before sleepers is read, and a worker raises
+    // sleepers before it re-checks queued: one of the two sees the other
+    void signal(bool all) {
+        if (threads.empty() || sleepers.load() == 0) return;
+        { std::lock_guard<std::mutex> guard(sleepLock); }
+        if (all)
+            wake.notify_all();
+        else
+            wake.notify_one();
+    }
+
+public:
+    explicit WorkStealingPool(size_t threadCount) {
+        threadCount = std::max<size_t>(1, threadCount);
+        for (size_t i = 0; i < threadCount; i++) workers.push_back(std::make_unique<Worker>());
+        for (size_t i = 1; i < threadCount; i++) threads.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    // The calling thread's slot, 0 .. size() - 1 (0 outside the pool):
+    // lets tasks keep per-worker state without sharing it
+    size_t workerIndex() const {
+        return self();
+    }
+
+    void run(TaskGroup& group, std::function<void()> task) {
+        group.pending++;
+        Worker& w = *workers[self()];
+        {
+            std::lock_guard<std::mutex> guard(w.lock);
+            w.tasks.push_back({std::move(task), &group});
+        }
+        queued++;
+        signal(false);
+    }
+
+    void wait(TaskGroup& group) {
+        size_t me = self();
+        while (group.pending > 0) {
+            if (!runOne(me)) std::this_thread::yield();
+        }
+    }
+
+    // Runs task(0) .. task(count - 1) on the pool, returns when all are done
+    void runAll(size_t count, const std::function<void(size_t)>& task) {
+        TaskGroup group;
+        group.pending += static_cast<long>(count);
+        Worker& w = *workers[self()];
+        {
+            std::lock_guard<std::mutex> guard(w.lock);
+            for (size_t i = 0; i < count; i++) {
+                w.tasks.push_back({[&task, i] { task(i); }, &group});
+            }
+        }
+        queued += static_cast<long>(count);
+        signal(true);
+        wait(group);
+    }
+};
+
+#endif // WORK_STEALING_POOL_H
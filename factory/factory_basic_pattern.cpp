@@ -1,6 +1,350 @@
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+
+#include "../bench/AllocCounter.h"
 using namespace std;
 
+/*
+===========================================================
+              POOLED CREATION (hot order path)
+===========================================================
+- The factories below also have a create*(ProductType) path:
+  no string compares, no heap allocation per product
+- ProductType = the product name interned once, at the edge
+  (internProductType: perfect hash + one compare)
+- Products are built in fixed-size blocks from ProductArena:
+  each thread keeps its own free list, so steady-state
+  create / destroy touches no lock and no malloc
+- Pooled<T> = unique_ptr whose deleter hands the block back
+*/
+
+enum ProductType : uint8_t {
+    BASIC,
+    STANDARD,
+    PREMIUM,
+    PRODUCT_TYPES,
+    INVALID_TYPE = PRODUCT_TYPES
+};
+
+struct ProductTypeName {
+    string_view name;
+    ProductType type;
+};
+
+inline constexpr ProductTypeName PRODUCT_TYPE_NAMES[PRODUCT_TYPES] = {
+    {"Basic", BASIC},
+    {"Standard", STANDARD},
+    {"Premium", PREMIUM},
+};
+
+// Perfect hash over the names above (checked at compile time)
+constexpr size_t TYPE_TABLE_SIZE = 8;
+
+constexpr size_t typeSlot(string_view name) {
+    return (name.size() * 3 + (unsigned char)name[0]) & (TYPE_TABLE_SIZE - 1);
+}
+
+struct ProductTypeTable {
+    ProductType slots[TYPE_TABLE_SIZE] = {};
+    bool perfect = true;
+
+    constexpr ProductTypeTable() {
+        for (size_t i = 0; i < TYPE_TABLE_SIZE; i++) slots[i] = INVALID_TYPE;
+        for (const ProductTypeName& entry : PRODUCT_TYPE_NAMES) {
+            size_t slot = typeSlot(entry.name);
+            if (slots[slot] != INVALID_TYPE) perfect = false;
+            slots[slot] = entry.type;
+        }
+    }
+};
+
+inline constexpr ProductTypeTable PRODUCT_TYPE_TABLE;
+static_assert(PRODUCT_TYPE_TABLE.perfect, "typeSlot() collides: adjust the hash for the new names");
+
+// INVALID_TYPE for anything that is not a product name
+constexpr ProductType internProductType(string_view name) {
+    if (name.empty()) return INVALID_TYPE;
+    ProductType type = PRODUCT_TYPE_TABLE.slots[typeSlot(name)];
+    if (type == INVALID_TYPE || PRODUCT_TYPE_NAMES[type].name != name) return INVALID_TYPE;
+    return type;
+}
+
+/*
+ Fixed-block arena shared by every product type
+ - blocks come from 64 KiB chunks that are never handed back
+   to the heap (freed blocks are reused instead)
+ - per-thread cache: allocate / deallocate are a free-list
+   pop / push on the calling thread
+ - a cache that runs dry takes a batch from the shared depot
+   (or carves a new chunk); one that grows past MAX_CACHED, or
+   whose thread exits, gives a batch back. So a product may be
+   destroyed on a different thread than the one that made it
+*/
+template <class Base>
+struct PoolDeleter;
+
+template <class Base>
+using Pooled = unique_ptr<Base, PoolDeleter<Base>>;
+
+class ProductArena {
+public:
+    static const size_t BLOCK_SIZE = 32;
+    static const size_t BLOCK_ALIGN = alignof(max_align_t);
+    static const size_t BATCH_BLOCKS = 2048;            // one chunk
+    static const size_t MAX_CACHED = 4 * BATCH_BLOCKS;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Batch {
+        FreeBlock* head;
+        size_t count;
+    };
+
+    // Shared slow path. Deliberately never destroyed: pooled
+    // products that die during static destruction stay valid.
+    struct Depot {
+        mutex lock;
+        vector<Batch> batches;
+        vector<unsigned char*> chunks;
+
+        Batch take() {
+            lock_guard<mutex> guard(lock);
+            if (!batches.empty()) {
+                Batch batch = batches.back();
+                batches.pop_back();
+                return batch;
+            }
+            auto* chunk = static_cast<unsigned char*>(
+                ::operator new(BATCH_BLOCKS * BLOCK_SIZE, align_val_t(BLOCK_ALIGN)));
+            chunks.push_back(chunk);
+            FreeBlock* head = nullptr;
+            for (size_t i = BATCH_BLOCKS; i-- > 0;) {
+                auto* block = reinterpret_cast<FreeBlock*>(chunk + i * BLOCK_SIZE);
+                block->next = head;
+                head = block;
+            }
+            return {head, BATCH_BLOCKS};
+        }
+
+        void give(Batch batch) {
+            lock_guard<mutex> guard(lock);
+            batches.push_back(batch);
+        }
+
+        size_t chunkCount() {
+            lock_guard<mutex> guard(lock);
+            return chunks.size();
+        }
+    };
+
+    struct Cache {
+        FreeBlock* head = nullptr;
+        size_t count = 0;
+
+        ~Cache() {
+            if (head) depot().give({head, count});
+        }
+    };
+
+    static Depot& depot() {
+        static Depot* shared = new Depot();
+        return *shared;
+    }
+
+    static Cache& local() {
+        thread_local Cache cache;
+        return cache;
+    }
+
+public:
+    static void* allocate() {
+        Cache& cache = local();
+        if (!cache.head) {
+            Batch batch = depot().take();
+            cache.head = batch.head;
+            cache.count = batch.count;
+        }
+        FreeBlock* block = cache.head;
+        cache.head = block->next;
+        cache.count--;
+        return block;
+    }
+
+    static void deallocate(void* p) {
+        Cache& cache = local();
+        auto* block = static_cast<FreeBlock*>(p);
+        block->next = cache.head;
+        cache.head = block;
+        if (++cache.count <= MAX_CACHED) return;
+
+        // Hoarding (this thread frees what others create): return a batch
+        FreeBlock* tail = cache.head;
+        for (size_t i = 1; i < BATCH_BLOCKS; i++) tail = tail->next;
+        Batch batch{cache.head, BATCH_BLOCKS};
+        cache.head = tail->next;
+        tail->next = nullptr;
+        cache.count -= BATCH_BLOCKS;
+        depot().give(batch);
+    }
+
+    static size_t chunkCount() {
+        return depot().chunkCount();
+    }
+
+    template <class Base, class T>
+    static Pooled<Base> make();
+};
+
+// Runs the destructor, then returns the block. A final type is
+// the whole object: no vtable lookups at all.
+template <class Base>
+struct PoolDeleter {
+    void operator()(Base* product) const {
+        void* block;
+        if constexpr (is_final_v<Base>)
+            block = product;
+        else
+            block = dynamic_cast<void*>(product);   // most-derived start
+        product->~Base();
+        ProductArena::deallocate(block);
+    }
+};
+
+template <class Base, class T>
+Pooled<Base> ProductArena::make() {
+    static_assert(sizeof(T) <= BLOCK_SIZE && alignof(T) <= BLOCK_ALIGN, "product does not fit an arena block");
+    void* block = allocate();
+    try {
+        return Pooled<Base>(new (block) T());
+    } catch (...) {
+        deallocate(block);
+        throw;
+    }
+}
+
+/*
+===========================================================
+            COMPILE-TIME PRODUCT REGISTRY
+===========================================================
+- Every concrete product registers itself by declaring its key:
+      static constexpr ProductType PRODUCT_TYPE = PREMIUM;
+- A factory's product line is just the list of its products:
+      using WheatBurgers = ProductLine<Burger, BasicWheatBurger, ...>;
+- The line builds its lookup table at compile time from those
+  keys. A missing or duplicate key does not compile, and the
+  table is constant-initialized (nothing runs at startup)
+- Runtime type  -> create(type): one table load + indirect call
+- Static type   -> create<T>() / create<PREMIUM>(): a direct,
+  devirtualized construction (products are final)
+- Adding a product = one class + one entry in its line;
+  no factory if-chains to edit
+*/
+template <class Base>
+using ProductMaker = Pooled<Base> (*)();
+
+template <class Base>
+using HeapMaker = Base* (*)();
+
+template <class Base, class T>
+Base* makeOnHeap() {
+    return new T();
+}
+
+template <class Base, class... Products>
+struct ProductTable {
+    ProductMaker<Base> pooled[PRODUCT_TYPES] = {};
+    HeapMaker<Base> heap[PRODUCT_TYPES] = {};
+    bool filled[PRODUCT_TYPES] = {};
+    bool complete = true;
+
+    constexpr ProductTable() {
+        (add(Products::PRODUCT_TYPE, &ProductArena::make<Base, Products>, &makeOnHeap<Base, Products>), ...);
+        for (bool slot : filled)
+            if (!slot) complete = false;
+    }
+
+    constexpr void add(ProductType type, ProductMaker<Base> pooledMaker, HeapMaker<Base> heapMaker) {
+        if (filled[type]) complete = false;         // duplicate key
+        filled[type] = true;
+        pooled[type] = pooledMaker;
+        heap[type] = heapMaker;
+    }
+};
+
+// Picks the product of a line registered under Type
+template <bool Match, ProductType Type, class First, class... Rest>
+struct ProductSearch {
+    using type = First;
+};
+
+template <ProductType Type, class First, class Next, class... Rest>
+struct ProductSearch<false, Type, First, Next, Rest...>
+    : ProductSearch<Next::PRODUCT_TYPE == Type, Type, Next, Rest...> {};
+
+template <ProductType Type, class Last>
+struct ProductSearch<false, Type, Last> {
+    static_assert(Last::PRODUCT_TYPE == Type, "no product registered for this ProductType");
+};
+
+template <ProductType Type, class First, class... Rest>
+struct ProductOfType : ProductSearch<First::PRODUCT_TYPE == Type, Type, First, Rest...> {};
+
+template <class Base, class... Products>
+class ProductLine {
+    static_assert((is_base_of_v<Base, Products> && ...), "a product line holds one product family");
+    static_assert(sizeof...(Products) == PRODUCT_TYPES, "a product line covers every ProductType once");
+
+    static constexpr ProductTable<Base, Products...> table{};
+    static_assert(table.complete, "two products of this line share a ProductType");
+
+public:
+    template <ProductType Type>
+    using Product = typename ProductOfType<Type, Products...>::type;
+
+    static Pooled<Base> create(ProductType type) {
+        if (type >= PRODUCT_TYPES) {
+            cout << Base::INVALID_TYPE_MESSAGE << endl;
+            return nullptr;
+        }
+        return table.pooled[type]();
+    }
+
+    // Legacy API: caller owns a heap object
+    static Base* createOnHeap(ProductType type) {
+        if (type >= PRODUCT_TYPES) {
+            cout << Base::INVALID_TYPE_MESSAGE << endl;
+            return nullptr;
+        }
+        return table.heap[type]();
+    }
+
+    template <class T>
+    static Pooled<T> create() {
+        static_assert(((is_same_v<T, Products>) || ...), "T is not part of this product line");
+        return ProductArena::make<T, T>();
+    }
+
+    template <ProductType Type>
+    static Pooled<Product<Type>> create() {
+        return create<Product<Type>>();
+    }
+};
+
 /*
 ===========================================================
                 SIMPLE FACTORY DESIGN PATTERN
@@ -11,46 +355,61 @@ using namespace std;
 */
 
 // Abstract Product
+class Burger;
+using BurgerPtr = Pooled<Burger>;
+
 class Burger {
 public:
+    static constexpr const char* INVALID_TYPE_MESSAGE = "Invalid Burger Type";
+
     virtual void prepare() = 0;   // Common interface
     virtual ~Burger() {}          // Virtual destructor
 };
 
 // Concrete Products
-class BasicBurger : public Burger {
+class BasicBurger final : public Burger {
 public:
+    static constexpr ProductType PRODUCT_TYPE = BASIC;
+
     void prepare() override {
         cout << "This is simple burger" << endl;
     }
 };
 
-class StandardBurger : public Burger {
+class StandardBurger final : public Burger {
 public:
+    static constexpr ProductType PRODUCT_TYPE = STANDARD;
+
     void prepare() override {
         cout << "This is standard burger" << endl;
     }
 };
 
-class PremiumBurger : public Burger {
+class PremiumBurger final : public Burger {
 public:
+    static constexpr ProductType PRODUCT_TYPE = PREMIUM;
+
     void prepare() override {
         cout << "This is premium burger" << endl;
     }
 };
 
 // Simple Factory
+using SimpleBurgers = ProductLine<Burger, BasicBurger, StandardBurger, PremiumBurger>;
+
 class BurgerFactory {
 public:
-    // Creates burger object based on type
+    // Creates burger object based on type (a table, not an if-chain)
     virtual Burger* burgerFactory(string &type) {
-        if (type == "Basic")    return new BasicBurger();
-        if (type == "Standard") return new StandardBurger();
-        if (type == "Premium")  return new PremiumBurger();
+        return SimpleBurgers::createOnHeap(internProductType(type));
+    }
 
-        cout << "Invalid Burger Type" << endl;
-        return nullptr;
+    // Hot path: interned type, pooled product
+    virtual BurgerPtr createBurger(ProductType type) {
+        return SimpleBurgers::create(type);
     }
+
+    virtual ~BurgerFactory() {}
 };
 
 /*
@@ -62,22 +421,28 @@ public:
 */
 
 // Wheat burger variants
-class BasicWheatBurger : public Burger {
+class BasicWheatBurger final : public Burger {
 public:
+    static constexpr ProductType PRODUCT_TYPE = BASIC;
+
     void prepare() override {
         cout << "This is simple wheat burger" << endl;
     }
 };
 
-class StandardWheatBurger : public Burger {
+class StandardWheatBurger final : public Burger {
 public:
+    static constexpr ProductType PRODUCT_TYPE = STANDARD;
+
     void prepare() override {
         cout << "This is standard wheat burger" << endl;
     }
 };
 
-class PremiumWheatBurger : public Burger {
+class PremiumWheatBurger final : public Burger {
 public:
+    static constexpr ProductType PRODUCT_TYPE = PREMIUM;
+
     void prepare() override {
         cout << "This is premium wheat burger" << endl;
     }
@@ -87,25 +452,25 @@ public:
 class SinghBurgerFactory : public BurgerFactory {
 public:
     Burger* burgerFactory(string &type) override {
-        if (type == "Basic")    return new BasicBurger();
-        if (type == "Standard") return new StandardBurger();
-        if (type == "Premium")  return new PremiumBurger();
+        return SimpleBurgers::createOnHeap(internProductType(type));
+    }
 
-        cout << "Invalid Burger Type" << endl;
-        return nullptr;
+    BurgerPtr createBurger(ProductType type) override {
+        return SimpleBurgers::create(type);
     }
 };
 
 // Concrete Factory 2
+using WheatBurgers = ProductLine<Burger, BasicWheatBurger, StandardWheatBurger, PremiumWheatBurger>;
+
 class KingBurgerFactory : public BurgerFactory {
 public:
     Burger* burgerFactory(string &type) override {
-        if (type == "Basic")    return new BasicWheatBurger();
-        if (type == "Standard") return new StandardWheatBurger();
-        if (type == "Premium")  return new PremiumWheatBurger();
+        return WheatBurgers::createOnHeap(internProductType(type));
+    }
 
-        cout << "Invalid Burger Type" << endl;
-        return nullptr;
+    BurgerPtr createBurger(ProductType type) override {
+        return WheatBurgers::create(type);
     }
 };
 
@@ -119,51 +484,68 @@ public:
 */
 
 // Abstract Product 2
+class GarlicBread;
+using GarlicBreadPtr = Pooled<GarlicBread>;
+
 class GarlicBread {
 public:
+    static constexpr const char* INVALID_TYPE_MESSAGE = "Invalid Garlic-Bread Type";
+
     virtual void prepare() = 0;
     virtual ~GarlicBread() {}
 };
 
 // Garlic bread variants
-class BasicGarlicBread : public GarlicBread {
+class BasicGarlicBread final : public GarlicBread {
 public:
+    static constexpr ProductType PRODUCT_TYPE = BASIC;
+
     void prepare() override {
         cout << "This is basic garlic-bread" << endl;
     }
 };
 
-class CheeseGarlicBread : public GarlicBread {
+class CheeseGarlicBread final : public GarlicBread {
 public:
+    static constexpr ProductType PRODUCT_TYPE = STANDARD;
+
     void prepare() override {
         cout << "This is cheese garlic-bread" << endl;
     }
 };
 
-class StuffedCheeseGarlicBread : public GarlicBread {
+class StuffedCheeseGarlicBread final : public GarlicBread {
 public:
+    static constexpr ProductType PRODUCT_TYPE = PREMIUM;
+
     void prepare() override {
         cout << "This is stuffed cheese garlic-bread" << endl;
     }
 };
 
 // Wheat garlic bread variants
-class BasicWheatGarlicBread : public GarlicBread {
+class BasicWheatGarlicBread final : public GarlicBread {
 public:
+    static constexpr ProductType PRODUCT_TYPE = BASIC;
+
     void prepare() override {
         cout << "This is basic wheat garlic-bread" << endl;
     }
 };
 
-class CheeseWheatGarlicBread : public GarlicBread {
+class CheeseWheatGarlicBread final : public GarlicBread {
 public:
+    static constexpr ProductType PRODUCT_TYPE = STANDARD;
+
     void prepare() override {
         cout << "This is cheese wheat garlic-bread" << endl;
     }
 };
 
-class StuffedCheeseWheatGarlicBread : public GarlicBread {
+class StuffedCheeseWheatGarlicBread final : public GarlicBread {
 public:
+    static constexpr ProductType PRODUCT_TYPE = PREMIUM;
+
     void prepare() override {
         cout << "This is stuffed cheese wheat garlic-bread" << endl;
     }
@@ -174,10 +556,87 @@ class MealFactory {
 public:
     virtual Burger* burgerFactory(string &type) = 0;
     virtual GarlicBread* garlicBreadFactory(string &type) = 0;
+
+    // Hot path: interned type, pooled products
+    virtual BurgerPtr createBurger(ProductType type) = 0;
+    virtual GarlicBreadPtr createGarlicBread(ProductType type) = 0;
+
+    virtual ~MealFactory() {}
 };
 
 // Concrete Abstract Factory 1
+using GarlicBreads = ProductLine<GarlicBread, BasicGarlicBread, CheeseGarlicBread, StuffedCheeseGarlicBread>;
+
 class SinghMealFactory : public MealFactory {
+public:
+    Burger* burgerFactory(string &type) override {
+        return SimpleBurgers::createOnHeap(internProductType(type));
+    }
+
+    GarlicBread* garlicBreadFactory(string &type) override {
+        return GarlicBreads::createOnHeap(internProductType(type));
+    }
+
+    BurgerPtr createBurger(ProductType type) override {
+        return SimpleBurgers::create(type);
+    }
+
+    GarlicBreadPtr createGarlicBread(ProductType type) override {
+        return GarlicBreads::create(type);
+    }
+};
+
+// Concrete Abstract Factory 2
+using WheatGarlicBreads = ProductLine<GarlicBread, BasicWheatGarlicBread, CheeseWheatGarlicBread, StuffedCheeseWheatGarlicBread>;
+
+class KingMealFactory : public MealFactory {
+public:
+    Burger* burgerFactory(string &type) override {
+        return WheatBurgers::createOnHeap(internProductType(type));
+    }
+
+    GarlicBread* garlicBreadFactory(string &type) override {
+        return WheatGarlicBreads::createOnHeap(internProductType(type));
+    }
+
+    BurgerPtr createBurger(ProductType type) override {
+        return WheatBurgers::create(type);
+    }
+
+    GarlicBreadPtr createGarlicBread(ProductType type) override {
+        return WheatGarlicBreads::create(type);
+    }
+};
+
+/*
+===========================================================
+                      BENCHMARK
+===========================================================
+RUN:
+- ./factory          -> demo
+- ./factory --bench  -> orders/sec and heap allocations per order
+                        (burger + garlic bread), string if-chain +
+                        new/delete vs interned type + pooled
+                        products, for 1..N threads; then ns per
+                        product for each creation path down to
+                        the static create<T>()
+
+Each thread keeps IN_FLIGHT orders alive (a kitchen queue) and
+replaces the oldest one per new order, so blocks really cycle.
+"allocs" counts every operator new (bench/AllocCounter.h),
+arena chunk refills included; the chunk total is also printed
+at the end.
+*/
+
+// The old string if-chain factories, kept only as the baseline to beat
+class IfChainMealFactory {
+public:
+    virtual Burger* burgerFactory(string &type) = 0;
+    virtual GarlicBread* garlicBreadFactory(string &type) = 0;
+    virtual ~IfChainMealFactory() {}
+};
+
+class IfChainSinghMealFactory : public IfChainMealFactory {
 public:
     Burger* burgerFactory(string &type) override {
         if (type == "Basic")    return new BasicBurger();
@@ -198,8 +657,7 @@ public:
     }
 };
 
-// Concrete Abstract Factory 2
-class KingMealFactory : public MealFactory {
+class IfChainKingMealFactory : public IfChainMealFactory {
 public:
     Burger* burgerFactory(string &type) override {
         if (type == "Basic")    return new BasicWheatBurger();
@@ -220,7 +678,148 @@ public:
     }
 };
 
-int main() {
+/*
+ns per burger for each creation path (1 thread, same in-flight
+ring). Types cycle Basic/Standard/Premium; the static path knows
+each one at compile time.
+*/
+void runCreationPathBenchmark() {
+    const int PRODUCTS = 6000000;
+    const size_t IN_FLIGHT = 1024;
+    string names[] = {"Basic", "Standard", "Premium"};
+
+    auto measure = [&](const char* label, auto body) {
+        size_t allocsBefore = AllocCounter::count();
+        auto start = chrono::steady_clock::now();
+        body();
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / PRODUCTS;
+        cout << label << "\t" << ns << "\t" << (double)(AllocCounter::count() - allocsBefore) / PRODUCTS << "\n";
+    };
+
+    cout << "\n==== CREATION PATH (ns per burger, 1 thread) ====\n";
+    cout << "path\tns\tallocs\n";
+
+    IfChainKingMealFactory ifChain;
+    measure("if-chain + new", [&]() {
+        vector<Burger*> ring(IN_FLIGHT, nullptr);
+        for (int i = 0; i < PRODUCTS; i++) {
+            Burger*& slot = ring[i % IN_FLIGHT];
+            delete slot;
+            slot = ifChain.burgerFactory(names[i % 3]);
+        }
+        for (Burger* b : ring) delete b;
+    });
+    measure("table + new", [&]() {
+        vector<Burger*> ring(IN_FLIGHT, nullptr);
+        for (int i = 0; i < PRODUCTS; i++) {
+            Burger*& slot = ring[i % IN_FLIGHT];
+            delete slot;
+            slot = WheatBurgers::createOnHeap(internProductType(names[i % 3]));
+        }
+        for (Burger* b : ring) delete b;
+    });
+    measure("table + pool", [&]() {
+        vector<BurgerPtr> ring(IN_FLIGHT);
+        for (int i = 0; i < PRODUCTS; i++)
+            ring[i % IN_FLIGHT] = WheatBurgers::create(internProductType(names[i % 3]));
+    });
+    measure("create<T>() + pool", [&]() {
+        vector<Pooled<BasicWheatBurger>> basic(IN_FLIGHT / 3 + 1);
+        vector<Pooled<StandardWheatBurger>> standard(IN_FLIGHT / 3 + 1);
+        vector<Pooled<PremiumWheatBurger>> premium(IN_FLIGHT / 3 + 1);
+        for (int i = 0; i < PRODUCTS; i += 3) {
+            size_t slot = (i / 3) % basic.size();
+            basic[slot] = WheatBurgers::create<BASIC>();
+            standard[slot] = WheatBurgers::create<STANDARD>();
+            premium[slot] = WheatBurgers::create<PREMIUM>();
+        }
+    });
+}
+
+void runFactoryBenchmark() {
+    const int ORDERS_PER_THREAD = 2000000;
+    const size_t IN_FLIGHT = 1024;
+    const size_t STREAM = 4096;
+
+    // Order types exactly as they arrive: strings
+    const string names[] = {"Basic", "Standard", "Premium"};
+    vector<string> stream;
+    mt19937 rng(42);
+    for (size_t i = 0; i < STREAM; i++) stream.push_back(names[rng() % 3]);
+
+    IfChainSinghMealFactory ifChainSingh;
+    IfChainKingMealFactory ifChainKing;
+    IfChainMealFactory* ifChainMeals[2] = {&ifChainSingh, &ifChainKing};
+    SinghMealFactory singh;
+    KingMealFactory king;
+    MealFactory* meals[2] = {&singh, &king};
+
+    auto legacyOrders = [&](int seed) {
+        vector<pair<Burger*, GarlicBread*>> kitchen(IN_FLIGHT, {nullptr, nullptr});
+        for (int i = 0; i < ORDERS_PER_THREAD; i++) {
+            string& type = stream[(i + seed) % STREAM];
+            IfChainMealFactory* meal = ifChainMeals[i & 1];
+            auto& slot = kitchen[i % IN_FLIGHT];
+            delete slot.first;
+            delete slot.second;
+            slot.first = meal->burgerFactory(type);
+            slot.second = meal->garlicBreadFactory(type);
+        }
+        for (auto& slot : kitchen) {
+            delete slot.first;
+            delete slot.second;
+        }
+    };
+
+    auto pooledOrders = [&](int seed) {
+        vector<pair<BurgerPtr, GarlicBreadPtr>> kitchen(IN_FLIGHT);
+        for (int i = 0; i < ORDERS_PER_THREAD; i++) {
+            ProductType type = internProductType(stream[(i + seed) % STREAM]);
+            MealFactory* meal = meals[i & 1];
+            auto& slot = kitchen[i % IN_FLIGHT];
+            slot.first = meal->createBurger(type);
+            slot.second = meal->createGarlicBread(type);
+        }
+    };
+
+    int maxThreads = max(4u, thread::hardware_concurrency());
+    vector<int> threadCounts;
+    for (int n = 1; n <= maxThreads; n *= 2) threadCounts.push_back(n);
+    if (threadCounts.back() != maxThreads) threadCounts.push_back(maxThreads);
+
+    auto measure = [&](int threads, auto orders) {
+        size_t allocsBefore = AllocCounter::count();
+        auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < threads; t++) workers.emplace_back(orders, t * 131);
+        for (auto& w : workers) w.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double total = (double)threads * ORDERS_PER_THREAD;
+        cout << "\t" << (uint64_t)(total / seconds) << "\t"
+             << (double)(AllocCounter::count() - allocsBefore) / total;
+    };
+
+    cout << "==== ORDER CREATION (burger + garlic bread per order, "
+         << IN_FLIGHT << " in flight per thread) ====\n";
+    cout << "threads\tif-chain+new orders/sec\tallocs/order\tpooled orders/sec\tallocs/order\n";
+    for (int threads : threadCounts) {
+        cout << threads;
+        measure(threads, legacyOrders);
+        measure(threads, pooledOrders);
+        cout << "\n";
+    }
+    cout << "arena chunks: " << ProductArena::chunkCount() << " x "
+         << ProductArena::BATCH_BLOCKS * ProductArena::BLOCK_SIZE / 1024 << " KiB"
+         << " (hardware threads: " << thread::hardware_concurrency() << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runFactoryBenchmark();
+        runCreationPathBenchmark();
+        return 0;
+    }
+
     string type = "Standard";
 
     // SIMPLE FACTORY
@@ -260,4 +859,26 @@ int main() {
     GarlicBread* kingGarlicBread = kingMealFactory->garlicBreadFactory(type);
     kingMealBurger->prepare();
     kingGarlicBread->prepare();
-}
\ No newline at end of file
+    cout << endl;
+
+    // POOLED CREATION
+    cout << "CREATING POOLED PRODUCTS (interned type, arena blocks):\n";
+    ProductType pooledType = internProductType(type);
+    cout<<"King Meal Factory-->"<<endl;
+    BurgerPtr pooledBurger = kingMealFactory->createBurger(pooledType);
+    GarlicBreadPtr pooledGarlicBread = kingMealFactory->createGarlicBread(pooledType);
+    pooledBurger->prepare();
+    pooledGarlicBread->prepare();
+
+    cout<<"Unknown type \"Deluxe\"-->"<<endl;
+    BurgerPtr unknownBurger = singhMealFactory->createBurger(internProductType("Deluxe"));
+    cout << endl;
+
+    // COMPILE-TIME REGISTRY: type known statically, no dispatch at all
+    cout << "CREATING FROM THE COMPILE-TIME REGISTRY:\n";
+    Pooled<WheatBurgers::Product<PREMIUM>> premiumWheat = WheatBurgers::create<PREMIUM>();
+    Pooled<CheeseGarlicBread> cheeseBread = GarlicBreads::create<CheeseGarlicBread>();
+    premiumWheat->prepare();
+    cheeseBread->prepare();
+    return 0;
+}
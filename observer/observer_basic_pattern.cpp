@@ -11,6 +11,14 @@
  2) Pure Observer (no channel storage)
  3) Managed Subscriber (multiple channels)
 
+ Plus the storage / delivery side of the Subject:
+ - SubscriberRegistry: O(1) subscribe / unsubscribe, stable iteration
+ - COALESCED mode: a burst of uploads becomes one notification
+ - Parallel delivery: chunks of subscribers on a WorkStealingPool, all
+   reading one immutable VideoEvent (no per-subscriber copies)
+ - SubscriberPool + Subscription: generational handles and RAII
+   tokens, so a deleted subscriber is skipped instead of dangling
+
  Teaching Rule:
  "Context passing solves the 'who notified me?' problem."
 ********************************************************/
@@ -19,6 +27,17 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <atomic>
+
+#include "../common/SubscriberPool.h"
+#include "../common/WorkStealingPool.h"
 using namespace std;
 
 /* Forward declaration */
@@ -47,41 +66,421 @@ public:
     virtual ~Ichannel() {}
 };
 
+/* ===================== SUBSCRIBER LIFETIMES ===================== */
+
+/*
+ Generational handles (common/SubscriberPool.h, shared with Pub-Sub)
+ - a raw Isubscriber* in a registry dangles once the subscriber is
+   deleted; weak_ptr::lock() fixes that with an atomic inc + dec
+   per update()
+ - SubscriberPool<T> keeps subscribers in chunked slots that are
+   never freed while the pool lives; each slot has a generation
+ - destroy() bumps the generation, so every handle issued before
+   it fails alive(): one integer compare, no refcount
+ - a bare Isubscriber* becomes an "unmanaged" handle whose
+   generation never changes (old behaviour, caller owns lifetime)
+ - no grace period here: destroy() must not run during a
+   parallel notify, and the pool must outlive every channel that
+   still lists one of its subscribers
+*/
+typedef GenerationHandle<Isubscriber> SubscriberHandle;
+
+/* ===================== SUBSCRIBER REGISTRY ===================== */
+
+/*
+ Slot map of subscribers
+ - slots[]      : subscriber per slot, nullptr = free slot
+ - slotOf       : subscriber -> slot, O(1) duplicate check / removal
+ - freeSlots    : reused by the next subscribe (no shifting, ever)
+
+ Why not vector + find:
+ - subscribe   = O(n) duplicate scan
+ - unSubscribe = O(n) find + O(n) shift on erase
+ - with millions of subscribers that is quadratic churn
+
+ Iteration walks slots[] in order. A subscriber never moves while
+ it is subscribed, so iteration is stable, and an update() that
+ unsubscribes itself (or anyone else) is safe: the slot just reads
+ nullptr. Free slots are compacted away (order kept) once they are
+ more than half the array and nobody is iterating.
+
+ Pooled subscribers (added by handle) also get a liveness[] entry.
+ While there are none, walks read slots[] only, exactly as before;
+ otherwise a dead entry is skipped and dropped by the next
+ sequential walk, or by unpin() after a parallel one.
+*/
+class SubscriberRegistry {
+private:
+    struct Liveness {
+        const SubscriberSlot* current;
+        uint32_t expected;
+
+        // relaxed: destroy() never runs during a notify here
+        bool alive() const {
+            return current->generation.load(memory_order_relaxed) == expected;
+        }
+    };
+
+    vector<Isubscriber*> slots;
+    vector<Liveness> liveness;          // parallel to slots[]
+    vector<uint32_t> freeSlots;
+    unordered_map<Isubscriber*, uint32_t> slotOf;
+    size_t managed = 0;                 // live slots added by handle
+    int iterating = 0;
+    atomic<bool> sawExpired{false};     // set by parallel walkers only
+
+    bool isManaged(uint32_t slot) const {
+        return liveness[slot].current != SubscriberSlot::unmanaged();
+    }
+
+    void compactIfSparse() {
+        if (iterating > 0 || freeSlots.size() * 2 <= slots.size())
+            return;
+        size_t write = 0;
+        for (size_t read = 0; read < slots.size(); read++) {
+            Isubscriber* sub = slots[read];
+            if (!sub) continue;
+            slotOf[sub] = (uint32_t)write;
+            liveness[write] = liveness[read];
+            slots[write++] = sub;
+        }
+        slots.resize(write);
+        liveness.resize(write);
+        freeSlots.clear();
+    }
+
+    void release(uint32_t slot) {
+        if (isManaged(slot)) managed--;
+        slots[slot] = nullptr;
+        freeSlots.push_back(slot);
+    }
+
+    void pruneExpired() {
+        for (uint32_t i = 0; i < slots.size(); i++) {
+            if (slots[i] && !liveness[i].alive()) {
+                slotOf.erase(slots[i]);
+                release(i);
+            }
+        }
+    }
+
+    // The liveness check runs only if a pooled subscriber was present
+    // when the walk began (anyone added mid-walk lands past its end)
+    template <class Visit>
+    void walk(size_t begin, size_t end, Visit& visit, bool sequential) {
+        if (managed == 0) {
+            for (size_t i = begin; i < end; i++) {
+                Isubscriber* sub = slots[i];
+                if (sub) visit(sub);
+            }
+            return;
+        }
+        for (size_t i = begin; i < end; i++) {
+            Isubscriber* sub = slots[i];
+            if (!sub) continue;
+            if (liveness[i].alive()) {
+                visit(sub);
+            } else if (sequential) {
+                slotOf.erase(sub);
+                release((uint32_t)i);
+            } else {
+                sawExpired.store(true, memory_order_relaxed);
+            }
+        }
+    }
+
+public:
+    // false = already subscribed (a dead handle at the same address
+    // does not count: that memory now holds a new subscriber)
+    bool add(const SubscriberHandle& handle) {
+        auto inserted = slotOf.emplace(handle.target, 0);
+        if (!inserted.second) {
+            uint32_t stale = inserted.first->second;
+            if (liveness[stale].alive())
+                return false;
+            release(stale);
+        }
+
+        Liveness entry{handle.slot, handle.generation};
+        uint32_t slot;
+        if (!freeSlots.empty() && iterating == 0) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[slot] = handle.target;
+            liveness[slot] = entry;
+        } else {
+            // During an iteration: append, so the walk in progress
+            // never picks up a subscriber that joined mid-way
+            slot = (uint32_t)slots.size();
+            slots.push_back(handle.target);
+            liveness.push_back(entry);
+        }
+        if (isManaged(slot)) managed++;
+        inserted.first->second = slot;
+        return true;
+    }
+
+    bool add(Isubscriber* subscriber) {
+        return add(SubscriberHandle::unmanaged(subscriber));
+    }
+
+    // false = was not subscribed
+    bool remove(Isubscriber* subscriber) {
+        auto it = slotOf.find(subscriber);
+        if (it == slotOf.end())
+            return false;
+        release(it->second);
+        slotOf.erase(it);
+        compactIfSparse();
+        return true;
+    }
+
+    // Only that exact subscription: a stale handle never removes
+    // whoever took over the same address afterwards
+    bool remove(const SubscriberHandle& handle) {
+        auto it = slotOf.find(handle.target);
+        if (it == slotOf.end())
+            return false;
+        const Liveness& entry = liveness[it->second];
+        if (entry.current != handle.slot || entry.expected != handle.generation)
+            return false;
+        release(it->second);
+        slotOf.erase(it);
+        compactIfSparse();
+        return true;
+    }
+
+    bool contains(Isubscriber* subscriber) const {
+        return slotOf.count(subscriber) > 0;
+    }
+
+    size_t size() const {
+        return slotOf.size();
+    }
+
+    /*
+     Parallel walkers: pin() once, hand out [begin, end) slot ranges
+     (forEachInRange may run on several threads at once), unpin()
+     when every range is done. While pinned nobody may add / remove.
+    */
+    void pin() {
+        iterating++;
+    }
+
+    void unpin() {
+        iterating--;
+        if (iterating == 0 && sawExpired.load(memory_order_relaxed)) {
+            sawExpired.store(false, memory_order_relaxed);
+            pruneExpired();
+        }
+        compactIfSparse();
+    }
+
+    size_t slotCount() const {
+        return slots.size();
+    }
+
+    template <class Visit>
+    void forEachInRange(size_t begin, size_t end, Visit visit) {
+        walk(begin, end, visit, false);
+    }
+
+    template <class Visit>
+    void forEach(Visit visit) {
+        iterating++;
+        size_t end = slots.size();      // joined mid-way = next time
+        walk(0, end, visit, true);
+        iterating--;
+        compactIfSparse();
+    }
+};
+
+/* ===================== EVENT PAYLOAD ===================== */
+
+/*
+ One upload = one immutable VideoEvent, shared by every reader
+ - subscribers read it through getVideoData() (const reference,
+   no copy) or keep it past update() via getLatestEvent()
+ - an upload replaces the pointer; readers still holding the
+   old event keep a valid one (shared_ptr keeps it alive)
+*/
+struct VideoEvent {
+    const string title;
+    const uint64_t sequence;
+
+    VideoEvent(const string& title, uint64_t sequence) : title(title), sequence(sequence) {}
+};
+
 /* ===================== SUBJECT ===================== */
 
+/*
+ Parallel delivery (setParallelDelivery)
+ - subscribers are cut into chunks of slots, the chunks run on a
+   WorkStealingPool; below one chunk it stays on the calling thread
+ - every chunk reads the same immutable VideoEvent
+ - update() must then be thread-safe and must not subscribe /
+   unsubscribe on the channel that is notifying
+
+ Notify modes
+ - IMMEDIATE : every upload notifies every subscriber (classic)
+ - COALESCED : uploads only mark the channel dirty; deliverPending()
+               notifies once, with the LATEST video. A burst of N
+               uploads costs one round of update() calls, not N,
+               and nobody sees an already-outdated intermediate.
+*/
+enum NotifyMode {
+    IMMEDIATE,
+    COALESCED
+};
+
+/*
+ RAII subscription (Channel::subscribe(handle))
+ - move-only; unsubscribes on destruction or reset()
+ - harmless after the subscriber is destroyed (the entry is dead)
+ - must not outlive its Channel
+*/
+class Subscription {
+private:
+    Channel* channel = nullptr;
+    SubscriberHandle handle;
+
+public:
+    Subscription() = default;
+    Subscription(Channel* channel, const SubscriberHandle& handle)
+        : channel(channel), handle(handle) {}
+
+    Subscription(Subscription&& other) noexcept
+        : channel(other.channel), handle(other.handle) {
+        other.channel = nullptr;
+    }
+
+    Subscription& operator=(Subscription&& other) noexcept {
+        if (this != &other) {
+            reset();
+            channel = other.channel;
+            handle = other.handle;
+            other.channel = nullptr;
+        }
+        return *this;
+    }
+
+    Subscription(const Subscription&) = delete;
+    Subscription& operator=(const Subscription&) = delete;
+
+    ~Subscription() {
+        reset();
+    }
+
+    void reset();
+
+    bool active() const {
+        return channel != nullptr;
+    }
+};
+
 class Channel : public Ichannel {
 private:
-    vector<Isubscriber*> subscribers;
+    SubscriberRegistry subscribers;
     string name;
-    string latestVideo;
+    shared_ptr<const VideoEvent> latest;
+    uint64_t uploads = 0;
+    WorkStealingPool* pool = nullptr;
+    size_t chunkSize = 0;
+    NotifyMode mode = IMMEDIATE;
+    bool pending = false;
+    size_t coalescedUploads = 0;
 
 public:
-    Channel(const string& name) : name(name) {}
+    Channel(const string& name) : name(name), latest(make_shared<const VideoEvent>("", 0)) {}
 
     void subscribe(Isubscriber* subscriber) override {
-        if (find(subscribers.begin(), subscribers.end(), subscriber) == subscribers.end())
-            subscribers.push_back(subscriber);
+        subscribers.add(subscriber);
     }
 
     void unSubscribe(Isubscriber* subscriber) override {
-        auto it = find(subscribers.begin(), subscribers.end(), subscriber);
-        if (it != subscribers.end())
-            subscribers.erase(it);
+        subscribers.remove(subscriber);
+    }
+
+    // Pooled subscriber: the token unsubscribes when it goes away
+    Subscription subscribe(const SubscriberHandle& handle) {
+        if (!handle.alive() || !subscribers.add(handle))
+            return Subscription();
+        return Subscription(this, handle);
+    }
+
+    void unSubscribe(const SubscriberHandle& handle) {
+        subscribers.remove(handle);
     }
 
     void notifySubscribers() override {
-        for (Isubscriber* sub : subscribers)
-            sub->update(this);  // CONTEXT PASSING
+        size_t slots = subscribers.slotCount();
+        if (!pool || pool->size() == 1 || slots <= chunkSize) {
+            subscribers.forEach([this](Isubscriber* sub) {
+                sub->update(this);  // CONTEXT PASSING
+            });
+            return;
+        }
+
+        size_t chunks = (slots + chunkSize - 1) / chunkSize;
+        subscribers.pin();
+        pool->runAll(chunks, [this, slots](size_t chunk) {
+            size_t begin = chunk * chunkSize;
+            subscribers.forEachInRange(begin, min(begin + chunkSize, slots), [this](Isubscriber* sub) {
+                sub->update(this);
+            });
+        });
+        subscribers.unpin();
+    }
+
+    // nullptr = back to sequential delivery
+    void setParallelDelivery(WorkStealingPool* pool, size_t chunkSize = 4096) {
+        this->pool = pool;
+        this->chunkSize = max<size_t>(1, chunkSize);
     }
 
     void uploadVideo(const string& title) {
-        latestVideo = title;
+        latest = make_shared<const VideoEvent>(title, ++uploads);
         cout << "\n[" << name << "] Uploaded video: " << title << endl;
+        if (mode == IMMEDIATE) {
+            notifySubscribers();
+            return;
+        }
+        if (pending) coalescedUploads++;    // previous one was never seen
+        pending = true;
+    }
+
+    // Switching back to IMMEDIATE delivers anything still pending
+    void setNotifyMode(NotifyMode newMode) {
+        mode = newMode;
+        if (mode == IMMEDIATE)
+            deliverPending();
+    }
+
+    // COALESCED mode: one notification round for everything since the
+    // last call. Returns false when there was nothing to deliver.
+    bool deliverPending() {
+        if (!pending)
+            return false;
+        pending = false;
         notifySubscribers();
+        return true;
+    }
+
+    // Uploads that were replaced before anyone was notified of them
+    size_t getCoalescedUploads() const {
+        return coalescedUploads;
+    }
+
+    size_t getSubscriberCount() const {
+        return subscribers.size();
+    }
+
+    const string& getVideoData() const {
+        return latest->title;
     }
 
-    string getVideoData() const {
-        return latestVideo;
+    shared_ptr<const VideoEvent> getLatestEvent() const {
+        return latest;
     }
 
     string getName() const {
@@ -89,6 +488,11 @@ public:
     }
 };
 
+void Subscription::reset() {
+    if (channel) channel->unSubscribe(handle);
+    channel = nullptr;
+}
+
 /* ===================================================== */
 /* =============== VARIANT 1 ============================ */
 /* Single Channel Subscriber                             */
@@ -162,24 +566,25 @@ public:
 class ManagedSubscriber : public Isubscriber {
 private:
     string name;
-    vector<Channel*> channels;
+    unordered_set<Channel*> channels;   // O(1) add / remove, no scan
 
 public:
     ManagedSubscriber(const string& name) : name(name) {}
 
     void subscribeTo(Channel* channel) {
-        channels.push_back(channel);
+        channels.insert(channel);
         channel->subscribe(this);
     }
 
     void unSubscribeFrom(Channel* channel) {
-        channels.erase(
-            remove(channels.begin(), channels.end(), channel),
-            channels.end()
-        );
+        channels.erase(channel);
         channel->unSubscribe(this);
     }
 
+    size_t getChannelCount() const {
+        return channels.size();
+    }
+
     void update(Channel* channel) override {
         cout << "[Managed] Hey " << name
              << ", new video from "
@@ -190,9 +595,277 @@ public:
     }
 };
 
+/* ===================== BENCHMARK ===================== */
+
+/*
+ RUN:
+ - ./observer          -> demo
+ - ./observer --bench  -> subscribe / unsubscribe churn: vector+find vs
+                          SubscriberRegistry, an upload burst:
+                          IMMEDIATE vs COALESCED notification,
+                          payload: string copy vs shared view,
+                          notify latency vs subscribers x threads, and
+                          lifetime checks: raw vs handle vs weak_ptr
+*/
+
+// Silent subscriber: counts what it was told
+class CountingSubscriber : public Isubscriber {
+public:
+    size_t updates = 0;
+
+    void update(Channel*) override {
+        updates++;
+    }
+};
+
+// Reads the payload the old way: getVideoData() by value
+class CopyingSubscriber : public Isubscriber {
+public:
+    size_t bytes = 0;
+
+    void update(Channel* channel) override {
+        string video = channel->getVideoData();
+        bytes += video.size();
+    }
+};
+
+// Reads the shared, immutable payload in place
+class ViewSubscriber : public Isubscriber {
+public:
+    size_t bytes = 0;
+
+    void update(Channel* channel) override {
+        bytes += channel->getVideoData().size();
+    }
+};
+
+// Average time of one notifySubscribers() round, in microseconds
+double notifyMicros(Channel& channel, int rounds) {
+    channel.notifySubscribers();     // warm up
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) channel.notifySubscribers();
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / rounds;
+}
+
+// The old storage, kept only as the baseline to beat
+class VectorRegistry {
+private:
+    vector<Isubscriber*> subscribers;
+
+public:
+    void add(Isubscriber* subscriber) {
+        if (find(subscribers.begin(), subscribers.end(), subscriber) == subscribers.end())
+            subscribers.push_back(subscriber);
+    }
+
+    void remove(Isubscriber* subscriber) {
+        auto it = find(subscribers.begin(), subscribers.end(), subscriber);
+        if (it != subscribers.end())
+            subscribers.erase(it);
+    }
+};
+
+// Everyone subscribes, then everyone leaves in shuffled order
+template <class Registry>
+double churnNsPerOp(size_t count) {
+    vector<CountingSubscriber> subs(count);
+    vector<Isubscriber*> order;
+    for (auto& sub : subs) order.push_back(&sub);
+
+    Registry registry;
+    auto start = chrono::steady_clock::now();
+    for (Isubscriber* sub : order) registry.add(sub);
+    unsigned seed = 12345;
+    for (size_t i = count - 1; i > 0; i--) {
+        seed = seed * 1103515245u + 12345u;
+        swap(order[i], order[seed % (i + 1)]);
+    }
+    for (Isubscriber* sub : order) registry.remove(sub);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return ns / (2.0 * count);
+}
+
+void runObserverBenchmark() {
+    cout << "=== Subscribe + unsubscribe churn, ns per operation ===\n";
+    cout << "subscribers\tvector+find\tSubscriberRegistry\n";
+    for (size_t count : {1000, 10000, 50000}) {
+        cout << count << "\t" << churnNsPerOp<VectorRegistry>(count)
+             << "\t" << churnNsPerOp<SubscriberRegistry>(count) << "\n";
+    }
+    for (size_t count : {1000000, 4000000}) {
+        cout << count << "\t(skipped, quadratic)\t" << churnNsPerOp<SubscriberRegistry>(count) << "\n";
+    }
+
+    const size_t SUBSCRIBERS = 200000;
+    const int BURST = 100;
+    vector<CountingSubscriber> subs(SUBSCRIBERS);
+    Channel channel("Bench");
+    for (auto& sub : subs) channel.subscribe(&sub);
+
+    // uploadVideo() prints; keep the table readable
+    streambuf* saved = cout.rdbuf(nullptr);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < BURST; i++) channel.uploadVideo("Burst " + to_string(i));
+    double immediateMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    size_t immediateUpdates = 0;
+    for (auto& sub : subs) immediateUpdates += sub.updates, sub.updates = 0;
+
+    channel.setNotifyMode(COALESCED);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < BURST; i++) channel.uploadVideo("Burst " + to_string(i));
+    channel.deliverPending();
+    double coalescedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    size_t coalescedUpdates = 0;
+    for (auto& sub : subs) coalescedUpdates += sub.updates;
+
+    cout.rdbuf(saved);
+    cout.clear();
+
+    cout << "\n=== Burst of " << BURST << " uploads, " << SUBSCRIBERS << " subscribers ===\n";
+    cout << "mode\tupdate() calls\tms\n";
+    cout << "IMMEDIATE\t" << immediateUpdates << "\t" << immediateMs << "\n";
+    cout << "COALESCED\t" << coalescedUpdates << "\t" << coalescedMs
+         << "\t(" << channel.getCoalescedUploads() << " uploads never delivered)\n";
+
+    // Payload: one 60-byte title (past the small-string buffer)
+    const string title = "Parallel fan-out with a persistent work-stealing pool (4K)";
+    const size_t READERS = 1000000;
+    {
+        vector<CopyingSubscriber> copying(READERS);
+        vector<ViewSubscriber> viewing(READERS);
+        Channel copyChannel("Copy"), viewChannel("View");
+        for (auto& sub : copying) copyChannel.subscribe(&sub);
+        for (auto& sub : viewing) viewChannel.subscribe(&sub);
+
+        saved = cout.rdbuf(nullptr);
+        copyChannel.uploadVideo(title);
+        viewChannel.uploadVideo(title);
+        cout.rdbuf(saved);
+        cout.clear();
+
+        cout << "\n=== Payload per notify, " << READERS << " subscribers ===\n";
+        cout << "reader\tus per notify\n";
+        cout << "string copy\t" << notifyMicros(copyChannel, 5) << "\n";
+        cout << "shared view\t" << notifyMicros(viewChannel, 5) << "\n";
+    }
+
+    // Parallel fan-out: latency vs subscribers x threads
+    size_t cores = max<size_t>(1, thread::hardware_concurrency());
+    vector<size_t> threadCounts;
+    for (size_t t = 1; t <= max<size_t>(4, cores); t *= 2) threadCounts.push_back(t);
+    if (threadCounts.back() != cores && cores > 4) threadCounts.push_back(cores);
+
+    cout << "\n=== Parallel notify latency, us per notify (" << cores << " cores) ===\n";
+    cout << "subscribers";
+    for (size_t t : threadCounts) cout << "\t" << t << (t > cores ? " thr (over)" : " thr");
+    cout << "\n";
+
+    for (size_t count : {10000, 100000, 1000000}) {
+        vector<ViewSubscriber> readers(count);
+        Channel fanout("Fanout");
+        for (auto& sub : readers) fanout.subscribe(&sub);
+        saved = cout.rdbuf(nullptr);
+        fanout.uploadVideo(title);
+        cout.rdbuf(saved);
+        cout.clear();
+
+        cout << count;
+        for (size_t t : threadCounts) {
+            WorkStealingPool pool(t);
+            fanout.setParallelDelivery(&pool);
+            cout << "\t" << notifyMicros(fanout, count >= 1000000 ? 5 : 50);
+            fanout.setParallelDelivery(nullptr);
+        }
+        cout << "\n";
+
+        // the upload itself + (warm-up + rounds) per thread count
+        size_t expected = title.size() * (1 + threadCounts.size() * (count >= 1000000 ? 6 : 51));
+        for (auto& sub : readers) {
+            if (sub.bytes != expected) {
+                cerr << "FATAL: subscriber missed a parallel notification" << endl;
+                abort();
+            }
+        }
+    }
+}
+
+// Liveness per update(): raw pointers, pooled handles, weak_ptr::lock()
+void runLifetimeBenchmark() {
+    const size_t SUBSCRIBERS = 1000000;
+    const int ROUNDS = 5;
+    const int CHURN = 1000000;
+
+    vector<CountingSubscriber> plain(SUBSCRIBERS);
+    SubscriberPool<CountingSubscriber> pool;
+    Channel rawChannel("Raw"), pooledChannel("Pooled");    // outlive the tokens
+    vector<SubscriberHandle> handles;
+    vector<Subscription> tokens;
+    vector<shared_ptr<Isubscriber>> owners;
+    vector<weak_ptr<Isubscriber>> weak;
+
+    for (auto& sub : plain) rawChannel.subscribe(&sub);
+    for (size_t i = 0; i < SUBSCRIBERS; i++) {
+        handles.push_back(pool.create());
+        tokens.push_back(pooledChannel.subscribe(handles.back()));
+        owners.push_back(make_shared<CountingSubscriber>());
+        weak.push_back(owners.back());
+    }
+
+    auto weakNotify = [&]() {
+        for (const weak_ptr<Isubscriber>& entry : weak)
+            if (shared_ptr<Isubscriber> sub = entry.lock()) sub->update(&rawChannel);
+    };
+    weakNotify();
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++) weakNotify();
+    double weakUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / ROUNDS;
+
+    cout << "\n=== Subscriber lifetime check, " << SUBSCRIBERS << " subscribers ===\n";
+    cout << "entry\tus per notify\n";
+    cout << "raw pointer\t" << notifyMicros(rawChannel, ROUNDS) << "\n";
+    cout << "pooled handle\t" << notifyMicros(pooledChannel, ROUNDS) << "\n";
+    cout << "weak_ptr lock\t" << weakUs << "\n";
+
+    Channel churnChannel("Churn");
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < CHURN; i++) {
+        SubscriberHandle handle = pool.create();
+        Subscription token = churnChannel.subscribe(handle);
+        token.reset();
+        pool.destroy(handle);
+    }
+    double pooledNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / CHURN;
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < CHURN; i++) {
+        shared_ptr<Isubscriber> sub = make_shared<CountingSubscriber>();
+        churnChannel.subscribe(sub.get());
+        churnChannel.unSubscribe(sub.get());
+    }
+    double sharedNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / CHURN;
+
+    cout << "\n=== Subscriber churn (create + subscribe + unsubscribe + destroy), ns per op ===\n";
+    cout << "pool + token\t" << pooledNs << "\n";
+    cout << "make_shared + raw\t" << sharedNs << "\n";
+
+    // Half the pooled subscribers die while still subscribed
+    for (size_t i = 0; i < SUBSCRIBERS; i += 2) pool.destroy(handles[i]);
+    size_t before = pooledChannel.getSubscriberCount();
+    pooledChannel.notifySubscribers();
+    cout << "\ndestroyed while subscribed: " << before << " entries -> "
+         << pooledChannel.getSubscriberCount() << " after one notify\n";
+}
+
 /* ===================== MAIN ===================== */
 
-int main() {
+int main(int argc, char* argv[]) {
+
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runObserverBenchmark();
+        runLifetimeBenchmark();
+        return 0;
+    }
 
     Channel tech("TechWorld");
     Channel music("MusicHub");
@@ -233,6 +906,37 @@ int main() {
     tech.uploadVideo("Templates Deep Dive");
     music.uploadVideo("Live Coding Session");
 
+    /* ---------- COALESCED BURST DEMO ---------- */
+    cout << "\n===== COALESCED: Upload Burst =====\n";
+    music.setNotifyMode(COALESCED);
+
+    music.uploadVideo("Teaser");
+    music.uploadVideo("Teaser (fixed audio)");
+    music.uploadVideo("Full Episode");
+
+    cout << "\n--- Delivering pending notifications ---\n";
+    music.deliverPending();
+    cout << "(" << music.getCoalescedUploads() << " earlier uploads coalesced away)" << endl;
+
+    /* ---------- POOLED SUBSCRIBERS DEMO ---------- */
+    cout << "\n===== POOLED: Generational Handles =====\n";
+    SubscriberPool<PureSubscriber> viewers;
+    SubscriberHandle neha = viewers.create("Neha");
+    SubscriberHandle arjun = viewers.create("Arjun");
+
+    Subscription nehaSubscription = tech.subscribe(neha);
+    {
+        Subscription arjunSubscription = tech.subscribe(arjun);
+        tech.uploadVideo("RAII Subscriptions");
+    }   // token gone -> Arjun unsubscribed
+    tech.uploadVideo("Generation Counters");
+
+    cout << "\n--- Neha's account is deleted while still subscribed ---\n";
+    viewers.destroy(neha);
+    tech.uploadVideo("Dangling Pointers, Defused");
+    cout << "(TechWorld subscribers: " << tech.getSubscriberCount()
+         << ", Neha's handle: " << (viewers.get(neha) ? "alive" : "expired") << ")" << endl;
+
     return 0;
 }
 
@@ -61,12 +61,18 @@ LazySingleton* LazySingleton::instance = nullptr;  // Initialize pointer to NULL
     3) THREAD-SAFE SINGLETON USING MUTEX (For multi-threaded applications)
     - Uses double-checked locking to avoid race conditions.
     - Ensures safe instance creation even with multiple threads calling getInstance().
+    - The pointer MUST be atomic: with a plain pointer the unlocked first check races with
+      the write inside the lock, and a reader may see the pointer before the object it
+      points to is fully constructed.
+    - release store (publish) + acquire load (fast path) = whoever sees the pointer also
+      sees the finished object. The fast path is one load + one branch, no lock.
 ************************************************************************************************/
 #include <mutex>
+#include <atomic>
 
 class ThreadSafeSingleton {
 private:
-    static ThreadSafeSingleton* instance;
+    static atomic<ThreadSafeSingleton*> instance;
     static mutex mtx;  // mutex to guard instance creation
 
     ThreadSafeSingleton() {
@@ -77,20 +83,24 @@ public:
     static ThreadSafeSingleton* getInstance() {
 
         // First check (fast path, no lock)
-        if(instance == nullptr) {
+        ThreadSafeSingleton* current = instance.load(memory_order_acquire);
+        if(current == nullptr) {
 
             lock_guard<mutex> lock(mtx); // Lock to prevent race condition
 
-            // Second check inside lock
-            if(instance == nullptr)
-                instance = new ThreadSafeSingleton();
+            // Second check inside lock (the mutex already orders it)
+            current = instance.load(memory_order_relaxed);
+            if(current == nullptr) {
+                current = new ThreadSafeSingleton();
+                instance.store(current, memory_order_release);
+            }
         }
-        return instance;
+        return current;
     }
 };
 
 // Define static members
-ThreadSafeSingleton* ThreadSafeSingleton::instance = nullptr;
+atomic<ThreadSafeSingleton*> ThreadSafeSingleton::instance{nullptr};
 mutex ThreadSafeSingleton::mtx;
 
 
@@ -116,10 +126,359 @@ public:
 EagerSingleton* EagerSingleton::instance = new EagerSingleton();
 
 
+/************************************************************************************************
+    5) SERVICE LOCATOR WITH A LAZY DEPENDENCY GRAPH (many singletons that need each other)
+    - provide<T, Deps...>("Name", factory) registers a subsystem and what it needs first.
+      Nothing is built at registration, so startup only pays for what is actually used.
+    - get<T>() fast path = one acquire load of a per-type pointer (same publish rule as 3).
+      Slow path (first use) takes the lock, builds the dependencies depth-first, then T.
+      A dependency cycle or a missing provider is reported and aborts.
+    - cached<T>() = per-thread copy of that pointer for hot callers: after the first call
+      it is a plain thread-local read, nothing shared is touched.
+    - Every subsystem's own constructor time (its dependencies excluded) is recorded;
+      printStartupReport() lists them in init order to show where startup goes.
+************************************************************************************************/
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <typeinfo>
+#include <cstdlib>
+#include <string>
+
+class ServiceLocator {
+private:
+    enum NodeState { REGISTERED, INITIALIZING, READY };
+
+    struct Node {
+        const char* name;
+        vector<int (*)()> dependencies;     // resolved on first use: register in any order
+        function<void*()> create;
+        function<void(void*)> publish;      // sets the per-type fast-path pointer
+        function<void(void*)> destroy;
+        NodeState state = REGISTERED;
+        void* instance = nullptr;
+        chrono::nanoseconds initTime{0};
+    };
+
+    template <class T>
+    struct Slot {
+        inline static atomic<T*> instance{nullptr};
+        inline static int node = -1;        // written / read under the lock only
+    };
+
+    // Recursive: a constructor may call get<>() for something it did not declare
+    inline static recursive_mutex lock;
+    inline static vector<Node> nodes;
+    inline static vector<int> initOrder;
+    inline static vector<int> initStack;
+    inline static chrono::nanoseconds nestedTime{0};
+
+    template <class T>
+    static int nodeOf() {
+        return Slot<T>::node;
+    }
+
+    static void fatal(const string& message) {
+        cerr << "[FATAL] " << message << endl;
+        abort();
+    }
+
+    // Slow path of get<T>(): nodeIndex() is read under the lock
+    static void* initialize(int (*nodeIndex)(), const char* typeName) {
+        lock_guard<recursive_mutex> guard(lock);
+        int index = nodeIndex();
+        if (index < 0)
+            fatal(string("no provider registered for ") + typeName);
+        return initializeNode(index);
+    }
+
+    // Caller holds the lock
+    static void* initializeNode(int index) {
+        if (nodes[index].state == READY)
+            return nodes[index].instance;   // another thread won the race
+        if (nodes[index].state == INITIALIZING) {
+            string cycle;
+            for (int i : initStack) cycle += string(nodes[i].name) + " -> ";
+            fatal("dependency cycle: " + cycle + nodes[index].name);
+        }
+
+        auto entered = chrono::steady_clock::now();
+        auto nestedBefore = nestedTime;
+        nodes[index].state = INITIALIZING;
+        initStack.push_back(index);
+
+        // nodes[] is only appended to by provide(), never during init: indexes stay valid
+        for (int (*dependency)() : nodes[index].dependencies) {
+            if (dependency() < 0)
+                fatal(string(nodes[index].name) + " depends on a service with no provider");
+            initializeNode(dependency());
+        }
+
+        auto start = chrono::steady_clock::now();
+        auto nestedAtStart = nestedTime;
+        void* instance = nodes[index].create();
+        auto end = chrono::steady_clock::now();
+
+        // Own time only: undeclared get<>() calls inside the constructor are charged to themselves
+        nodes[index].initTime = (end - start) - (nestedTime - nestedAtStart);
+        nestedTime = nestedBefore + (end - entered);
+
+        nodes[index].instance = instance;
+        nodes[index].state = READY;
+        nodes[index].publish(instance);
+        initOrder.push_back(index);
+        initStack.pop_back();
+        return instance;
+    }
+
+public:
+    template <class T, class... Dependencies>
+    static void provide(const char* name, function<T*()> make) {
+        lock_guard<recursive_mutex> guard(lock);
+        if (Slot<T>::node >= 0) {
+            cout << "[Locator] " << name << " already provided\n";
+            return;
+        }
+        Node node;
+        node.name = name;
+        node.dependencies = {&nodeOf<Dependencies>...};
+        node.create = [make]() -> void* { return make(); };
+        node.publish = [](void* p) { Slot<T>::instance.store(static_cast<T*>(p), memory_order_release); };
+        node.destroy = [](void* p) {
+            Slot<T>::instance.store(nullptr, memory_order_release);
+            delete static_cast<T*>(p);
+        };
+        Slot<T>::node = (int)nodes.size();
+        nodes.push_back(move(node));
+    }
+
+    template <class T>
+    static T& get() {
+        T* service = Slot<T>::instance.load(memory_order_acquire);
+        if (service)
+            return *service;
+        return *static_cast<T*>(initialize(&nodeOf<T>, typeid(T).name()));
+    }
+
+    // Do not keep using it across shutdown()
+    template <class T>
+    static T& cached() {
+        thread_local T* service = nullptr;
+        if (!service)
+            service = &get<T>();
+        return *service;
+    }
+
+    // Optional warm-up: build everything now (e.g. on a startup thread)
+    static void initializeAll() {
+        lock_guard<recursive_mutex> guard(lock);
+        for (size_t i = 0; i < nodes.size(); i++)
+            initializeNode((int)i);
+    }
+
+    static void printStartupReport() {
+        lock_guard<recursive_mutex> guard(lock);
+        chrono::nanoseconds total{0};
+        cout << "[Startup] init order, own constructor time (dependencies excluded):\n";
+        for (int index : initOrder) {
+            const Node& node = nodes[index];
+            total += node.initTime;
+            cout << "  " << node.name << "\t"
+                 << chrono::duration<double, milli>(node.initTime).count() << " ms";
+            if (!node.dependencies.empty()) {
+                cout << "\t(needs";
+                for (int (*dependency)() : node.dependencies) cout << " " << nodes[dependency()].name;
+                cout << ")";
+            }
+            cout << "\n";
+        }
+        cout << "  total\t" << chrono::duration<double, milli>(total).count() << " ms, "
+             << nodes.size() - initOrder.size() << " registered but never used\n";
+    }
+
+    // Tears down in reverse init order (dependents before what they use)
+    static void shutdown() {
+        lock_guard<recursive_mutex> guard(lock);
+        for (auto it = initOrder.rbegin(); it != initOrder.rend(); ++it) {
+            Node& node = nodes[*it];
+            node.destroy(node.instance);
+            node.instance = nullptr;
+            node.state = REGISTERED;
+        }
+        initOrder.clear();
+    }
+};
+
+// Demo subsystems: each constructor stands in for real startup work
+void simulateWork(int millis) {
+    this_thread::sleep_for(chrono::milliseconds(millis));
+}
+
+class Config {
+public:
+    Config() { simulateWork(2); cout << "[Init] Config loaded\n"; }
+    string get(const string& key) const { return key == "db.url" ? "postgres://orders" : "default"; }
+};
+
+class Logger {
+public:
+    Logger(const Config&) { simulateWork(1); cout << "[Init] Logger ready\n"; }
+    void log(const string& line) const { cout << "[Log] " << line << "\n"; }
+};
+
+class Database {
+public:
+    Database(const Config& config, Logger& logger) {
+        simulateWork(8);
+        logger.log("Database connected to " + config.get("db.url"));
+    }
+};
+
+class Cache {
+public:
+    Cache(const Config&) { simulateWork(3); cout << "[Init] Cache warmed\n"; }
+};
+
+class Metrics {
+public:
+    Metrics() { simulateWork(5); cout << "[Init] Metrics exporter started\n"; }
+};
+
+class OrderService {
+    Logger& logger;
+
+public:
+    OrderService(Database&, Cache&, Logger& logger) : logger(logger) {
+        simulateWork(1);
+        logger.log("OrderService ready");
+    }
+
+    void placeOrder(int id) const {
+        logger.log("Order #" + to_string(id) + " placed");
+    }
+};
+
+// Registration only: nothing is constructed here
+void registerSubsystems() {
+    ServiceLocator::provide<Config>("Config", []() { return new Config(); });
+    ServiceLocator::provide<Logger, Config>("Logger", []() {
+        return new Logger(ServiceLocator::get<Config>());
+    });
+    ServiceLocator::provide<Database, Config, Logger>("Database", []() {
+        return new Database(ServiceLocator::get<Config>(), ServiceLocator::get<Logger>());
+    });
+    ServiceLocator::provide<Cache, Config>("Cache", []() {
+        return new Cache(ServiceLocator::get<Config>());
+    });
+    ServiceLocator::provide<Metrics>("Metrics", []() { return new Metrics(); });
+    ServiceLocator::provide<OrderService, Database, Cache, Logger>("OrderService", []() {
+        return new OrderService(ServiceLocator::get<Database>(), ServiceLocator::get<Cache>(),
+                                ServiceLocator::get<Logger>());
+    });
+}
+
+
+/************************************************************************************************
+    BENCHMARK: cost of one singleton access, 1..N threads hammering it
+    RUN:
+    - ./singleton          -> demo
+    - ./singleton --bench  -> ns per access: mutex every call, function-local static
+                              (ParkingLot::getInstance style), atomic DCLP, locator get<T>(),
+                              locator cached<T>()
+************************************************************************************************/
+class MeyersSingleton {
+public:
+    int value = 1;
+
+    static MeyersSingleton& getInstance() {
+        static MeyersSingleton instance;    // guard byte checked on every call
+        return instance;
+    }
+};
+
+class LockedSingleton {
+    static LockedSingleton* instance;
+    static mutex mtx;
+
+public:
+    int value = 1;
+
+    static LockedSingleton* getInstance() {
+        lock_guard<mutex> lock(mtx);
+        if (instance == nullptr)
+            instance = new LockedSingleton();
+        return instance;
+    }
+};
+
+LockedSingleton* LockedSingleton::instance = nullptr;
+mutex LockedSingleton::mtx;
+
+struct HotCounter {
+    int value = 1;
+};
+
+void runSingletonBenchmark() {
+    const int ACCESSES = 20000000;
+
+    ServiceLocator::provide<HotCounter>("HotCounter", []() { return new HotCounter(); });
+
+    // The first ThreadSafeSingleton access prints; keep the table clean
+    streambuf* saved = cout.rdbuf(nullptr);
+    ThreadSafeSingleton::getInstance();
+    cout.rdbuf(saved);
+    cout.clear();
+
+    int maxThreads = max(4u, thread::hardware_concurrency());
+    vector<int> threadCounts;
+    for (int n = 1; n <= maxThreads; n *= 2) threadCounts.push_back(n);
+    if (threadCounts.back() != maxThreads) threadCounts.push_back(maxThreads);
+
+    // The signal fence is a compiler-only barrier: every iteration really does the access
+    auto measure = [&](int threads, auto access) {
+        int perThread = ACCESSES / threads;
+        vector<thread> workers;
+        auto start = chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&]() {
+                uintptr_t sink = 0;
+                for (int i = 0; i < perThread; i++) {
+                    sink += (uintptr_t)access();
+                    atomic_signal_fence(memory_order_seq_cst);
+                }
+                if (sink == 1) cout << "";
+            });
+        }
+        for (auto& w : workers) w.join();
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        return ns / perThread;
+    };
+
+    cout << "================= SINGLETON ACCESS (ns per access, per thread) =================\n";
+    cout << "threads\tmutex\tlocal static\tatomic DCLP\tlocator get\tlocator cached\n";
+    for (int threads : threadCounts) {
+        cout << threads
+             << "\t" << measure(threads, []() { return (void*)LockedSingleton::getInstance(); })
+             << "\t" << measure(threads, []() { return (void*)&MeyersSingleton::getInstance(); })
+             << "\t" << measure(threads, []() { return (void*)ThreadSafeSingleton::getInstance(); })
+             << "\t" << measure(threads, []() { return (void*)&ServiceLocator::get<HotCounter>(); })
+             << "\t" << measure(threads, []() { return (void*)&ServiceLocator::cached<HotCounter>(); })
+             << "\n";
+    }
+    cout << "(hardware threads: " << thread::hardware_concurrency() << ")\n";
+}
+
+
 /************************************************************************************************
     MAIN FUNCTION TO TEST ALL SINGLETON VERSIONS
 ************************************************************************************************/
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runSingletonBenchmark();
+        return 0;
+    }
+
     cout << "\n================= TESTING PRIMITIVE VERSION =================\n";
     PrimitiveSingleton p1;
     PrimitiveSingleton p2; // Not stopped, only warned
@@ -142,6 +501,19 @@ int main() {
     EagerSingleton* e2 = EagerSingleton::getInstance();
     cout << "EagerSingleton same instance? " << (e1 == e2) << "\n";
 
+
+    cout << "\n================= SERVICE LOCATOR / LAZY INIT GRAPH ========\n";
+    registerSubsystems();
+    cout << "Registered 6 subsystems, none built yet\n";
+
+    // First use pulls in Config, Logger, Database, Cache (in that order), never Metrics
+    OrderService& orders = ServiceLocator::get<OrderService>();
+    orders.placeOrder(1);
+    ServiceLocator::cached<OrderService>().placeOrder(2);
+    cout << "OrderService same instance? " << (&orders == &ServiceLocator::cached<OrderService>()) << "\n";
+    ServiceLocator::printStartupReport();
+    ServiceLocator::shutdown();
+
     cout << "\n================= END OF NOTES =================\n";
     return 0;
 }
\ No newline at end of file
@@ -1,9 +1,45 @@
 #include<iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdint>
 using namespace std;
 
+// What one simulation tick changes on a robot
+struct RobotState {
+  int32_t x = 0;
+  int32_t altitude = 0;
+  int32_t battery = 1000000;
+  uint32_t words = 0;
+};
+
+// A whole fleet summed, wide enough for a million robots
+struct RobotTotals {
+  int64_t x = 0;
+  int64_t altitude = 0;
+  int64_t battery = 0;
+  int64_t words = 0;
+
+  void add(const RobotState& s) {
+    x += s.x;
+    altitude += s.altitude;
+    battery += s.battery;
+    words += s.words;
+  }
+
+  bool operator==(const RobotTotals& o) const {
+    return x == o.x && altitude == o.altitude && battery == o.battery && words == o.words;
+  }
+};
+
+// Each behavior keeps its tick as a static XxxTick(RobotState&), so the
+// same class works as a runtime strategy and as a compile-time policy
 class Talkable{
   public:
     virtual void Talk() = 0;
+    virtual void Talk(RobotState& s) = 0;
     virtual ~Talkable() {};
 };
 
@@ -12,6 +48,11 @@ class NormalTalk : public Talkable{
     void Talk() override {
       cout<<"Talking Normally..."<<endl;
     }
+    static void TalkTick(RobotState& s) {
+      s.words += 1;
+      s.battery -= 1;
+    }
+    void Talk(RobotState& s) override { TalkTick(s); }
 };
 
 class NoTalk : public Talkable{
@@ -19,11 +60,14 @@ class NoTalk : public Talkable{
     void Talk() override {
       cout<<"No Talking..."<<endl;
     }
+    static void TalkTick(RobotState&) {}
+    void Talk(RobotState& s) override { TalkTick(s); }
 };
 
 class Walkable{
   public:
     virtual void Walk() = 0;
+    virtual void Walk(RobotState& s) = 0;
     virtual ~ Walkable(){};
 };
 
@@ -32,6 +76,11 @@ class NormalWalk : public Walkable{
     void Walk() override {
       cout<<"Normal Walking..."<<endl;
     }
+    static void WalkTick(RobotState& s) {
+      s.x += 5;
+      s.battery -= 2;
+    }
+    void Walk(RobotState& s) override { WalkTick(s); }
 };
 
 class NoWalk : public Walkable{
@@ -39,11 +88,14 @@ class NoWalk : public Walkable{
     void Walk() override {
       cout<<"No Walking..."<<endl;
     }
+    static void WalkTick(RobotState&) {}
+    void Walk(RobotState& s) override { WalkTick(s); }
 };
 
 class Flyable{
   public:
     virtual void Fly() = 0;
+    virtual void Fly(RobotState& s) = 0;
     virtual ~Flyable(){}
 };
 
@@ -52,6 +104,11 @@ class NormalFly : public Flyable{
     void Fly() override {
       cout<<"Normal Fly..."<<endl;
     }
+    static void FlyTick(RobotState& s) {
+      s.altitude = min(s.altitude + 3, 1000);
+      s.battery -= 5;
+    }
+    void Fly(RobotState& s) override { FlyTick(s); }
 };
 
 class NoFly : public Flyable{
@@ -59,8 +116,14 @@ class NoFly : public Flyable{
     void Fly() override {
       cout<<"No Fly..."<<endl;
     }
+    static void FlyTick(RobotState& s) {
+      s.altitude = 0;
+    }
+    void Fly(RobotState& s) override { FlyTick(s); }
 };
 
+// Runtime strategies: three virtual calls per tick, but any of them
+// can be swapped mid-simulation
 class Robot{
   protected:
     Talkable* t;
@@ -68,6 +131,8 @@ class Robot{
     Flyable* f;
 
   public:
+    RobotState state;
+
     Robot(Talkable* t, Walkable* w, Flyable* f){
       this->t = t;
       this->w = w;
@@ -86,7 +151,18 @@ class Robot{
       f->Fly();
     }
 
+    void setTalk(Talkable* t){ this->t = t; }
+    void setWalk(Walkable* w){ this->w = w; }
+    void setFly(Flyable* f){ this->f = f; }
+
+    void Tick(){
+      t->Talk(state);
+      w->Walk(state);
+      f->Fly(state);
+    }
+
     virtual void Projection()=0;
+    virtual ~Robot(){}
 };
 
 class Companion : public Robot{
@@ -107,7 +183,189 @@ class Worker : public Robot{
     }
 };
 
-int main(){
+// Compile-time strategies: behaviors are fixed by the type, so every
+// call is direct and inlined (NoTalk / NoWalk ticks vanish), and the
+// robot is just its state - no strategy pointers
+template<class TalkPolicy, class WalkPolicy, class FlyPolicy>
+class PolicyRobot{
+  public:
+    RobotState state;
+
+    void Talk(){ TalkPolicy().Talk(); }
+    void Walk(){ WalkPolicy().Walk(); }
+    void Fly(){ FlyPolicy().Fly(); }
+
+    void Tick(){
+      TalkPolicy::TalkTick(state);
+      WalkPolicy::WalkTick(state);
+      FlyPolicy::FlyTick(state);
+    }
+};
+
+// Data-oriented fleet: robots grouped by behavior combination, each
+// group one contiguous array with its own instantiated tick loop.
+// One indirect call per group per tick instead of three per robot.
+// Robots that change strategy mid-simulation stay runtime Robots.
+class RobotFleet{
+  private:
+    struct Group {
+      void (*tick)(vector<RobotState>&);
+      vector<RobotState> robots;
+    };
+    vector<Group> groups;
+    vector<Robot*> swappable;
+
+    template<class TalkPolicy, class WalkPolicy, class FlyPolicy>
+    static void TickGroup(vector<RobotState>& robots){
+      for (RobotState& s : robots) {
+        TalkPolicy::TalkTick(s);
+        WalkPolicy::WalkTick(s);
+        FlyPolicy::FlyTick(s);
+      }
+    }
+
+  public:
+    template<class TalkPolicy, class WalkPolicy, class FlyPolicy>
+    void add(size_t count = 1){
+      auto tick = &TickGroup<TalkPolicy, WalkPolicy, FlyPolicy>;
+      for (Group& g : groups) {
+        if (g.tick == tick) {
+          g.robots.resize(g.robots.size() + count);
+          return;
+        }
+      }
+      groups.push_back({tick, vector<RobotState>(count)});
+    }
+
+    // Not owned
+    void add(Robot* robot){
+      swappable.push_back(robot);
+    }
+
+    void Tick(){
+      for (Group& g : groups)
+        g.tick(g.robots);
+      for (Robot* r : swappable)
+        r->Tick();
+    }
+
+    size_t size() const {
+      size_t n = swappable.size();
+      for (const Group& g : groups)
+        n += g.robots.size();
+      return n;
+    }
+
+    size_t groupCount() const { return groups.size(); }
+
+    // Everything summed, to check a run
+    RobotTotals total() const {
+      RobotTotals sum;
+      for (const Group& g : groups)
+        for (const RobotState& s : g.robots)
+          sum.add(s);
+      for (const Robot* r : swappable)
+        sum.add(r->state);
+      return sum;
+    }
+};
+
+/*
+BENCHMARK: ./strategy --bench
+ROBOTS robots, TICKS ticks, all 8 behavior combinations mixed:
+- runtime: a Robot* per robot, three virtual calls per tick,
+  in creation (random combination) order
+- runtime, sorted: same, ordered by combination, so the
+  indirect branches predict (but the robots are now visited
+  out of allocation order)
+- fleet: RobotFleet, one inlined loop per combination
+Every mode must end with the same summed state.
+*/
+RobotTotals sumStates(const vector<Robot*>& robots){
+  RobotTotals sum;
+  for (const Robot* r : robots)
+    sum.add(r->state);
+  return sum;
+}
+
+void runRobotBenchmark(){
+  const int ROBOTS = 1000000;
+  const int TICKS = 50;
+
+  NormalTalk normalTalk; NoTalk noTalk;
+  NormalWalk normalWalk; NoWalk noWalk;
+  NormalFly normalFly; NoFly noFly;
+  Talkable* talks[2] = {&normalTalk, &noTalk};
+  Walkable* walks[2] = {&normalWalk, &noWalk};
+  Flyable* flies[2] = {&normalFly, &noFly};
+
+  // combo bits: 1 = NoTalk, 2 = NoWalk, 4 = NoFly
+  mt19937 rng(42);
+  vector<int> combos(ROBOTS);
+  int counts[8] = {};
+  for (int& c : combos) {
+    c = (int)(rng() % 8);
+    counts[c]++;
+  }
+
+  vector<Robot*> robots;
+  robots.reserve(ROBOTS);
+  for (int c : combos) {
+    if (c % 2)
+      robots.push_back(new Worker(talks[c & 1], walks[(c >> 1) & 1], flies[(c >> 2) & 1]));
+    else
+      robots.push_back(new Companion(talks[c & 1], walks[(c >> 1) & 1], flies[(c >> 2) & 1]));
+  }
+  vector<Robot*> sorted(robots.size());
+  for (size_t i = 0, at = 0; i < 8; i++)
+    for (size_t r = 0; r < robots.size(); r++)
+      if (combos[r] == (int)i)
+        sorted[at++] = robots[r];
+
+  RobotFleet fleet;
+  fleet.add<NormalTalk, NormalWalk, NormalFly>(counts[0]);
+  fleet.add<NoTalk,     NormalWalk, NormalFly>(counts[1]);
+  fleet.add<NormalTalk, NoWalk,     NormalFly>(counts[2]);
+  fleet.add<NoTalk,     NoWalk,     NormalFly>(counts[3]);
+  fleet.add<NormalTalk, NormalWalk, NoFly>(counts[4]);
+  fleet.add<NoTalk,     NormalWalk, NoFly>(counts[5]);
+  fleet.add<NormalTalk, NoWalk,     NoFly>(counts[6]);
+  fleet.add<NoTalk,     NoWalk,     NoFly>(counts[7]);
+
+  auto nsPerRobotTick = [&](auto&& tick) {
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < TICKS; i++)
+      tick();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()
+           / ((double)ROBOTS * TICKS);
+  };
+
+  double runtimeNs = nsPerRobotTick([&] { for (Robot* r : robots) r->Tick(); });
+  RobotTotals runtimeSum = sumStates(robots);
+  for (Robot* r : robots) r->state = RobotState();
+  double sortedNs = nsPerRobotTick([&] { for (Robot* r : sorted) r->Tick(); });
+  RobotTotals sortedSum = sumStates(robots);
+  double fleetNs = nsPerRobotTick([&] { fleet.Tick(); });
+  RobotTotals fleetSum = fleet.total();
+
+  cout << "\n==== ROBOT TICK (" << ROBOTS << " robots, " << TICKS << " ticks, "
+       << fleet.groupCount() << " behavior groups) ====\n"
+       << "mode\t\t\tns per robot-tick\tstate\n"
+       << "runtime Robot*\t\t" << runtimeNs << "\t\t" << "reference\n"
+       << "runtime, sorted\t\t" << sortedNs << "\t\t"
+       << (sortedSum == runtimeSum ? "OK" : "MISMATCH") << "\n"
+       << "RobotFleet\t\t" << fleetNs << "\t\t"
+       << (fleetSum == runtimeSum ? "OK" : "MISMATCH") << "\n";
+
+  for (Robot* r : robots) delete r;
+}
+
+int main(int argc, char* argv[]){
+  if (argc > 1 && string(argv[1]) == "--bench") {
+    runRobotBenchmark();
+    return 0;
+  }
+
   Robot* r1 = new Companion(new NormalTalk(), new NormalWalk(), new NoFly());
   r1->Projection();
   r1->Talk();
@@ -121,4 +379,29 @@ int main(){
   r2->Talk();
   r2->Walk();
   r2->Fly();
-}
\ No newline at end of file
+
+  cout<<"-----------------"<<endl;
+
+  // Same behaviors as r1, picked at compile time
+  PolicyRobot<NormalTalk, NormalWalk, NoFly> r3;
+  r3.Talk();
+  r3.Walk();
+  r3.Fly();
+
+  cout<<"-----------------"<<endl;
+
+  // 1000 inlined robots in two groups, plus r2 ticking through its
+  // strategies; halfway through, r2 learns to walk
+  RobotFleet fleet;
+  fleet.add<NormalTalk, NormalWalk, NoFly>(600);
+  fleet.add<NoTalk, NoWalk, NormalFly>(400);
+  fleet.add(r2);
+  for (int tick = 0; tick < 10; tick++) {
+    if (tick == 5)
+      r2->setWalk(new NormalWalk());
+    fleet.Tick();
+  }
+  RobotTotals total = fleet.total();
+  cout<<"Fleet of "<<fleet.size()<<" robots in "<<fleet.groupCount()<<" groups after 10 ticks:"<<endl;
+  cout<<"distance "<<total.x<<", words "<<total.words<<", r2 walked "<<r2->state.x<<endl;
+}
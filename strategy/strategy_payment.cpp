@@ -1,4 +1,20 @@
 #include<iostream>
+#include <vector>
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../common/PaymentLane.h"
 using namespace std;
 
 /*
@@ -19,14 +35,15 @@ Solution:
 -----------------------------------------------------
 STRATEGY INTERFACE
 -----------------------------------------------------
-- Declares common behavior for all payment methods
-- Any payment method must implement `pay()`
+- PaymentStrategy is declared in ../common/PaymentLane.h,
+  shared with the parking lot's exit gates
+- Any payment method must implement `pay()`, which returns
+  the provider's answer
+- `payBatch()` is one provider round-trip for many payments;
+  the async pipeline below only ever calls this
+- FAILED and TIMED_OUT results are transient: worth a retry;
+  DECLINED is final (the provider said no)
 */
-class PaymentStrategy {
-public:
-    virtual void pay(int amount) = 0;   // common payment operation
-    virtual ~PaymentStrategy() {}        // virtual destructor
-};
 
 /*
 -----------------------------------------------------
@@ -39,27 +56,121 @@ CONCRETE STRATEGIES
 // Credit Card Payment Strategy
 class CreditCardPayment : public PaymentStrategy {
 public:
-    void pay(int amount) override {
+    PaymentStatus pay(int amount) override {
         cout << "Paid " << amount << " using Credit Card" << endl;
+        return APPROVED;
     }
 };
 
 // UPI Payment Strategy
 class UpiPayment : public PaymentStrategy {
 public:
-    void pay(int amount) override {
+    PaymentStatus pay(int amount) override {
         cout << "Paid " << amount << " using UPI" << endl;
+        return APPROVED;
     }
 };
 
 // PayPal Payment Strategy
 class PaypalPayment : public PaymentStrategy {
 public:
-    void pay(int amount) override {
+    PaymentStatus pay(int amount) override {
         cout << "Paid " << amount << " using PayPal" << endl;
+        return APPROVED;
     }
 };
 
+/*
+-----------------------------------------------------
+SIMULATED GATEWAY
+-----------------------------------------------------
+- Stands in for a real provider behind the network
+- Every call costs one round-trip, however many payments it carries
+- A round-trip slower than the deadline times out
+- Every `failEvery`-th payment fails transiently;
+  amounts above `limit` are declined
+*/
+class GatewayPayment : public PaymentStrategy {
+private:
+    string name;
+    atomic<int64_t> roundTripUs;
+    uint64_t failEvery;
+    int limit;
+    atomic<uint64_t> sequence{0};
+
+public:
+    GatewayPayment(const string& name, chrono::microseconds roundTrip,
+                   uint64_t failEvery = 0, int limit = 100000)
+        : name(name), roundTripUs(roundTrip.count()), failEvery(failEvery), limit(limit) {}
+
+    // Lets the benchmark degrade a provider while traffic is flowing
+    void setRoundTrip(chrono::microseconds roundTrip) {
+        roundTripUs.store(roundTrip.count(), memory_order_relaxed);
+    }
+
+    const string& getName() const { return name; }
+
+    PaymentStatus pay(int amount) override {
+        PaymentStatus status = TIMED_OUT;
+        payBatch(&amount, &status, 1, chrono::steady_clock::time_point::max());
+        cout << "Paid " << amount << " using " << name << " (" << statusName(status) << ")" << endl;
+        return status;
+    }
+
+    void payBatch(const int* amounts, PaymentStatus* results, size_t count,
+                  chrono::steady_clock::time_point deadline) override {
+        auto answered = chrono::steady_clock::now()
+                      + chrono::microseconds(roundTripUs.load(memory_order_relaxed));
+        if (answered > deadline) {
+            this_thread::sleep_until(deadline);
+            for (size_t i = 0; i < count; i++)
+                results[i] = TIMED_OUT;
+            return;
+        }
+        this_thread::sleep_until(answered);
+
+        uint64_t first = sequence.fetch_add(count, memory_order_relaxed);
+        for (size_t i = 0; i < count; i++) {
+            if (failEvery && (first + i) % failEvery == failEvery - 1)
+                results[i] = FAILED;
+            else
+                results[i] = amounts[i] > limit ? DECLINED : APPROVED;
+        }
+    }
+};
+
+// A provider that never answers in time (and ignores the deadline)
+class HangingPayment : public PaymentStrategy {
+private:
+    chrono::milliseconds hang;
+
+public:
+    explicit HangingPayment(chrono::milliseconds hang) : hang(hang) {}
+
+    PaymentStatus pay(int) override {
+        this_thread::sleep_for(hang);
+        return APPROVED;
+    }
+};
+
+// A provider client that throws instead of answering
+class ThrowingPayment : public PaymentStrategy {
+public:
+    PaymentStatus pay(int) override {
+        throw runtime_error("connection reset");
+    }
+};
+
+/*
+-----------------------------------------------------
+ASYNC PAYMENT PIPELINE
+-----------------------------------------------------
+- PaymentPipeline / PaymentLane (../common/PaymentLane.h):
+  submit() returns a future at once, one lane per provider,
+  batched round-trips, bounded retries and a whole-payment
+  deadline
+*/
+
 /*
 -----------------------------------------------------
 CONTEXT CLASS
@@ -67,15 +178,19 @@ CONTEXT CLASS
 - Uses a PaymentStrategy to perform payment
 - Does NOT know which payment method is used
 - Payment method can be changed at runtime
+- With a pipeline, checkoutAsync() hands the payment over and
+  returns immediately
 */
 class PaymentContext {
 private:
     PaymentStrategy* strategy;   // pointer to strategy interface
+    PaymentPipeline* pipeline;   // optional, for checkoutAsync()
 
 public:
     // Constructor injects the initial payment strategy
-    PaymentContext(PaymentStrategy* strategy) {
+    PaymentContext(PaymentStrategy* strategy, PaymentPipeline* pipeline = nullptr) {
         this->strategy = strategy;
+        this->pipeline = pipeline;
     }
 
     // Allows changing payment method at runtime
@@ -87,14 +202,216 @@ public:
     void checkout(int amount) {
         strategy->pay(amount);
     }
+
+    // Queues the payment with the selected strategy's lane;
+    // without a pipeline it is paid right here
+    future<PaymentResult> checkoutAsync(int amount) {
+        if (pipeline)
+            return pipeline->submit(strategy, amount);
+
+        promise<PaymentResult> paid;
+        auto start = chrono::steady_clock::now();
+        PaymentStatus status = TIMED_OUT;
+        strategy->payBatch(&amount, &status, 1, chrono::steady_clock::time_point::max());
+        paid.set_value({status, 1, chrono::duration_cast<chrono::microseconds>(
+                                       chrono::steady_clock::now() - start)});
+        return paid.get_future();
+    }
 };
 
+/*
+=====================================================
+BENCHMARK
+=====================================================
+RUN:
+- ./payment          -> demo
+- ./payment --bench  -> mixed checkout traffic over three
+                        simulated gateways (card, UPI, PayPal):
+                        sync checkout vs one shared worker pool
+                        vs the per-provider pipeline, with PayPal
+                        healthy and with PayPal degraded past
+                        its timeout
+
+Reported per provider: p50 / p99 latency (submit -> result) and
+the share approved; plus overall payments/sec, and how many
+round-trips the pipeline needed.
+Gateways are sleeps, so the numbers hold on any core count.
+*/
+
+/*
+The old way to go async, kept only as the baseline to beat:
+one worker pool for every provider, one payment per round-trip,
+no retries. A slow provider holds its workers for the whole
+timeout, and every other provider queues behind it.
+*/
+class SharedPoolCheckout {
+private:
+    struct Pending {
+        PaymentStrategy* strategy;
+        int amount;
+        chrono::steady_clock::time_point submitted;
+        promise<PaymentResult> result;
+    };
+
+    chrono::milliseconds timeout;
+    mutex lock;
+    condition_variable ready;
+    deque<Pending> queue;
+    bool stopping = false;
+    vector<thread> workers;
+
+    void run() {
+        while (true) {
+            Pending pending;
+            {
+                unique_lock<mutex> guard(lock);
+                ready.wait(guard, [&] { return stopping || !queue.empty(); });
+                if (queue.empty())
+                    return;
+                pending = move(queue.front());
+                queue.pop_front();
+            }
+            PaymentStatus status = TIMED_OUT;
+            pending.strategy->payBatch(&pending.amount, &status, 1,
+                                       chrono::steady_clock::now() + timeout);
+            pending.result.set_value({status, 1, chrono::duration_cast<chrono::microseconds>(
+                                                     chrono::steady_clock::now() - pending.submitted)});
+        }
+    }
+
+public:
+    SharedPoolCheckout(int threads, chrono::milliseconds timeout) : timeout(timeout) {
+        for (int i = 0; i < threads; i++)
+            workers.emplace_back([this] { run(); });
+    }
+
+    ~SharedPoolCheckout() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (thread& worker : workers)
+            worker.join();
+    }
+
+    future<PaymentResult> submit(PaymentStrategy* strategy, int amount) {
+        Pending pending{strategy, amount, chrono::steady_clock::now(), {}};
+        future<PaymentResult> result = pending.result.get_future();
+        {
+            lock_guard<mutex> guard(lock);
+            queue.push_back(move(pending));
+        }
+        ready.notify_one();
+        return result;
+    }
+};
+
+struct ProviderStats {
+    vector<int64_t> latencyUs;
+    int approved = 0;
+
+    void add(const PaymentResult& result) {
+        latencyUs.push_back(result.latency.count());
+        if (result.status == APPROVED)
+            approved++;
+    }
+
+    double percentileMs(double p) {
+        if (latencyUs.empty())
+            return 0;
+        sort(latencyUs.begin(), latencyUs.end());
+        return latencyUs[min(latencyUs.size() - 1, (size_t)(p * latencyUs.size()))] / 1000.0;
+    }
+};
+
+/*
+The traffic: card and UPI take most checkouts, every 20th
+goes to PayPal. `checkout` pays one and returns its future.
+*/
+template<typename Checkout>
+void runCheckoutTraffic(const string& label, GatewayPayment* gateways[3], int payments,
+                        Checkout checkout) {
+    vector<future<PaymentResult>> pending;
+    vector<int> provider;
+    pending.reserve(payments);
+    provider.reserve(payments);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < payments; i++) {
+        int p = i % 20 == 19 ? 2 : i % 2;
+        provider.push_back(p);
+        pending.push_back(checkout(gateways[p], 100 + i % 900));
+    }
+    ProviderStats stats[3];
+    for (int i = 0; i < payments; i++)
+        stats[provider[i]].add(pending[i].get());
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << label << "\t" << (long)(payments / seconds);
+    for (ProviderStats& s : stats)
+        cout << "\t" << s.percentileMs(0.50) << " / " << s.percentileMs(0.99)
+             << " (" << 100 * s.approved / max<size_t>(1, s.latencyUs.size()) << "%)";
+    cout << "\n";
+}
+
+void runPaymentBenchmark() {
+    const int SYNC_PAYMENTS = 200;
+    const int PAYMENTS = 20000;
+    const int POOL_THREADS = 12;          // = 3 lanes x maxInFlight 4
+    PaymentLaneConfig config;
+    config.deadline = chrono::milliseconds(2000);
+
+    // Card and UPI: 1 ms round-trips; PayPal: 10 ms, flaky
+    GatewayPayment card("Card", chrono::microseconds(1000), 0);
+    GatewayPayment upi("UPI", chrono::microseconds(1000), 50);
+    GatewayPayment paypal("PayPal", chrono::microseconds(10000), 10);
+    GatewayPayment* gateways[3] = {&card, &upi, &paypal};
+
+    cout << "\n==== CHECKOUT: 3 gateways, every 20th payment to PayPal ====\n"
+         << "latency p50 / p99 ms (approved %); timeout " << config.timeout.count()
+         << " ms, " << config.maxRetries << " retries\n"
+         << "mode\t\tpay/sec\tcard\t\t\tUPI\t\t\tPayPal\n";
+
+    for (int degraded = 0; degraded < 2; degraded++) {
+        paypal.setRoundTrip(chrono::microseconds(degraded ? 200000 : 10000));
+        cout << (degraded ? "-- PayPal degraded: 200 ms round-trips --\n"
+                          : "-- PayPal healthy: 10 ms round-trips --\n");
+
+        PaymentContext context(&card);
+        runCheckoutTraffic("sync checkout", gateways, SYNC_PAYMENTS,
+            [&](GatewayPayment* gateway, int amount) {
+                context.setPaymentMethod(gateway);
+                return context.checkoutAsync(amount);
+            });
+
+        {
+            SharedPoolCheckout pool(POOL_THREADS, config.timeout);
+            runCheckoutTraffic("shared pool", gateways, PAYMENTS,
+                [&](GatewayPayment* gateway, int amount) { return pool.submit(gateway, amount); });
+        }
+
+        PaymentPipeline pipeline(config);
+        runCheckoutTraffic("pipeline", gateways, PAYMENTS,
+            [&](GatewayPayment* gateway, int amount) { return pipeline.submit(gateway, amount); });
+        uint64_t trips = 0;
+        for (GatewayPayment* gateway : gateways)
+            trips += pipeline.laneFor(gateway).getRoundTrips();
+        cout << "  pipeline round-trips: " << trips << " for " << PAYMENTS << " payments\n";
+    }
+}
+
 /*
 -----------------------------------------------------
 MAIN FUNCTION (CLIENT CODE)
 -----------------------------------------------------
 */
-int main() {
+int main(int argc, char* argv[]) {
+
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runPaymentBenchmark();
+        return 0;
+    }
 
     // Initial payment using Credit Card
     PaymentContext payment(new CreditCardPayment());
@@ -108,5 +425,77 @@ int main() {
     payment.setPaymentMethod(new PaypalPayment());
     payment.checkout(200);
 
+    /*
+    -------- ASYNC CHECKOUT --------
+    Card answers in 2 ms; UPI in 1 ms but every 10th payment
+    fails once and is retried; PayPal has degraded to 80 ms,
+    past its 20 ms timeout. PayPal times out on its own lane
+    while card and UPI carry on.
+    */
+    cout << "-------------------" << endl;
+
+    GatewayPayment* card = new GatewayPayment("Card", chrono::milliseconds(2));
+    GatewayPayment* upi = new GatewayPayment("UPI", chrono::milliseconds(1), 10);
+    GatewayPayment* paypal = new GatewayPayment("PayPal", chrono::milliseconds(80));
+
+    PaymentPipeline pipeline;
+    PaymentLaneConfig slowProvider;
+    slowProvider.maxInFlight = 2;
+    slowProvider.timeout = chrono::milliseconds(20);
+    pipeline.addProvider(paypal, slowProvider);
+
+    const int PER_PROVIDER = 100;
+    GatewayPayment* gateways[3] = {card, upi, paypal};
+    vector<future<PaymentResult>> results[3];
+
+    PaymentContext checkout(card, &pipeline);
+    for (int i = 0; i < PER_PROVIDER; i++) {
+        for (int p = 0; p < 3; p++) {
+            checkout.setPaymentMethod(gateways[p]);
+            results[p].push_back(checkout.checkoutAsync(100 + i));
+        }
+    }
+    cout << "Queued " << 3 * PER_PROVIDER << " payments without waiting" << endl;
+
+    for (int p = 0; p < 3; p++) {
+        int approved = 0, timedOut = 0, retried = 0;
+        for (future<PaymentResult>& result : results[p]) {
+            PaymentResult paid = result.get();
+            approved += paid.status == APPROVED;
+            timedOut += paid.status == TIMED_OUT;
+            retried += paid.attempts > 1;
+        }
+        PaymentLane& lane = pipeline.laneFor(gateways[p]);
+        cout << gateways[p]->getName() << ": " << approved << " approved, "
+             << timedOut << " timed out, " << retried << " retried, "
+             << lane.getRoundTrips() << " round-trips" << endl;
+    }
+
+    /*
+    -------- PROVIDERS THAT MISBEHAVE --------
+    One hangs far past the deadline (its pay() ignores any
+    timeout), one throws. The hung lane's futures still resolve
+    as TIMED_OUT at the 50 ms deadline; the throwing one's are
+    FAILED after their retries.
+    */
+    cout << "-------------------" << endl;
+    {
+        HangingPayment hanging(chrono::milliseconds(300));
+        ThrowingPayment throwing;
+        PaymentLaneConfig strict;
+        strict.maxInFlight = 1;
+        strict.deadline = chrono::milliseconds(50);
+        PaymentPipeline guarded(strict);
+
+        auto start = chrono::steady_clock::now();
+        future<PaymentResult> hung = guarded.submit(&hanging, 100);
+        future<PaymentResult> thrown = guarded.submit(&throwing, 100);
+        PaymentResult hungResult = hung.get();
+        auto waited = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        cout << "Hung provider: " << statusName(hungResult.status) << " after "
+             << waited.count() << " ms" << endl;
+        cout << "Throwing provider: " << statusName(thrown.get().status) << endl;
+    }
+
     return 0;
-}
\ No newline at end of file
+}
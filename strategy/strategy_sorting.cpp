@@ -1,5 +1,25 @@
 #include <iostream>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <cstdlib>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "../bench/LoadHarness.h"
+#include "../bench/AllocCounter.h"
+#include "../common/WorkStealingPool.h"
 using namespace std;
 
 /*
@@ -76,13 +96,521 @@ Purpose:
 /*
 Strategy Interface
 ------------------
+- sort() really sorts the array in place
+- name() is only for printing / benchmark tables
 */
 class SortStrategy {
 public:
     virtual void sort(vector<int>& arr) = 0;
+    virtual const char* name() const = 0;
     virtual ~SortStrategy() {}
 };
 
+/*
+-----------------------------------------------------
+SHARED BUILDING BLOCKS
+-----------------------------------------------------
+Small routines several strategies reuse.
+They work on raw [first, last) pointers so the
+quick sorts can call them on sub-ranges for free.
+All are templates over the element type and the
+comparator (default less<T>), so they serve both the
+vector<int> strategies and the generic layer in PART 4.
+None of them allocates: scratch space is passed in.
+*/
+namespace SortKernels {
+
+    // Plain insertion sort: shift each element left until it fits
+    template <class T, class Compare = less<T>>
+    inline void insertionSort(T* first, T* last, Compare comp = Compare()) {
+        if (first == last) return;
+        for (T* cur = first + 1; cur < last; cur++) {
+            T value = move(*cur);
+            T* hole = cur;
+            while (hole > first && comp(value, *(hole - 1))) {
+                *hole = move(*(hole - 1));
+                hole--;
+            }
+            *hole = move(value);
+        }
+    }
+
+    /*
+    Insertion sort that gives up after PARTIAL_LIMIT moves.
+    Returns true if the range ended up sorted.
+    Used by the introsort when a partition did no swaps:
+    the range is probably already sorted, so try the
+    cheap O(n) pass before partitioning again.
+    */
+    const int PARTIAL_LIMIT = 8;
+
+    template <class T, class Compare>
+    inline bool partialInsertionSort(T* first, T* last, Compare comp) {
+        if (first == last) return true;
+        int moved = 0;
+        for (T* cur = first + 1; cur < last; cur++) {
+            T value = move(*cur);
+            T* hole = cur;
+            while (hole > first && comp(value, *(hole - 1))) {
+                *hole = move(*(hole - 1));
+                hole--;
+            }
+            *hole = move(value);
+            moved += (int)(cur - hole);
+            if (moved > PARTIAL_LIMIT) return cur + 1 == last;
+        }
+        return true;
+    }
+
+    template <class T, class Compare>
+    inline void sort3(T* a, T* b, T* c, Compare comp) {
+        if (comp(*b, *a)) swap(*a, *b);
+        if (comp(*c, *b)) swap(*b, *c);
+        if (comp(*b, *a)) swap(*a, *b);
+    }
+
+    template <class T, class Compare>
+    inline void heapSort(T* first, T* last, Compare comp) {
+        make_heap(first, last, comp);
+        sort_heap(first, last, comp);
+    }
+
+    /*
+    Partition around *first.
+    Elements < pivot go left, elements >= pivot go right.
+    Needs *(last - 1) >= pivot as a sentinel (median-of-3 gives that).
+    Returns the final pivot position; alreadyPartitioned is
+    set when no element had to be swapped.
+    */
+    template <class T, class Compare>
+    inline T* partitionRight(T* first, T* last, bool& alreadyPartitioned, Compare comp) {
+        T pivot = move(*first);
+        T* lo = first;
+        T* hi = last;
+
+        while (comp(*++lo, pivot)) {}
+        if (lo - 1 == first) {
+            while (lo < hi && !comp(*--hi, pivot)) {}
+        } else {
+            while (!comp(*--hi, pivot)) {}
+        }
+
+        alreadyPartitioned = lo >= hi;
+        while (lo < hi) {
+            swap(*lo, *hi);
+            while (comp(*++lo, pivot)) {}
+            while (!comp(*--hi, pivot)) {}
+        }
+
+        T* pivotPos = lo - 1;
+        *first = move(*pivotPos);
+        *pivotPos = move(pivot);
+        return pivotPos;
+    }
+
+    /*
+    Partition around *first, equal elements go LEFT.
+    Only used when the element just before this range equals
+    the pivot: then everything <= pivot is == pivot and is
+    already in its final place. This is what makes inputs
+    with few distinct values run in linear time.
+    */
+    template <class T, class Compare>
+    inline T* partitionLeft(T* first, T* last, Compare comp) {
+        T pivot = move(*first);
+        T* lo = first;
+        T* hi = last;
+
+        while (comp(pivot, *--hi)) {}
+        if (hi + 1 == last) {
+            while (lo < hi && !comp(pivot, *++lo)) {}
+        } else {
+            while (!comp(pivot, *++lo)) {}
+        }
+
+        while (lo < hi) {
+            swap(*lo, *hi);
+            while (comp(pivot, *--hi)) {}
+            while (!comp(pivot, *++lo)) {}
+        }
+
+        T* pivotPos = hi;
+        *first = move(*pivotPos);
+        *pivotPos = move(pivot);
+        return pivotPos;
+    }
+
+    /*
+    Pattern-defeating introsort (the ideas behind pdqsort):
+    - median-of-3 pivot (ninther on big ranges)
+    - insertion sort below INSERTION_CUTOFF
+    - equal-to-predecessor pivot -> partitionLeft (few unique values)
+    - no swaps during partition -> try partialInsertionSort (sorted runs)
+    - too many unbalanced partitions -> heap sort (O(n log n) worst case)
+    - recurse on the left side, loop on the right (bounded stack)
+    */
+    const int INSERTION_CUTOFF = 24;
+    const int NINTHER_THRESHOLD = 128;
+
+    template <class T, class Compare = less<T>>
+    inline void introSort(T* first, T* last, int badAllowed, bool leftmost, Compare comp = Compare()) {
+        while (true) {
+            ptrdiff_t size = last - first;
+            if (size < INSERTION_CUTOFF) {
+                insertionSort(first, last, comp);
+                return;
+            }
+
+            ptrdiff_t half = size / 2;
+            if (size > NINTHER_THRESHOLD) {
+                sort3(first, first + half, last - 1, comp);
+                sort3(first + 1, first + (half - 1), last - 2, comp);
+                sort3(first + 2, first + (half + 1), last - 3, comp);
+                sort3(first + (half - 1), first + half, first + (half + 1), comp);
+                swap(*first, *(first + half));
+            } else {
+                sort3(first + half, first, last - 1, comp);
+            }
+
+            if (!leftmost && !comp(*(first - 1), *first)) {
+                first = partitionLeft(first, last, comp) + 1;
+                continue;
+            }
+
+            bool alreadyPartitioned = false;
+            T* pivotPos = partitionRight(first, last, alreadyPartitioned, comp);
+
+            ptrdiff_t leftSize = pivotPos - first;
+            ptrdiff_t rightSize = last - (pivotPos + 1);
+            bool unbalanced = leftSize < size / 8 || rightSize < size / 8;
+
+            if (unbalanced) {
+                if (--badAllowed == 0) {
+                    heapSort(first, last, comp);
+                    return;
+                }
+                // Break up whatever pattern caused the bad split
+                if (leftSize >= INSERTION_CUTOFF) {
+                    swap(*first, *(first + leftSize / 4));
+                    swap(*(pivotPos - 1), *(pivotPos - leftSize / 4));
+                }
+                if (rightSize >= INSERTION_CUTOFF) {
+                    swap(*(pivotPos + 1), *(pivotPos + 1 + rightSize / 4));
+                    swap(*(last - 1), *(last - rightSize / 4));
+                }
+            } else if (alreadyPartitioned &&
+                       partialInsertionSort(first, pivotPos, comp) &&
+                       partialInsertionSort(pivotPos + 1, last, comp)) {
+                return;
+            }
+
+            introSort(first, pivotPos, badAllowed, leftmost, comp);
+            first = pivotPos + 1;
+            leftmost = false;
+        }
+    }
+
+    inline int log2Floor(size_t n) {
+        int log = 0;
+        while (n >>= 1) log++;
+        return log;
+    }
+
+    /*
+    Radix keys: any integral or floating-point key is mapped to
+    an unsigned integer with the SAME order, so the LSD passes
+    can treat every key as plain bytes.
+    - signed: flip the sign bit (negatives first)
+    - float/double: flip the sign bit of positives, all bits of
+      negatives (IEEE order; NaNs end up at the ends)
+    */
+    template <class Key, class Enable = void>
+    struct OrderedBits;
+
+    template <class Key>
+    struct OrderedBits<Key, typename enable_if<is_integral<Key>::value>::type> {
+        typedef typename make_unsigned<Key>::type Bits;
+        static Bits get(Key key) {
+            Bits bits = (Bits)key;
+            if (is_signed<Key>::value) bits ^= (Bits)1 << (sizeof(Key) * 8 - 1);
+            return bits;
+        }
+    };
+
+    template <class Key>
+    struct OrderedBits<Key, typename enable_if<is_floating_point<Key>::value>::type> {
+        typedef typename conditional<sizeof(Key) == 4, uint32_t, uint64_t>::type Bits;
+        static Bits get(Key key) {
+            Bits bits;
+            memcpy(&bits, &key, sizeof(bits));
+            Bits sign = (Bits)1 << (sizeof(Key) * 8 - 1);
+            return (bits & sign) ? ~bits : bits ^ sign;
+        }
+    };
+
+    // Key of an element that IS its own key (vector<int> etc.)
+    struct IdentityKey {
+        template <class T>
+        const T& operator()(const T& value) const { return value; }
+    };
+
+    /*
+    LSD radix sort, one pass per key byte.
+    - All histograms are built in ONE read of the input
+    - Keys go through OrderedBits, so signed / float keys sort right
+    - A pass where every key has the same digit is skipped
+      (small-range data often needs only 1-2 passes)
+    - Stable, so sorting records by one field keeps the
+      previous order of equal keys
+    Ping-pongs between data and scratch (both n elements) and
+    returns whichever of the two holds the sorted result.
+    */
+    template <class T, class KeyOf = IdentityKey>
+    inline T* radixSortRange(T* data, T* scratch, size_t n, KeyOf keyOf = KeyOf()) {
+        typedef typename decay<decltype(keyOf(*data))>::type Key;
+        typedef OrderedBits<Key> Order;
+        const int PASSES = sizeof(Key);
+
+        if (n < 2) return data;
+
+        size_t counts[PASSES][256] = {};
+        for (size_t i = 0; i < n; i++) {
+            auto bits = Order::get(keyOf(data[i]));
+            for (int pass = 0; pass < PASSES; pass++) counts[pass][(bits >> (pass * 8)) & 0xFF]++;
+        }
+
+        T* src = data;
+        T* dst = scratch;
+
+        for (int pass = 0; pass < PASSES; pass++) {
+            size_t* count = counts[pass];
+            int shift = pass * 8;
+
+            size_t firstDigit = (Order::get(keyOf(src[0])) >> shift) & 0xFF;
+            if (count[firstDigit] == n) continue;
+
+            size_t offsets[256];
+            size_t sum = 0;
+            for (int d = 0; d < 256; d++) {
+                offsets[d] = sum;
+                sum += count[d];
+            }
+
+            for (size_t i = 0; i < n; i++) {
+                size_t digit = (Order::get(keyOf(src[i])) >> shift) & 0xFF;
+                dst[offsets[digit]++] = move(src[i]);
+            }
+            swap(src, dst);
+        }
+        return src;
+    }
+
+    inline void radixSort(vector<int>& arr) {
+        size_t n = arr.size();
+        if (n < 2) return;
+        vector<int> buffer(n);
+        int* result = radixSortRange(arr.data(), buffer.data(), n);
+        if (result != arr.data()) memcpy(arr.data(), result, n * sizeof(int));
+    }
+
+    /*
+    Branchless two-way merge of [a, aEnd) and [b, bEnd) into out.
+    The compare result moves the pointers instead of picking a
+    branch, so random data costs no mispredictions.
+    Each step depends on the previous one (load -> compare ->
+    pointer), so the merge runs from BOTH ends at once: two
+    independent chains, the smallest from the front and the
+    largest from the back. min(na, nb) steps per end can never
+    run off either input; the unbalanced middle is merged last.
+    Stable: on ties the front takes from a, the back from b.
+    */
+    template <class T, class Compare = less<T>>
+    inline void mergeRuns(const T* a, const T* aEnd, const T* b, const T* bEnd, T* out,
+                          Compare comp = Compare()) {
+        size_t both = min(aEnd - a, bEnd - b);
+        const T* aBack = aEnd - 1;
+        const T* bBack = bEnd - 1;
+        T* outBack = out + (aEnd - a) + (bEnd - b) - 1;
+
+        for (size_t k = 0; k < both; k++) {
+            bool takeB = comp(*b, *a);
+            *out++ = takeB ? *b : *a;
+            a += !takeB;
+            b += takeB;
+
+            bool takeA = comp(*bBack, *aBack);
+            *outBack-- = takeA ? *aBack : *bBack;
+            aBack -= takeA;
+            bBack -= !takeA;
+        }
+
+        aEnd = aBack + 1;
+        bEnd = bBack + 1;
+        while (a < aEnd && b < bEnd) {
+            bool takeB = comp(*b, *a);
+            *out++ = takeB ? *b : *a;
+            a += !takeB;
+            b += takeB;
+        }
+        out = copy(a, aEnd, out);
+        copy(b, bEnd, out);
+    }
+
+    /*
+    Merge path: how many of the first k outputs of merging
+    a[0..na) and b[0..nb) come from a. Lets one big merge be
+    cut into independent pieces (one per thread).
+    */
+    template <class T, class Compare = less<T>>
+    inline size_t mergeSplit(const T* a, size_t na, const T* b, size_t nb, size_t k,
+                             Compare comp = Compare()) {
+        size_t lo = k > nb ? k - nb : 0;
+        size_t hi = min(k, na);
+        while (lo < hi) {
+            size_t i = (lo + hi) / 2;
+            if (!comp(b[k - i - 1], a[i])) lo = i + 1;
+            else hi = i;
+        }
+        return lo;
+    }
+
+    // Outputs [k0, k1) of merging a and b, written to out + k0
+    template <class T, class Compare = less<T>>
+    inline void mergePiece(const T* a, size_t na, const T* b, size_t nb,
+                           size_t k0, size_t k1, T* out, Compare comp = Compare()) {
+        size_t i0 = mergeSplit(a, na, b, nb, k0, comp);
+        size_t i1 = mergeSplit(a, na, b, nb, k1, comp);
+        mergeRuns(a + i0, a + i1, b + (k0 - i0), b + (k1 - i1), out + k0, comp);
+    }
+
+    /*
+    Sorting network for the merge sort base case.
+    NETWORK_SIZE elements are sorted by a fixed list of
+    compare-exchanges (19 for 8 inputs): no branches, and with
+    AVX2 eight networks run at once, one per vector lane.
+    Written out with constant indices so r[] lives in registers.
+    */
+    const size_t NETWORK_SIZE = 8;
+    const size_t LEAF_SIZE = NETWORK_SIZE * NETWORK_SIZE;
+
+    template <class T, class CompareExchange>
+    inline void network8(T* r, CompareExchange ce) {
+        ce(r[0], r[2]); ce(r[1], r[3]); ce(r[4], r[6]); ce(r[5], r[7]);
+        ce(r[0], r[4]); ce(r[1], r[5]); ce(r[2], r[6]); ce(r[3], r[7]);
+        ce(r[0], r[1]); ce(r[2], r[3]); ce(r[4], r[5]); ce(r[6], r[7]);
+        ce(r[2], r[4]); ce(r[3], r[5]);
+        ce(r[1], r[4]); ce(r[3], r[6]);
+        ce(r[1], r[2]); ce(r[3], r[4]); ce(r[5], r[6]);
+    }
+
+    inline void sortNetwork8(int* v) {
+        int r[NETWORK_SIZE];
+        memcpy(r, v, sizeof(r));
+        network8(r, [](int& x, int& y) {
+            int lo = min(x, y);
+            y = max(x, y);
+            x = lo;
+        });
+        memcpy(v, r, sizeof(r));
+    }
+
+#ifdef __AVX2__
+    /*
+    64 elements as 8 registers x 8 lanes: one network over the
+    registers sorts every lane (column); an 8x8 transpose turns
+    the sorted columns back into 8 sorted runs in memory.
+    */
+    inline void sortNetwork64(int* v) {
+        __m256i r[8];
+        for (int i = 0; i < 8; i++) r[i] = _mm256_loadu_si256((const __m256i*)(v + 8 * i));
+
+        network8(r, [](__m256i& x, __m256i& y) {
+            __m256i lo = _mm256_min_epi32(x, y);
+            y = _mm256_max_epi32(x, y);
+            x = lo;
+        });
+
+        __m256i t[8], u[8];
+        for (int i = 0; i < 8; i += 2) {
+            t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+            t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+        }
+        for (int i = 0; i < 8; i += 4) {
+            u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+            u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+            u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+            u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+        }
+        for (int i = 0; i < 4; i++) {
+            r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+            r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+        }
+
+        for (int i = 0; i < 8; i++) _mm256_storeu_si256((__m256i*)(v + 8 * i), r[i]);
+    }
+#endif
+
+    /*
+    First step of a leaf: sort every NETWORK_SIZE block.
+    Any type / comparator: insertion sort per block (stable).
+    int with less<int> (the overload below): sorting networks.
+    */
+    template <class T, class Compare>
+    inline void sortLeafBlocks(T* v, size_t n, Compare comp) {
+        for (size_t i = 0; i < n; i += NETWORK_SIZE) insertionSort(v + i, v + min(i + NETWORK_SIZE, n), comp);
+    }
+
+    inline void sortLeafBlocks(int* v, size_t n, less<int>) {
+#ifdef __AVX2__
+        if (n == LEAF_SIZE) {
+            sortNetwork64(v);
+            return;
+        }
+#endif
+        size_t full = n - n % NETWORK_SIZE;
+        for (size_t i = 0; i < full; i += NETWORK_SIZE) sortNetwork8(v + i);
+        if (full < n) insertionSort(v + full, v + n);
+    }
+
+    // Sorts up to LEAF_SIZE elements: sorted blocks, then merges
+    // (tmp = caller's scratch for the same range)
+    template <class T, class Compare>
+    inline void sortLeaf(T* v, T* tmp, size_t n, Compare comp) {
+        sortLeafBlocks(v, n, comp);
+
+        T* src = v;
+        T* dst = tmp;
+        for (size_t width = NETWORK_SIZE; width < n; width *= 2) {
+            for (size_t lo = 0; lo < n; lo += 2 * width) {
+                size_t mid = min(lo + width, n), hi = min(lo + 2 * width, n);
+                mergeRuns(src + lo, src + mid, src + mid, src + hi, dst + lo, comp);
+            }
+            swap(src, dst);
+        }
+        if (src != v) copy(src, src + n, v);
+    }
+
+    /*
+    Top-down merge sort on data[0..n) with scratch b[0..n).
+    Result goes to b when intoScratch, else stays in data;
+    the two arrays swap roles per level so nothing is copied.
+    Splits on LEAF_SIZE multiples so every leaf but the last is full.
+    */
+    template <class T, class Compare = less<T>>
+    inline void mergeSortRange(T* data, T* b, size_t n, bool intoScratch, Compare comp = Compare()) {
+        if (n <= LEAF_SIZE) {
+            sortLeaf(data, b, n, comp);
+            if (intoScratch) copy(data, data + n, b);
+            return;
+        }
+        size_t half = max<size_t>(1, n / LEAF_SIZE / 2) * LEAF_SIZE;
+        mergeSortRange(data, b, half, !intoScratch, comp);
+        mergeSortRange(data + half, b + half, n - half, !intoScratch, comp);
+        if (intoScratch) mergeRuns(data, data + half, data + half, data + n, b, comp);
+        else mergeRuns(b, b + half, b + half, b + n, data, comp);
+    }
+}
+
 /*
 -----------------------------------------------------
 CONCRETE STRATEGIES
@@ -90,51 +618,459 @@ CONCRETE STRATEGIES
 */
 
 // Quick Sort (Normal)
+// Textbook randomized quicksort, Hoare partition.
+// Recurses on the smaller side so the stack stays O(log n).
 class NormalQuickSort : public SortStrategy {
+private:
+    mt19937 rng{12345};
+
+    void quickSort(int* first, int* last) {
+        while (last - first > 1) {
+            int pivot = first[rng() % (last - first)];
+            int* lo = first - 1;
+            int* hi = last;
+            while (true) {
+                do { lo++; } while (*lo < pivot);
+                do { hi--; } while (pivot < *hi);
+                if (lo >= hi) break;
+                swap(*lo, *hi);
+            }
+            int* split = hi + 1;
+            if (split - first < last - split) {
+                quickSort(first, split);
+                first = split;
+            } else {
+                quickSort(split, last);
+                last = split;
+            }
+        }
+    }
+
 public:
     void sort(vector<int>& arr) override {
-        cout << "This is Normal Quick Sort" << endl;
+        if (arr.size() > 1) quickSort(arr.data(), arr.data() + arr.size());
     }
+
+    const char* name() const override { return "Normal Quick Sort"; }
 };
 
 // Quick Sort (Advanced)
+// Pattern-defeating introsort, see SortKernels::introSort
 class AdvancedQuickSort : public SortStrategy {
 public:
     void sort(vector<int>& arr) override {
-        cout << "This is Advanced Quick Sort" << endl;
+        if (arr.size() < 2) return;
+        SortKernels::introSort(arr.data(), arr.data() + arr.size(),
+                               SortKernels::log2Floor(arr.size()), true);
     }
+
+    const char* name() const override { return "Advanced Quick Sort"; }
 };
 
 // Bubble Sort (Normal)
+// Every pass over the whole unsorted part, always n-1 passes
 class NormalBubbleSort : public SortStrategy {
 public:
     void sort(vector<int>& arr) override {
-        cout << "This is Normal Bubble Sort" << endl;
+        size_t n = arr.size();
+        for (size_t pass = 1; pass < n; pass++) {
+            for (size_t i = 0; i + pass < n; i++) {
+                if (arr[i + 1] < arr[i]) swap(arr[i], arr[i + 1]);
+            }
+        }
     }
+
+    const char* name() const override { return "Normal Bubble Sort"; }
 };
 
 // Bubble Sort (Advanced)
+// Everything after the last swap is already in place,
+// so the next pass stops there; no swap at all = done
 class AdvancedBubbleSort : public SortStrategy {
 public:
     void sort(vector<int>& arr) override {
-        cout << "This is Advanced Bubble Sort" << endl;
+        size_t bound = arr.size();
+        while (bound > 1) {
+            size_t lastSwap = 0;
+            for (size_t i = 1; i < bound; i++) {
+                if (arr[i] < arr[i - 1]) {
+                    swap(arr[i], arr[i - 1]);
+                    lastSwap = i;
+                }
+            }
+            bound = lastSwap;
+        }
     }
+
+    const char* name() const override { return "Advanced Bubble Sort"; }
 };
 
 // Insertion Sort (Normal)
 class NormalInsertionSort : public SortStrategy {
 public:
     void sort(vector<int>& arr) override {
-        cout << "This is Normal Insertion Sort" << endl;
+        if (arr.size() > 1) SortKernels::insertionSort(arr.data(), arr.data() + arr.size());
     }
+
+    const char* name() const override { return "Normal Insertion Sort"; }
 };
 
 // Insertion Sort (Advanced)
+// Binary search for the slot (O(log i) compares),
+// then one block move instead of element-by-element shifts
 class AdvancedInsertionSort : public SortStrategy {
 public:
     void sort(vector<int>& arr) override {
-        cout << "This is Advanced Insertion Sort" << endl;
+        for (size_t i = 1; i < arr.size(); i++) {
+            int value = arr[i];
+            if (!(value < arr[i - 1])) continue;
+            auto slot = upper_bound(arr.begin(), arr.begin() + i, value);
+            move_backward(slot, arr.begin() + i, arr.begin() + i + 1);
+            *slot = value;
+        }
+    }
+
+    const char* name() const override { return "Advanced Insertion Sort"; }
+};
+
+// Radix Sort
+// Non-comparison sort for int keys, see SortKernels::radixSort
+class RadixSort : public SortStrategy {
+public:
+    void sort(vector<int>& arr) override {
+        SortKernels::radixSort(arr);
+    }
+
+    const char* name() const override { return "Radix Sort"; }
+};
+
+/*
+-----------------------------------------------------
+PARALLEL STRATEGIES
+-----------------------------------------------------
+The parallel sorts fork and join on a WorkStealingPool
+(../common/WorkStealingPool.h), created once, not per sort.
+*/
+
+// Below this the fork/join overhead is bigger than the win
+const size_t PARALLEL_MIN_SIZE = 1 << 18;
+
+// Parallel Merge Sort
+// 1) cut into one part per thread, merge sort each part
+//    (SIMD network leaves, see SortKernels::sortLeaf)
+// 2) merge neighbouring parts pairwise, level by level;
+//    every merge is cut into merge-path pieces so all
+//    threads stay busy on the last levels too
+class ParallelMergeSort : public SortStrategy {
+private:
+    WorkStealingPool& pool;
+    vector<int> scratch;
+
+public:
+    explicit ParallelMergeSort(WorkStealingPool& pool) : pool(pool) {}
+
+    void sort(vector<int>& arr) override {
+        size_t n = arr.size();
+        if (n < 2) return;
+        if (scratch.size() < n) scratch.resize(n);
+        int* data = arr.data();
+        int* buf = scratch.data();
+
+        size_t parts = pool.size();
+        if (n < PARALLEL_MIN_SIZE || parts == 1) {
+            SortKernels::mergeSortRange(data, buf, n, false);
+            return;
+        }
+
+        vector<size_t> bounds(parts + 1);
+        for (size_t p = 0; p <= parts; p++) bounds[p] = n * p / parts;
+
+        TaskGroup group;
+        for (size_t p = 0; p < parts; p++) {
+            size_t lo = bounds[p], hi = bounds[p + 1];
+            pool.run(group, [=] { SortKernels::mergeSortRange(data + lo, buf + lo, hi - lo, false); });
+        }
+        pool.wait(group);
+
+        int* src = data;
+        int* dst = buf;
+        while (bounds.size() > 2) {
+            vector<size_t> next;
+            for (size_t r = 0; r + 1 < bounds.size(); r += 2) {
+                size_t lo = bounds[r], mid = bounds[r + 1];
+                size_t hi = r + 2 < bounds.size() ? bounds[r + 2] : mid;
+                next.push_back(lo);
+
+                if (hi == mid) {    // odd run out, carried to the next level
+                    pool.run(group, [=] { memcpy(dst + lo, src + lo, (mid - lo) * sizeof(int)); });
+                    continue;
+                }
+
+                size_t len = hi - lo;
+                size_t pieces = max<size_t>(1, len * parts / n);
+                for (size_t k = 0; k < pieces; k++) {
+                    size_t k0 = len * k / pieces, k1 = len * (k + 1) / pieces;
+                    pool.run(group, [=] {
+                        SortKernels::mergePiece(src + lo, mid - lo, src + mid, hi - mid, k0, k1, dst + lo);
+                    });
+                }
+            }
+            next.push_back(n);
+            pool.wait(group);
+            bounds.swap(next);
+            swap(src, dst);
+        }
+
+        if (src != data) {
+            for (size_t p = 0; p < parts; p++) {
+                size_t lo = n * p / parts, hi = n * (p + 1) / parts;
+                pool.run(group, [=] { memcpy(data + lo, src + lo, (hi - lo) * sizeof(int)); });
+            }
+            pool.wait(group);
+        }
     }
+
+    const char* name() const override { return "Parallel Merge Sort"; }
+};
+
+// Parallel Sample Sort
+// 1) a sorted random sample gives BUCKETS-1 splitters
+// 2) each thread classifies its part (branchless search
+//    over the splitters) and counts per bucket
+// 3) prefix sums give every (part, bucket) its output slot;
+//    each thread scatters its part into the scratch array
+// 4) buckets are independent: sorted in parallel (radix when
+//    big, introsort when small) and copied back
+// More buckets than threads, so stealing evens out skew.
+class ParallelSampleSort : public SortStrategy {
+private:
+    static const size_t OVERSAMPLE = 32;
+    static const size_t BUCKETS_PER_THREAD = 8;
+    static const size_t MAX_BUCKETS = 1024;
+    static const size_t RADIX_BUCKET_SIZE = 1 << 12;
+
+    WorkStealingPool& pool;
+    vector<int> scratch;
+    vector<uint16_t> bucketOf;
+    mt19937 rng{2024};
+
+    // Number of splitters < x (splitters sorted, count = buckets - 1)
+    static size_t bucketIndex(const int* splitters, size_t count, int x) {
+        const int* base = splitters;
+        size_t len = count;
+        while (len > 1) {
+            size_t half = len / 2;
+            base += base[half - 1] < x ? half : 0;
+            len -= half;
+        }
+        return (base - splitters) + (*base < x);
+    }
+
+    // Sorts src[0..len); the result must end up in dst (same size)
+    static void sortBucket(int* src, int* dst, size_t len) {
+        if (len >= RADIX_BUCKET_SIZE) {
+            int* result = SortKernels::radixSortRange(src, dst, len);
+            if (result != dst) memcpy(dst, result, len * sizeof(int));
+            return;
+        }
+        if (len > 1) {
+            SortKernels::introSort(src, src + len, SortKernels::log2Floor(len), true);
+        }
+        memcpy(dst, src, len * sizeof(int));
+    }
+
+public:
+    explicit ParallelSampleSort(WorkStealingPool& pool) : pool(pool) {}
+
+    void sort(vector<int>& arr) override {
+        size_t n = arr.size();
+        if (n < 2) return;
+        if (scratch.size() < n) scratch.resize(n);
+        int* data = arr.data();
+        int* buf = scratch.data();
+
+        size_t parts = pool.size();
+        if (n < PARALLEL_MIN_SIZE || parts == 1) {
+            int* result = SortKernels::radixSortRange(data, buf, n);
+            if (result != data) memcpy(data, result, n * sizeof(int));
+            return;
+        }
+
+        size_t buckets = 2;
+        while (buckets < parts * BUCKETS_PER_THREAD && buckets < MAX_BUCKETS) buckets *= 2;
+
+        vector<int> sample(buckets * OVERSAMPLE);
+        for (auto& x : sample) x = data[rng() % n];
+        std::sort(sample.begin(), sample.end());
+        vector<int> splitters(buckets - 1);
+        for (size_t b = 0; b + 1 < buckets; b++) splitters[b] = sample[(b + 1) * OVERSAMPLE];
+
+        if (bucketOf.size() < n) bucketOf.resize(n);
+        uint16_t* index = bucketOf.data();
+        const int* split = splitters.data();
+        vector<size_t> counts(parts * buckets, 0);
+        size_t* count = counts.data();
+
+        TaskGroup group;
+        for (size_t p = 0; p < parts; p++) {
+            size_t lo = n * p / parts, hi = n * (p + 1) / parts;
+            pool.run(group, [=] {
+                size_t* mine = count + p * buckets;
+                for (size_t i = lo; i < hi; i++) {
+                    size_t b = bucketIndex(split, buckets - 1, data[i]);
+                    index[i] = (uint16_t)b;
+                    mine[b]++;
+                }
+            });
+        }
+        pool.wait(group);
+
+        // Bucket-major layout: bucket b = parts' slices in part order
+        vector<size_t> bucketStart(buckets + 1);
+        vector<size_t> cursors(parts * buckets);
+        size_t sum = 0;
+        for (size_t b = 0; b < buckets; b++) {
+            bucketStart[b] = sum;
+            for (size_t p = 0; p < parts; p++) {
+                cursors[p * buckets + b] = sum;
+                sum += count[p * buckets + b];
+            }
+        }
+        bucketStart[buckets] = n;
+
+        size_t* cursor = cursors.data();
+        for (size_t p = 0; p < parts; p++) {
+            size_t lo = n * p / parts, hi = n * (p + 1) / parts;
+            pool.run(group, [=] {
+                size_t* mine = cursor + p * buckets;
+                for (size_t i = lo; i < hi; i++) buf[mine[index[i]]++] = data[i];
+            });
+        }
+        pool.wait(group);
+
+        for (size_t b = 0; b < buckets; b++) {
+            size_t lo = bucketStart[b], hi = bucketStart[b + 1];
+            if (lo == hi) continue;
+            pool.run(group, [=] { sortBucket(buf + lo, data + lo, hi - lo); });
+        }
+        pool.wait(group);
+    }
+
+    const char* name() const override { return "Parallel Sample Sort"; }
+};
+
+/*
+=====================================================
+PART 3: ADAPTIVE STRATEGY
+=====================================================
+
+Purpose:
+- Pick the algorithm from the data, not from the caller
+- Still just another SortStrategy: the context does not
+  know (or care) that it delegates
+
+Decision (one O(n) look at the input first):
+- already sorted             -> nothing to do
+- strictly descending        -> reverse
+- small (< SMALL_SIZE)       -> insertion sort
+- large and disordered       -> radix sort (linear, no compares)
+- everything else            -> advanced quick sort (introsort);
+                                nearly sorted / few unique inputs
+                                are handled well by it
+With a thread pool (setThreadPool), large inputs go parallel:
+- disordered                 -> parallel sample sort
+- long sorted runs           -> parallel merge sort, from 4 threads
+                                (below that the introsort's cheap
+                                pass over sorted runs is faster)
+*/
+class AdaptiveSort : public SortStrategy {
+private:
+    static const size_t SMALL_SIZE = 32;
+    static const size_t RADIX_MIN_SIZE = 1 << 16;
+    static const size_t MERGE_MIN_THREADS = 4;
+
+    NormalInsertionSort insertion;
+    AdvancedQuickSort quick;
+    RadixSort radix;
+    unique_ptr<ParallelSampleSort> parallelSample;
+    unique_ptr<ParallelMergeSort> parallelMerge;
+
+    size_t threads = 1;
+
+    const char* lastChoice = "none";
+
+public:
+    // nullptr (the default) = single-threaded choices only
+    void setThreadPool(WorkStealingPool* pool) {
+        threads = pool ? pool->size() : 1;
+        if (threads > 1) {
+            parallelSample = make_unique<ParallelSampleSort>(*pool);
+            parallelMerge = make_unique<ParallelMergeSort>(*pool);
+        } else {
+            parallelSample.reset();
+            parallelMerge.reset();
+        }
+    }
+
+    void sort(vector<int>& arr) override {
+        size_t n = arr.size();
+        if (n < 2) {
+            lastChoice = "none (already sorted)";
+            return;
+        }
+
+        if (n < SMALL_SIZE) {
+            lastChoice = insertion.name();
+            insertion.sort(arr);
+            return;
+        }
+
+        // Presortedness: count descents (a[i] < a[i-1]) and ascents
+        size_t descents = 0, ascents = 0;
+        for (size_t i = 1; i < n; i++) {
+            descents += arr[i] < arr[i - 1];
+            ascents += arr[i - 1] < arr[i];
+        }
+
+        if (descents == 0) {
+            lastChoice = "none (already sorted)";
+            return;
+        }
+        if (ascents == 0 && descents == n - 1) {
+            lastChoice = "reverse";
+            reverse(arr.begin(), arr.end());
+            return;
+        }
+
+        // Random data has ~n/2 descents; a handful means long sorted runs
+        bool disordered = descents > n / 8;
+
+        if (parallelSample && n >= PARALLEL_MIN_SIZE) {
+            if (disordered) {
+                lastChoice = parallelSample->name();
+                parallelSample->sort(arr);
+                return;
+            }
+            if (threads >= MERGE_MIN_THREADS) {
+                lastChoice = parallelMerge->name();
+                parallelMerge->sort(arr);
+                return;
+            }
+        }
+
+        if (n >= RADIX_MIN_SIZE && disordered) {
+            lastChoice = radix.name();
+            radix.sort(arr);
+            return;
+        }
+
+        lastChoice = quick.name();
+        quick.sort(arr);
+    }
+
+    const char* name() const override { return "Adaptive Sort"; }
+
+    const char* getLastChoice() const { return lastChoice; }
 };
 
 /*
@@ -142,31 +1078,635 @@ Context Class
 -------------
 - Single context
 - Runtime swapping of strategies
+- No strategy given -> chooses automatically (AdaptiveSort)
+- setThreadPool() lets the automatic choice go parallel
 */
 class SortContext {
 private:
+    AdaptiveSort automatic;
     SortStrategy* strategy;
 
 public:
+    SortContext() {
+        this->strategy = &automatic;
+    }
+
     SortContext(SortStrategy* strategy) {
-        this->strategy = strategy;
+        this->strategy = strategy ? strategy : &automatic;
     }
 
     void setStrategy(SortStrategy* strategy) {
-        this->strategy = strategy;
+        this->strategy = strategy ? strategy : &automatic;
+    }
+
+    void setThreadPool(WorkStealingPool* pool) {
+        automatic.setThreadPool(pool);
     }
 
     void execute(vector<int>& arr) {
         strategy->sort(arr);
     }
+
+    SortStrategy* getStrategy() const {
+        return strategy;
+    }
 };
 
+/*
+=====================================================
+PART 4: GENERIC STRATEGIES (ANY TYPE, NO ALLOCATION)
+=====================================================
+
+Purpose:
+- Sort records directly, no copying into ints and back
+- Element type and comparator are template parameters,
+  so the comparison is inlined into the algorithm
+- Strategies never allocate: an algorithm that needs
+  scratch space reports how much (scratchSize) and the
+  CALLER passes it in, once, for as many sorts as it likes
+- SortContext stays runtime-swappable: it holds a
+  SortStrategy<T, Compare>* and pays ONE virtual call
+  per sort, never one per comparison
+*/
+namespace Generic {
+
+    /*
+    Non-owning view of contiguous elements
+    (std::span is C++20; this tree is C++17)
+    */
+    template <class T>
+    class Span {
+    private:
+        T* first;
+        size_t count;
+
+    public:
+        Span() : first(nullptr), count(0) {}
+        Span(T* first, size_t count) : first(first), count(count) {}
+        Span(T* first, T* last) : first(first), count(last - first) {}
+        Span(vector<T>& v) : first(v.data()), count(v.size()) {}
+
+        T* data() const { return first; }
+        size_t size() const { return count; }
+        T* begin() const { return first; }
+        T* end() const { return first + count; }
+        T& operator[](size_t i) const { return first[i]; }
+
+        Span subspan(size_t offset, size_t length) const {
+            return Span(first + offset, length);
+        }
+    };
+
+    /*
+    Strategy Interface
+    ------------------
+    - sort(data, scratch): scratch holds at least scratchSize(n)
+      elements, its contents are garbage before and after
+    */
+    template <class T, class Compare = less<T>>
+    class SortStrategy {
+    public:
+        virtual void sort(Span<T> data, Span<T> scratch) const = 0;
+        virtual size_t scratchSize(size_t n) const = 0;
+        virtual const char* name() const = 0;
+        virtual ~SortStrategy() {}
+    };
+
+    /*
+    Keys
+    ----
+    KeyOf = callable element -> integral / floating key.
+    FieldKey picks a struct field through a member pointer
+    (no state, a plain load after inlining); KeyLess turns a
+    key into a comparator, so comparison sorts and RadixSort
+    on the same key share one SortStrategy<T, KeyLess<...>>
+    type and can be swapped on one context.
+    */
+    template <class T, class Key, Key T::*Field>
+    struct FieldKey {
+        const Key& operator()(const T& value) const { return value.*Field; }
+    };
+
+    template <class KeyOf>
+    struct KeyLess {
+        KeyOf keyOf;
+
+        template <class T>
+        bool operator()(const T& a, const T& b) const { return keyOf(a) < keyOf(b); }
+    };
+
+    /*
+    -----------------------------------------------------
+    CONCRETE STRATEGIES
+    -----------------------------------------------------
+    final: a call through the concrete type is devirtualized
+    */
+
+    // Insertion Sort: stable, no scratch, for tiny / nearly sorted ranges
+    template <class T, class Compare = less<T>>
+    class InsertionSort final : public SortStrategy<T, Compare> {
+    private:
+        Compare comp;
+
+    public:
+        explicit InsertionSort(Compare comp = Compare()) : comp(comp) {}
+
+        void sort(Span<T> data, Span<T>) const override {
+            SortKernels::insertionSort(data.begin(), data.end(), comp);
+        }
+
+        size_t scratchSize(size_t) const override { return 0; }
+        const char* name() const override { return "Insertion Sort"; }
+    };
+
+    // Introsort (pattern-defeating): not stable, in place, no scratch
+    template <class T, class Compare = less<T>>
+    class IntroSort final : public SortStrategy<T, Compare> {
+    private:
+        Compare comp;
+
+    public:
+        explicit IntroSort(Compare comp = Compare()) : comp(comp) {}
+
+        void sort(Span<T> data, Span<T>) const override {
+            if (data.size() < 2) return;
+            SortKernels::introSort(data.begin(), data.end(),
+                                   SortKernels::log2Floor(data.size()), true, comp);
+        }
+
+        size_t scratchSize(size_t) const override { return 0; }
+        const char* name() const override { return "Intro Sort"; }
+    };
+
+    // Merge Sort: stable, n elements of scratch
+    template <class T, class Compare = less<T>>
+    class MergeSort final : public SortStrategy<T, Compare> {
+    private:
+        Compare comp;
+
+    public:
+        explicit MergeSort(Compare comp = Compare()) : comp(comp) {}
+
+        void sort(Span<T> data, Span<T> scratch) const override {
+            if (data.size() < 2) return;
+            SortKernels::mergeSortRange(data.data(), scratch.data(), data.size(), false, comp);
+        }
+
+        size_t scratchSize(size_t n) const override { return n; }
+        const char* name() const override { return "Merge Sort"; }
+    };
+
+    // Radix Sort: stable, by an integral / floating key, n elements of scratch
+    template <class T, class KeyOf>
+    class RadixSort final : public SortStrategy<T, KeyLess<KeyOf>> {
+    private:
+        KeyOf keyOf;
+
+    public:
+        explicit RadixSort(KeyOf keyOf = KeyOf()) : keyOf(keyOf) {}
+
+        void sort(Span<T> data, Span<T> scratch) const override {
+            if (data.size() < 2) return;
+            T* result = SortKernels::radixSortRange(data.data(), scratch.data(), data.size(), keyOf);
+            if (result != data.data()) move(result, result + data.size(), data.data());
+        }
+
+        size_t scratchSize(size_t n) const override { return n; }
+        const char* name() const override { return "Radix Sort"; }
+    };
+
+    /*
+    Context Class
+    -------------
+    - Runtime swapping of strategies, as in PART 2
+    - Owns nothing: strategy and scratch belong to the caller
+    - execute() returns false (and leaves data alone) when the
+      scratch is too small for the chosen strategy
+    */
+    template <class T, class Compare = less<T>>
+    class SortContext {
+    private:
+        const SortStrategy<T, Compare>* strategy;
+        Span<T> scratch;
+
+    public:
+        SortContext(const SortStrategy<T, Compare>* strategy, Span<T> scratch = Span<T>()) {
+            this->strategy = strategy;
+            this->scratch = scratch;
+        }
+
+        void setStrategy(const SortStrategy<T, Compare>* strategy) {
+            this->strategy = strategy;
+        }
+
+        void setScratch(Span<T> scratch) {
+            this->scratch = scratch;
+        }
+
+        bool execute(Span<T> data) {
+            if (scratch.size() < strategy->scratchSize(data.size())) return false;
+            strategy->sort(data, scratch);
+            return true;
+        }
+
+        // Contiguous iterators (vector, array, raw pointers)
+        template <class Iterator>
+        bool execute(Iterator first, Iterator last) {
+            return execute(Span<T>(&*first, (size_t)(last - first)));
+        }
+
+        const SortStrategy<T, Compare>* getStrategy() const {
+            return strategy;
+        }
+    };
+
+    /*
+    The PART 2 context on top of this layer: any
+    SortStrategy<int> runs behind ::SortContext (inside this
+    class the name SortStrategy means the ::SortStrategy base). Scratch
+    grows once to the largest input, then is reused.
+    */
+    class IntStrategyAdapter : public ::SortStrategy {
+    private:
+        const Generic::SortStrategy<int>& strategy;
+        vector<int> scratch;
+
+    public:
+        explicit IntStrategyAdapter(const Generic::SortStrategy<int>& strategy) : strategy(strategy) {}
+
+        void sort(vector<int>& arr) override {
+            size_t need = strategy.scratchSize(arr.size());
+            if (scratch.size() < need) scratch.resize(need);
+            strategy.sort(Span<int>(arr), Span<int>(scratch));
+        }
+
+        const char* name() const override { return strategy.name(); }
+    };
+}
+
+/*
+=====================================================
+BENCHMARK
+=====================================================
+RUN:
+- ./sorting          -> demo
+- ./sorting --bench  -> ns per element for every strategy
+                        (and std::sort) over the usual inputs:
+                        random, sorted, reversed, nearly sorted,
+                        few unique, organ pipe, sawtooth
+- ./sorting --bench-parallel [n]
+                     -> elements/sec vs thread count for the
+                        parallel strategies (n defaults to 100M)
+- ./sorting --load   -> JSON lines (throughput, p50/p99/p999) for
+                        N clients sorting small requests
+                        (flags: bench/LoadHarness.h)
+- g++ -O2 -mavx2 (or -march=native) -> AVX2 network leaves
+
+--bench also sorts 1M records (struct Trade) by field with the
+PART 4 strategies and counts heap allocations per sort.
+
+The bubble / insertion sorts are O(n^2), so they get
+their own small table instead of the big one.
+Every result is checked against std::sort.
+*/
+struct Distribution {
+    const char* name;
+    function<vector<int>(size_t, mt19937&)> make;
+};
+
+vector<Distribution> benchmarkDistributions() {
+    return {
+        {"random", [](size_t n, mt19937& rng) {
+            vector<int> v(n);
+            for (auto& x : v) x = (int)rng();
+            return v;
+        }},
+        {"sorted", [](size_t n, mt19937&) {
+            vector<int> v(n);
+            for (size_t i = 0; i < n; i++) v[i] = (int)i;
+            return v;
+        }},
+        {"reversed", [](size_t n, mt19937&) {
+            vector<int> v(n);
+            for (size_t i = 0; i < n; i++) v[i] = (int)(n - i);
+            return v;
+        }},
+        {"nearly sorted", [](size_t n, mt19937& rng) {
+            vector<int> v(n);
+            for (size_t i = 0; i < n; i++) v[i] = (int)i;
+            for (size_t k = 0; k < n / 100; k++) swap(v[rng() % n], v[rng() % n]);
+            return v;
+        }},
+        {"few unique", [](size_t n, mt19937& rng) {
+            vector<int> v(n);
+            for (auto& x : v) x = (int)(rng() % 16);
+            return v;
+        }},
+        {"organ pipe", [](size_t n, mt19937&) {
+            vector<int> v(n);
+            for (size_t i = 0; i < n; i++) v[i] = (int)min(i, n - i);
+            return v;
+        }},
+        {"sawtooth", [](size_t n, mt19937&) {
+            vector<int> v(n);
+            for (size_t i = 0; i < n; i++) v[i] = (int)(i % 1000);
+            return v;
+        }},
+    };
+}
+
+// std::sort wrapped as a strategy, the baseline column
+class StdSort : public SortStrategy {
+public:
+    void sort(vector<int>& arr) override { std::sort(arr.begin(), arr.end()); }
+    const char* name() const override { return "std::sort"; }
+};
+
+void runSortBenchmark(const vector<SortStrategy*>& strategies, size_t n, int reps) {
+    mt19937 rng(42);
+
+    cout << "n = " << n << ", ns per element (best of " << reps << ")\n";
+    cout << "distribution";
+    for (auto* s : strategies) cout << "\t" << s->name();
+    cout << "\n";
+
+    for (auto& dist : benchmarkDistributions()) {
+        vector<int> input = dist.make(n, rng);
+        vector<int> expected = input;
+        std::sort(expected.begin(), expected.end());
+
+        cout << dist.name;
+        for (auto* s : strategies) {
+            double best = 1e300;
+            for (int r = 0; r < reps; r++) {
+                vector<int> work = input;
+                auto start = chrono::steady_clock::now();
+                s->sort(work);
+                double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+                best = min(best, ns);
+                if (work != expected) {
+                    cerr << "FATAL: " << s->name() << " mis-sorted " << dist.name << endl;
+                    abort();
+                }
+            }
+            cout << "\t" << best / n;
+        }
+        cout << "\n";
+    }
+}
+
+/*
+Records: the generic layer vs std::sort / std::stable_sort
+on 1M Trades (24 bytes), by a double and by a uint32 field.
+"allocs" = heap allocations during ONE sort, counted by
+bench/AllocCounter.h; the Generic strategies get their scratch
+once, up front.
+*/
+struct Trade {
+    double price;
+    int64_t timestamp;
+    uint32_t quantity;
+    uint32_t account;
+};
+
+typedef Generic::FieldKey<Trade, double, &Trade::price> TradePrice;
+typedef Generic::FieldKey<Trade, uint32_t, &Trade::account> TradeAccount;
+typedef Generic::KeyLess<TradePrice> ByPrice;
+typedef Generic::KeyLess<TradeAccount> ByAccount;
+
+vector<Trade> makeTrades(size_t n, mt19937& rng) {
+    vector<Trade> trades(n);
+    for (size_t i = 0; i < n; i++) {
+        trades[i].price = (double)(rng() % 1000000) / 100.0 - 2000.0;
+        trades[i].timestamp = (int64_t)i;
+        trades[i].quantity = rng() % 1000;
+        trades[i].account = rng() % 50000;
+    }
+    return trades;
+}
+
+template <class Compare>
+void runRecordSortRow(const char* key, const vector<Trade>& input, Compare comp,
+                      Generic::SortStrategy<Trade, Compare>& intro,
+                      Generic::SortStrategy<Trade, Compare>& merge,
+                      Generic::SortStrategy<Trade, Compare>& radix) {
+    const int REPS = 3;
+    vector<Trade> work = input;
+    vector<Trade> expected = input;
+    std::stable_sort(expected.begin(), expected.end(), comp);
+    vector<Trade> scratch(input.size());
+
+    auto sameOrder = [&](bool stableOnly) {
+        for (size_t i = 0; i < work.size(); i++) {
+            if (stableOnly ? work[i].timestamp != expected[i].timestamp
+                           : comp(work[i], expected[i]) || comp(expected[i], work[i])) return false;
+        }
+        return true;
+    };
+
+    cout << key;
+    for (int which = 0; which < 5; which++) {
+        double best = 1e300;
+        size_t allocs = 0;
+        for (int r = 0; r < REPS; r++) {
+            work = input;
+            Generic::SortContext<Trade, Compare> context(which == 2 ? &intro : which == 3 ? &merge : &radix,
+                                                         Generic::Span<Trade>(scratch));
+            size_t before = AllocCounter::count();
+            auto start = chrono::steady_clock::now();
+            if (which == 0) std::sort(work.begin(), work.end(), comp);
+            else if (which == 1) std::stable_sort(work.begin(), work.end(), comp);
+            else context.execute(work.begin(), work.end());
+            double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            allocs = AllocCounter::count() - before;
+            best = min(best, ns);
+
+            bool stable = which == 1 || which >= 3;
+            if (!sameOrder(stable)) {
+                cerr << "FATAL: record sort " << which << " mis-sorted by " << key << endl;
+                abort();
+            }
+        }
+        cout << "\t" << best / input.size() << " (" << allocs << ")";
+    }
+    cout << "\n";
+}
+
+void runRecordSortBenchmark() {
+    mt19937 rng(5);
+    vector<Trade> trades = makeTrades(1000000, rng);
+
+    Generic::IntroSort<Trade, ByPrice> introPrice;
+    Generic::MergeSort<Trade, ByPrice> mergePrice;
+    Generic::RadixSort<Trade, TradePrice> radixPrice;
+    Generic::IntroSort<Trade, ByAccount> introAccount;
+    Generic::MergeSort<Trade, ByAccount> mergeAccount;
+    Generic::RadixSort<Trade, TradeAccount> radixAccount;
+
+    cout << "\n=== Records: 1000000 Trades, ns per element (allocs per sort) ===\n";
+    cout << "key\tstd::sort\tstd::stable_sort\tIntro Sort\tMerge Sort\tRadix Sort\n";
+    runRecordSortRow("price (double)", trades, ByPrice(), introPrice, mergePrice, radixPrice);
+    runRecordSortRow("account (uint32)", trades, ByAccount(), introAccount, mergeAccount, radixAccount);
+}
+
+void runSortBenchmarks() {
+    StdSort stdSort;
+    NormalQuickSort normalQuick;
+    AdvancedQuickSort advancedQuick;
+    RadixSort radix;
+    AdaptiveSort adaptive;
+    NormalBubbleSort normalBubble;
+    AdvancedBubbleSort advancedBubble;
+    NormalInsertionSort normalInsertion;
+    AdvancedInsertionSort advancedInsertion;
+
+    cout.precision(3);
+    cout << fixed;
+
+    cout << "=== O(n log n) / linear strategies ===\n";
+    runSortBenchmark({&stdSort, &normalQuick, &advancedQuick, &radix, &adaptive}, 1000000, 3);
+
+    cout << "\n=== Small arrays (insertion territory) ===\n";
+    runSortBenchmark({&stdSort, &normalQuick, &advancedQuick, &normalInsertion, &adaptive}, 24, 2000);
+
+    cout << "\n=== O(n^2) strategies ===\n";
+    runSortBenchmark({&stdSort, &normalBubble, &advancedBubble, &normalInsertion,
+                      &advancedInsertion, &adaptive}, 4000, 3);
+
+    // What AdaptiveSort picked per distribution at the big size
+    cout << "\n=== AdaptiveSort decisions (n = 1000000) ===\n";
+    mt19937 rng(7);
+    for (auto& dist : benchmarkDistributions()) {
+        vector<int> input = dist.make(1000000, rng);
+        adaptive.sort(input);
+        cout << dist.name << "\t-> " << adaptive.getLastChoice() << "\n";
+    }
+
+    // Parallel strategies: at least 2 threads so the parallel path runs
+    size_t threads = max<size_t>(2, thread::hardware_concurrency());
+    WorkStealingPool pool(threads);
+    ParallelMergeSort parallelMerge(pool);
+    ParallelSampleSort parallelSample(pool);
+    AdaptiveSort parallelAdaptive;
+    parallelAdaptive.setThreadPool(&pool);
+
+    cout << "\n=== Parallel strategies, " << threads << " threads ===\n";
+    runSortBenchmark({&stdSort, &radix, &parallelMerge, &parallelSample, &parallelAdaptive}, 4000000, 3);
+
+    runRecordSortBenchmark();
+}
+
+/*
+Scaling: million elements per second vs. thread count,
+one fixed random input of n ints (default 100M, about
+1.2 GB with scratch space; pass a smaller n if needed).
+Thread counts: powers of two up to the core count (at
+least 4, so the table has rows on small machines too).
+*/
+void runParallelScalingBenchmark(size_t n) {
+    mt19937 rng(99);
+    vector<int> input(n);
+    for (auto& x : input) x = (int)rng();
+    vector<int> work;
+
+    size_t cores = max<size_t>(1, thread::hardware_concurrency());
+    vector<size_t> counts;
+    for (size_t t = 1; t <= max<size_t>(4, cores); t *= 2) counts.push_back(t);
+    if (counts.back() != cores && cores > 4) counts.push_back(cores);
+
+    cout.precision(1);
+    cout << fixed;
+    cout << "n = " << n << ", " << cores << " cores, M elements/sec\n";
+    cout << "threads\tParallel Merge Sort\tParallel Sample Sort\tSortContext (auto)\n";
+
+    for (size_t t : counts) {
+        WorkStealingPool pool(t);
+        ParallelMergeSort parallelMerge(pool);
+        ParallelSampleSort parallelSample(pool);
+        SortContext context;
+        context.setThreadPool(&pool);
+
+        cout << t << (t > cores ? " (oversubscribed)" : "");
+        for (int which = 0; which < 3; which++) {
+            work = input;
+            auto start = chrono::steady_clock::now();
+            if (which == 0) parallelMerge.sort(work);
+            else if (which == 1) parallelSample.sort(work);
+            else context.execute(work);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (!is_sorted(work.begin(), work.end())) {
+                cerr << "FATAL: parallel sort mis-sorted at " << t << " threads" << endl;
+                abort();
+            }
+            cout << "\t" << n / seconds / 1e6;
+        }
+        cout << "\n";
+    }
+}
+
+/*
+Load suite: N client threads, each with its own SortContext
+(automatic choice, no pool) sorting a fresh copy of a random
+input per op; the copy is part of the op. One JSON line per
+case and client count (see bench/LoadHarness.h).
+- sort_64:  tiny requests, insertion territory
+- sort_4k:  typical request size
+- sort_64k: large enough for radix to win
+*/
+void runLoadSuite(const LoadHarness::Options& options) {
+    LoadHarness::Reporter report("sorting", options);
+
+    for (size_t n : {(size_t)64, (size_t)4096, (size_t)65536}) {
+        string name = "sort_" + (n >= 1024 ? to_string(n / 1024) + "k" : to_string(n));
+        if (!options.wants(name.c_str()))
+            continue;
+
+        for (int clients : options.threads) {
+            struct Client {
+                vector<int> input, work;
+                SortContext context;
+            };
+            vector<unique_ptr<Client>> state;
+            mt19937 rng(42);
+            for (int c = 0; c < clients; c++) {
+                state.emplace_back(new Client());
+                state.back()->input.resize(n);
+                for (auto& x : state.back()->input) x = (int)rng();
+            }
+
+            report.emit(LoadHarness::runLoad(name.c_str(), clients, options.seconds,
+                [&](int c, uint64_t) {
+                    Client& client = *state[c];
+                    client.work = client.input;
+                    client.context.execute(client.work);
+                }));
+        }
+    }
+}
+
+void printArray(const vector<int>& arr) {
+    for (size_t i = 0; i < arr.size(); i++) cout << (i ? " " : "") << arr[i];
+}
+
 /*
 =====================================================
 MAIN FUNCTION
 =====================================================
 */
-int main() {
+int main(int argc, char* argv[]) {
+
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runSortBenchmarks();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-parallel") {
+        runParallelScalingBenchmark(argc > 2 ? stoull(argv[2]) : 100000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--load") {
+        runLoadSuite(LoadHarness::Options::parse(argc, argv));
+        return 0;
+    }
 
     /*
     -------- BASIC STRATEGY DEMO --------
@@ -184,19 +1724,127 @@ int main() {
     /*
     -------- FINAL STRATEGY DEMO --------
     */
-    vector<int> arr = {5, 4, 2, 3};
+    const vector<int> input = {5, 4, 2, 3};
 
     SortContext sorter(new NormalQuickSort());
+    vector<int> arr = input;
     sorter.execute(arr);
+    cout << "This is " << sorter.getStrategy()->name() << " : ";
+    printArray(arr);
+    cout << endl;
 
     sorter.setStrategy(new AdvancedQuickSort());
+    arr = input;
     sorter.execute(arr);
+    cout << "This is " << sorter.getStrategy()->name() << " : ";
+    printArray(arr);
+    cout << endl;
 
     sorter.setStrategy(new NormalBubbleSort());
+    arr = input;
     sorter.execute(arr);
+    cout << "This is " << sorter.getStrategy()->name() << " : ";
+    printArray(arr);
+    cout << endl;
 
     sorter.setStrategy(new AdvancedInsertionSort());
+    arr = input;
+    sorter.execute(arr);
+    cout << "This is " << sorter.getStrategy()->name() << " : ";
+    printArray(arr);
+    cout << endl;
+
+    cout << "-------------------" << endl;
+
+    /*
+    -------- AUTOMATIC SELECTION DEMO --------
+    AdaptiveSort picks per input (a SortContext built
+    without a strategy uses one of these internally)
+    */
+    AdaptiveSort* adaptive = new AdaptiveSort();
+    SortContext autoSorter(adaptive);
+
+    vector<vector<int>> samples = {
+        {5, 4, 2, 3},
+        [] { vector<int> v(100); for (int i = 0; i < 100; i++) v[i] = i; return v; }(),
+        [] { vector<int> v(100); for (int i = 0; i < 100; i++) v[i] = 100 - i; return v; }(),
+        [] { vector<int> v(1000); mt19937 rng(1); for (auto& x : v) x = rng() % 1000; return v; }(),
+        [] { vector<int> v(100000); mt19937 rng(2); for (auto& x : v) x = (int)rng(); return v; }(),
+    };
+
+    for (auto& sample : samples) {
+        autoSorter.execute(sample);
+        cout << "Auto (" << sample.size() << " elements) -> " << adaptive->getLastChoice()
+             << (is_sorted(sample.begin(), sample.end()) ? "" : "  [NOT SORTED]") << endl;
+    }
+
+    cout << "-------------------" << endl;
+
+    /*
+    -------- PARALLEL DEMO --------
+    Same context, now allowed to use a thread pool
+    */
+    WorkStealingPool* pool = new WorkStealingPool(max<size_t>(2, thread::hardware_concurrency()));
+    adaptive->setThreadPool(pool);
+
+    vector<int> big(1 << 20);
+    mt19937 rng(3);
+    for (auto& x : big) x = (int)rng();
+    autoSorter.execute(big);
+    cout << "Auto (" << big.size() << " elements, " << pool->size() << " threads) -> "
+         << adaptive->getLastChoice()
+         << (is_sorted(big.begin(), big.end()) ? "" : "  [NOT SORTED]") << endl;
+
+    sorter.setStrategy(new ParallelMergeSort(*pool));
+    for (auto& x : big) x = (int)rng();
+    sorter.execute(big);
+    cout << "This is " << sorter.getStrategy()->name() << " : " << big.size() << " elements"
+         << (is_sorted(big.begin(), big.end()) ? " sorted" : "  [NOT SORTED]") << endl;
+
+    cout << "-------------------" << endl;
+
+    /*
+    -------- GENERIC STRATEGY DEMO --------
+    Records sorted in place by a field; the caller owns the
+    scratch, strategies with the same comparator type swap
+    on one context
+    */
+    const vector<Trade> tradeInput = {
+        {101.5, 1, 10, 7}, {99.0, 2, 20, 3}, {101.5, 3, 30, 9}, {-4.25, 4, 40, 3}, {99.0, 5, 50, 1},
+    };
+    vector<Trade> trades;
+    vector<Trade> tradeScratch(tradeInput.size());
+
+    Generic::IntroSort<Trade, ByPrice> introByPrice;
+    Generic::RadixSort<Trade, TradePrice> radixByPrice;
+    Generic::SortContext<Trade, ByPrice> tradeSorter(&introByPrice);
+
+    auto sortTrades = [&](const char* label) {
+        trades = tradeInput;
+        cout << label << " :";
+        if (!tradeSorter.execute(trades.begin(), trades.end())) {
+            cout << " refused, scratch too small" << endl;
+            return;
+        }
+        for (auto& t : trades) cout << " " << t.price << "#" << t.timestamp;
+        cout << endl;
+    };
+
+    sortTrades("Trades by price, Intro Sort (no scratch)");
+
+    tradeSorter.setStrategy(&radixByPrice);
+    sortTrades("Trades by price, Radix Sort (no scratch)");
+
+    tradeSorter.setScratch(Generic::Span<Trade>(tradeScratch));
+    sortTrades("Trades by price, Radix Sort (stable)   ");
+
+    Generic::MergeSort<int> genericMerge;
+    sorter.setStrategy(new Generic::IntStrategyAdapter(genericMerge));
+    arr = input;
     sorter.execute(arr);
+    cout << "This is Generic " << sorter.getStrategy()->name() << " : ";
+    printArray(arr);
+    cout << endl;
 
     return 0;
-}
\ No newline at end of file
+}